@@ -0,0 +1,214 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arena.h"
+
+/** Alignment of every allocation. */
+#define ARENA_ALIGN 16
+/** Smallest chunk allocated by an arena. */
+#define ARENA_MIN_CHUNK 1024
+
+#define ARENA_ROUND(x) (((x) + (ARENA_ALIGN - 1)) & ~((size_t)ARENA_ALIGN - 1))
+
+struct st_arena_chunk {
+	struct st_arena_chunk *next;
+	size_t size;
+	size_t used;
+};
+
+struct st_arena_cleanup {
+	struct st_arena_cleanup *next;
+	void (*fn)(void *);
+	void *arg;
+};
+
+struct st_arena {
+	/** The chunk being allocated from, followed by the full ones. */
+	struct st_arena_chunk *chunks;
+	/** The cleanup functions, the last registered first. */
+	struct st_arena_cleanup *cleanups;
+	/** Size of the next chunk to be allocated. */
+	size_t next_size;
+};
+
+static struct st_arena_chunk *
+arena_chunk_new(size_t size)
+{
+	struct st_arena_chunk *c;
+
+	c = malloc(ARENA_ROUND(sizeof(struct st_arena_chunk)) + size);
+	if (c == NULL)
+		return NULL;
+
+	c->next = NULL;
+	c->size = size;
+	c->used = 0;
+
+	return c;
+}
+
+struct st_arena *
+arena_new(size_t hint)
+{
+	struct st_arena *a;
+
+	a = malloc(sizeof(struct st_arena));
+	if (a == NULL)
+		return NULL;
+
+	hint = ARENA_ROUND(hint < ARENA_MIN_CHUNK ? ARENA_MIN_CHUNK : hint);
+	a->chunks = arena_chunk_new(hint);
+	if (a->chunks == NULL) {
+		free(a);
+		return NULL;
+	}
+	a->next_size = hint * 2;
+	a->cleanups = NULL;
+
+	return a;
+}
+
+void *
+arena_alloc(struct st_arena *a, size_t size)
+{
+	struct st_arena_chunk *c;
+	size_t csize;
+
+	assert(a != NULL);
+
+	size = ARENA_ROUND(size);
+
+	c = a->chunks;
+	if (c->size - c->used < size) {
+		/* Chunks grow geometrically, so the number of chunks stays
+		 * logarithmic in the arena size. */
+		csize = a->next_size;
+		while (csize < size)
+			csize *= 2;
+
+		c = arena_chunk_new(csize);
+		if (c == NULL)
+			return NULL;
+		c->next = a->chunks;
+		a->chunks = c;
+		a->next_size = csize * 2;
+	}
+
+	c->used += size;
+
+	return (char *)c + ARENA_ROUND(sizeof(struct st_arena_chunk)) +
+	    c->used - size;
+}
+
+char *
+arena_strdup(struct st_arena *a, const char *s)
+{
+	size_t len;
+	char *d;
+
+	len = strlen(s) + 1;
+	d = arena_alloc(a, len);
+	if (d != NULL)
+		memcpy(d, s, len);
+
+	return d;
+}
+
+int
+arena_cleanup(struct st_arena *a, void (*fn)(void *), void *arg)
+{
+	struct st_arena_cleanup *cl;
+
+	assert(a != NULL);
+	assert(fn != NULL);
+
+	cl = arena_alloc(a, sizeof(struct st_arena_cleanup));
+	if (cl == NULL)
+		return -1;
+
+	cl->fn = fn;
+	cl->arg = arg;
+	cl->next = a->cleanups;
+	a->cleanups = cl;
+
+	return 0;
+}
+
+static void
+arena_run_cleanups(struct st_arena *a)
+{
+	struct st_arena_cleanup *cl;
+
+	/* The cleanup nodes live in the arena: they are unlinked first. */
+	while ((cl = a->cleanups) != NULL) {
+		a->cleanups = cl->next;
+		cl->fn(cl->arg);
+	}
+}
+
+void
+arena_reset(struct st_arena *a)
+{
+	struct st_arena_chunk *c;
+
+	assert(a != NULL);
+
+	arena_run_cleanups(a);
+
+	/* The newest chunk is the largest one: it is the only one kept. */
+	while (a->chunks->next != NULL) {
+		c = a->chunks->next;
+		a->chunks->next = c->next;
+		free(c);
+	}
+	a->chunks->used = 0;
+}
+
+void
+arena_destroy(struct st_arena *a)
+{
+	struct st_arena_chunk *c;
+
+	if (a == NULL)
+		return;
+
+	arena_run_cleanups(a);
+
+	while (a->chunks != NULL) {
+		c = a->chunks;
+		a->chunks = c->next;
+		free(c);
+	}
+	free(a);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_ARENA_H_)
+#define _ARENA_H_
+
+#include <stddef.h>
+
+/**
+ * Bump pointer allocator. Memory allocated from an arena is never freed on
+ * its own: it is all released at once by arena_destroy().
+ *
+ * Arenas are not thread safe.
+ */
+struct st_arena;
+
+/**
+ * Creates an arena.
+ *
+ * @param hint The expected number of bytes to be allocated from it. The arena
+ * grows beyond it if needed.
+ *
+ * @return The arena or NULL if there is no memory.
+ */
+struct st_arena *arena_new(size_t hint);
+
+/**
+ * Allocates "size" bytes, aligned for any type, from an arena.
+ *
+ * @return The memory or NULL if there is no memory.
+ */
+void *arena_alloc(struct st_arena *a, size_t size);
+
+/**
+ * Duplicates a string into an arena.
+ */
+char *arena_strdup(struct st_arena *a, const char *s);
+
+/**
+ * Registers a function to be called with "arg" when an arena is reset or
+ * destroyed, for the resources its memory refers to. The functions are called
+ * in the reverse order they were registered.
+ *
+ * @return 0 or -1 if there is no memory.
+ */
+int arena_cleanup(struct st_arena *a, void (*fn)(void *), void *arg);
+
+/**
+ * Releases everything allocated from an arena, keeping its largest block of
+ * memory for the next allocations.
+ */
+void arena_reset(struct st_arena *a);
+
+/**
+ * Releases an arena and everything allocated from it.
+ */
+void arena_destroy(struct st_arena *a);
+
+#endif /* !defined(_ARENA_H_) */
@@ -28,17 +28,311 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdio.h>
+
+#include "jnyikes.h"
+#include "jys.h"
+#include "jyo.h"
+#include "jyc.h"
+#include "jyh.h"
+
 #include "com_googlecode_jnyikes_JNyIkes.h"
 
+#define JNYIKES_CLASS "com/googlecode/jnyikes/JNyIkes"
+
+/**
+ * This method is called when the java side is sending us a POJO encoded in
+ * a direct buffer by the "Wire" class.
+ *
+ * @param jbuf The buffer.
+ * @param size The size of the POJO in the buffer.
+ * @param generation The jyc_generation() the getters used to encode the POJO
+ * were selected with.
+ *
+ * @return The "e_jy_err" error code of the handler of the POJO class, see
+ * jyh_register(), or JY_ESTALE if the class options changed since, so the
+ * POJO must be encoded again.
+ */
+static jint JNICALL
+jnyikes_j2n_wire(JNIEnv *jenv, jclass jcls, jobject jbuf, jint size, jint generation)
+{
+	struct st_jyo o;
+	void *buf;
+	int ret;
+
+	if ((jbuf == NULL) || (size < 0))
+		return (jint)JY_EEINVAL;
+	if ((unsigned int)generation != jyc_generation())
+		return (jint)JY_ESTALE;
+
+	buf = (*jenv)->GetDirectBufferAddress(jenv, jbuf);
+	if ((buf == NULL) || ((*jenv)->GetDirectBufferCapacity(jenv, jbuf) < size))
+		return (jint)JY_EEINVAL;
+
+	ret = jyo_wire_decode(buf, (size_t)size, &o);
+	if (ret != JY_ESUCCESS)
+		return (jint)ret;
+
+	ret = jyh_dispatch(jenv, &o);
+	jyo_free(&o);
+
+	return (jint)ret;
+}
+
+/**
+ * This method is called when the java side is sending us a POJO it could not
+ * encode, whose getters are called from here.
+ *
+ * @param jobj The POJO.
+ *
+ * @return The "e_jy_err" error code of the handler of the POJO class, see
+ * jyh_register().
+ */
+static jint JNICALL
+jnyikes_j2n_object(JNIEnv *jenv, jclass jcls, jobject jobj)
+{
+	struct st_jyo o;
+	int ret;
+
+	if (jobj == NULL)
+		return (jint)JY_EEINVAL;
+
+	ret = jyo_j2p_arena(jenv, jobj, &o, 0);
+	if (ret != JY_ESUCCESS)
+		return (jint)ret;
+
+	ret = jyh_dispatch(jenv, &o);
+	jyo_free(&o);
+
+	return (jint)ret;
+}
+
+/**
+ * This method is called when the java side checks that both sides agree on
+ * the wire format: the POJO encoded by the "Wire" class is decoded here, then
+ * encoded again and rebuilt by "Wire".
+ *
+ * @param jbuf The buffer.
+ * @param size The size of the POJO in the buffer.
+ *
+ * @return The rebuilt POJO, or NULL if it could not be decoded or rebuilt.
+ */
+static jobject JNICALL
+jnyikes_wire_echo(JNIEnv *jenv, jclass jcls, jobject jbuf, jint size)
+{
+	struct st_jyo o;
+	jobject jobj;
+	void *buf;
+
+	if ((jbuf == NULL) || (size < 0))
+		return NULL;
+
+	buf = (*jenv)->GetDirectBufferAddress(jenv, jbuf);
+	if ((buf == NULL) || ((*jenv)->GetDirectBufferCapacity(jenv, jbuf) < size))
+		return NULL;
+
+	if (jyo_wire_decode(buf, (size_t)size, &o) != JY_ESUCCESS)
+		return NULL;
+
+	if (jyo_p2j_wire(jenv, &o, &jobj) != JY_ESUCCESS)
+		jobj = NULL;
+	jyo_free(&o);
+
+	return jobj;
+}
+
+/**
+ * Handler returning the size of the blob property "arg" of a POJO.
+ */
+static int
+jnyikes_size_handler_fn(JNIEnv *jenv, struct st_jyo *o, void *arg)
+{
+	void *data;
+	size_t size;
+	int ret;
+
+	ret = jyo_get_blob(o, (const struct st_jys *)arg, &data, &size);
+	if (ret != JY_ESUCCESS)
+		return ret;
+
+	return (int)size;
+}
+
 /**
- * This method is called when the java side is sending us a POJO.
+ * This method is called when the java side checks that POJOs reach the
+ * handler of their class: it registers one returning the size of a blob
+ * property.
  *
- * @param jobject The POJO.
+ * @param jclazz The class name.
+ * @param jgetter The property, or NULL to unregister the handler.
  *
- * @return Zero.
+ * @return A "e_jy_err" error code.
  */
-JNIEXPORT jint JNICALL
-Java_com_googlecode_jnyikes_JNyIkes_j2n(JNIEnv *jenv, jclass jcls, jobject jobj)
+static jint JNICALL
+jnyikes_size_handler(JNIEnv *jenv, jclass jcls, jstring jclazz, jstring jgetter)
 {
-	return (jint)0;
+	const struct st_jys *sym;
+	const char *clazz, *getter;
+	int ret;
+
+	if (jclazz == NULL)
+		return (jint)JY_EEINVAL;
+
+	clazz = (*jenv)->GetStringUTFChars(jenv, jclazz, NULL);
+	if (clazz == NULL)
+		return (jint)JY_EENOMEM;
+
+	sym = NULL;
+	if (jgetter != NULL) {
+		getter = (*jenv)->GetStringUTFChars(jenv, jgetter, NULL);
+		if (getter == NULL) {
+			(*jenv)->ReleaseStringUTFChars(jenv, jclazz, clazz);
+			return (jint)JY_EENOMEM;
+		}
+		sym = jys_intern(getter);
+		(*jenv)->ReleaseStringUTFChars(jenv, jgetter, getter);
+		if (sym == NULL) {
+			(*jenv)->ReleaseStringUTFChars(jenv, jclazz, clazz);
+			return (jint)JY_EENOMEM;
+		}
+	}
+
+	if (sym != NULL)
+		ret = jyh_register(clazz, jnyikes_size_handler_fn, (void *)sym);
+	else
+		ret = jyh_register(clazz, NULL, NULL);
+	(*jenv)->ReleaseStringUTFChars(jenv, jclazz, clazz);
+
+	return (jint)ret;
+}
+
+/**
+ * This method is called when the java side needs the getters, or the fields,
+ * jyo_j2p() calls on the objects of a class, to encode them the same way.
+ *
+ * @param jclazz The class.
+ * @param fields If the fields are wanted instead of the getter methods.
+ *
+ * @return The property names, in the order jyo_j2p() fetches them, or NULL
+ * if the class can't be described.
+ */
+static jobjectArray JNICALL
+jnyikes_getters(JNIEnv *jenv, jclass jcls, jclass jclazz, jboolean fields)
+{
+	const struct st_method_ll *m;
+	struct st_jyc *c;
+	jobjectArray jnames;
+	jstring jname;
+	jclass jstring_cls;
+	jsize i, n;
+
+	if ((jclazz == NULL) || (jyc_get(jenv, jclazz, &c) != JY_ESUCCESS))
+		return NULL;
+
+	n = 0;
+	for (m = (const struct st_method_ll *)c->getters.first; m != NULL;
+	    m = (const struct st_method_ll *)m->ll.next)
+		if ((m->jfid != NULL) == (fields != JNI_FALSE))
+			n++;
+
+	jnames = NULL;
+	jstring_cls = (*jenv)->FindClass(jenv, "java/lang/String");
+	if (jstring_cls != NULL) {
+		jnames = (*jenv)->NewObjectArray(jenv, n, jstring_cls, NULL);
+		(*jenv)->DeleteLocalRef(jenv, jstring_cls);
+	}
+
+	i = 0;
+	for (m = (const struct st_method_ll *)c->getters.first;
+	    (m != NULL) && (jnames != NULL);
+	    m = (const struct st_method_ll *)m->ll.next) {
+		if ((m->jfid != NULL) != (fields != JNI_FALSE))
+			continue;
+
+		/* The pending exception is thrown on return. */
+		jname = (*jenv)->NewStringUTF(jenv, m->name);
+		if (jname == NULL) {
+			(*jenv)->DeleteLocalRef(jenv, jnames);
+			jnames = NULL;
+			break;
+		}
+		(*jenv)->SetObjectArrayElement(jenv, jnames, i++, jname);
+		(*jenv)->DeleteLocalRef(jenv, jname);
+	}
+
+	jyc_release(jenv, c);
+
+	return jnames;
+}
+
+/**
+ * This method is called when the java side checks if the getters it got from
+ * jnyikes_getters() are still the ones selected by the class options.
+ *
+ * @return The jyc_generation() of the class options.
+ */
+static jint JNICALL
+jnyikes_generation(JNIEnv *jenv, jclass jcls)
+{
+	return (jint)jyc_generation();
+}
+
+/**
+ * This method is called when the java side gives back a buffer of native
+ * memory received in a POJO.
+ *
+ * @param jbuf The buffer.
+ *
+ * @return Zero or a negative "e_jy_err" error code.
+ */
+static jint JNICALL
+jnyikes_release(JNIEnv *jenv, jclass jcls, jobject jbuf)
+{
+	if (jbuf == NULL)
+		return (jint)JY_EEINVAL;
+
+	return (jint)jyo_blob_release(jenv, jbuf);
+}
+
+static JNINativeMethod g_jnyikes_natives[] = {
+	{ "j2nWire", "(Ljava/nio/ByteBuffer;II)I", (void *)jnyikes_j2n_wire },
+	{ "j2nObject", "(Ljava/lang/Object;)I", (void *)jnyikes_j2n_object },
+	{ "getters", "(Ljava/lang/Class;Z)[Ljava/lang/String;", (void *)jnyikes_getters },
+	{ "generation", "()I", (void *)jnyikes_generation },
+	{ "wireEcho", "(Ljava/nio/ByteBuffer;I)Ljava/lang/Object;", (void *)jnyikes_wire_echo },
+	{ "release", "(Ljava/nio/ByteBuffer;)I", (void *)jnyikes_release },
+	{ "sizeHandler", "(Ljava/lang/String;Ljava/lang/String;)I", (void *)jnyikes_size_handler },
+};
+
+/**
+ * Binds the native methods of "com.googlecode.jnyikes.JNyIkes" with
+ * RegisterNatives().
+ *
+ * @return A "e_jy_err" error code: JY_ENOJCLASS if the class is not found.
+ */
+int
+jnyikes_register_natives(JNIEnv *jenv)
+{
+	jclass jcls;
+	jint jret;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+
+	jcls = (*jenv)->FindClass(jenv, JNYIKES_CLASS);
+	if (jcls == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		return JY_ENOJCLASS;
+	}
+
+	jret = (*jenv)->RegisterNatives(jenv, jcls, g_jnyikes_natives,
+	    sizeof(g_jnyikes_natives) / sizeof(g_jnyikes_natives[0]));
+	(*jenv)->DeleteLocalRef(jenv, jcls);
+	if (jret != 0) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+		return JY_ENOTFOUND;
+	}
+
+	return JY_ESUCCESS;
 }
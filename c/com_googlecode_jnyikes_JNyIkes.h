@@ -1,21 +1,46 @@
-/* DO NOT EDIT THIS FILE - it is machine generated */
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_COM_GOOGLECODE_JNYIKES_JNYIKES_H_)
+#define _COM_GOOGLECODE_JNYIKES_JNYIKES_H_
+
 #include <jni.h>
-/* Header for class com_googlecode_jnyikes_JNyIkes */
 
-#ifndef _Included_com_googlecode_jnyikes_JNyIkes
-#define _Included_com_googlecode_jnyikes_JNyIkes
-#ifdef __cplusplus
-extern "C" {
-#endif
-/*
- * Class:     com_googlecode_jnyikes_JNyIkes
- * Method:    j2n
- * Signature: (Ljava/lang/Object;)I
+/**
+ * Binds the native methods of "com.googlecode.jnyikes.JNyIkes" with
+ * RegisterNatives(). JNI_OnLoad() calls it when Java loads the library;
+ * applications that create the JVM themselves call it once the class can be
+ * found.
+ *
+ * @return A "e_jy_err" error code: JY_ENOJCLASS if the class is not found.
  */
-JNIEXPORT jint JNICALL Java_com_googlecode_jnyikes_JNyIkes_j2n
-  (JNIEnv *, jclass, jobject);
+int jnyikes_register_natives(JNIEnv *jenv);
 
-#ifdef __cplusplus
-}
-#endif
-#endif
+#endif /* !defined(_COM_GOOGLECODE_JNYIKES_JNYIKES_H_) */
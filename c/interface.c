@@ -28,17 +28,27 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE		/* pthread_setaffinity_np(), pthread_setname_np() */
+#endif
+
 #include <errno.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
 #include <pthread.h>
 
 #include <jni.h>
 
+#include "jnyikes.h"
+#include "jyc.h"
 #include "jyo.h"
+#include "jyh.h"
 
 #include "interface.h"
+#include "com_googlecode_jnyikes_JNyIkes.h"
 
 #define L_PTHREAD_INITIALIZER ((pthread_t)0)
 
@@ -52,6 +62,17 @@ struct thrparam_st {
 	int (*thrfn)(JavaVM *, JNIEnv *);
 };
 
+/**
+ * JNIEnv of a thread attached by jy_env_get(), detached when it exits.
+ */
+struct envcache_st {
+	JavaVM *jvm;
+	JNIEnv *jenv;
+};
+
+static pthread_key_t g_env_key;
+static pthread_once_t g_env_once = PTHREAD_ONCE_INIT;
+
 /**
  * Stores JVM data pointer.
  *
@@ -60,6 +81,8 @@ struct thrparam_st {
 jint
 JNI_OnLoad(JavaVM *vm, void *reserved)
 {
+	JNIEnv *jenv;
+
 #ifdef DEBUG
 	printf("%s(%p, %p);\n", __func__, (void *)vm, reserved);
 	fflush(stdout);
@@ -67,6 +90,11 @@ JNI_OnLoad(JavaVM *vm, void *reserved)
 
 	g_jvm = vm;
 
+	/* Bind the JNyIkes natives, unless the library was loaded by a class
+	 * that can't see it. */
+	if ((*vm)->GetEnv(vm, (void **)&jenv, JNI_VERSION_1_2) == JNI_OK)
+		(void)jnyikes_register_natives(jenv);
+
 	return JNI_VERSION_1_2;
 }
 
@@ -78,11 +106,18 @@ JNI_OnLoad(JavaVM *vm, void *reserved)
 void
 JNI_OnUnload(JavaVM *vm, void *reserved)
 {
+	JNIEnv *jenv;
+
 #ifdef DEBUG
 	printf("%s(%p, %p);\n", __func__, (void *) vm, reserved);
 	fflush(stdout);
 #endif
 
+	/* Drop the cached class descriptors. */
+	if ((*vm)->GetEnv(vm, (void **)&jenv, JNI_VERSION_1_2) == JNI_OK)
+		jyc_flush(jenv);
+	jyh_flush();
+
 	g_jvm = NULL;
 }
 
@@ -223,3 +258,502 @@ start_thread(int (*thrfn)(JavaVM *, JNIEnv *))
 
 	return 0;
 }
+
+/**
+ * Detaches an exiting thread attached by jy_env_get().
+ */
+static void
+l_env_detach(void *param)
+{
+	struct envcache_st *ec;
+
+	ec = (struct envcache_st *)param;
+
+	if ((*ec->jvm)->DetachCurrentThread(ec->jvm) < 0) {
+		fprintf(stderr, "%s(%p); Error while dettaching current "
+		    "thread from the JVM.\n", __func__, param);
+		fflush(stderr);
+	}
+
+	free(ec);
+}
+
+static void
+l_env_init(void)
+{
+	(void)pthread_key_create(&g_env_key, l_env_detach);
+}
+
+/**
+ * Gets the JNIEnv of the calling thread, attaching it to the JVM on first
+ * use.
+ *
+ * @return The JNIEnv or NULL if the JVM was not loaded or could not attach
+ * the thread.
+ */
+JNIEnv *
+jy_env_get(void)
+{
+	struct envcache_st *ec;
+	JavaVMAttachArgs thr_args;
+	JNIEnv *jenv;
+	JavaVM *jvm;
+
+	(void)pthread_once(&g_env_once, l_env_init);
+
+	/* Threads we attached keep their JNIEnv. */
+	ec = pthread_getspecific(g_env_key);
+	if (ec != NULL)
+		return ec->jenv;
+
+	jvm = g_jvm;
+	if (jvm == NULL)
+		return NULL;
+
+	/* Java threads, and the ones attached by someone else, are not ours
+	 * to detach. */
+	if ((*jvm)->GetEnv(jvm, (void **)&jenv, JNI_VERSION_1_2) == JNI_OK)
+		return jenv;
+
+	ec = malloc(sizeof(struct envcache_st));
+	if (ec == NULL)
+		return NULL;
+
+	/* Daemon threads don't hold the JVM up when it shuts down. */
+	memset(&thr_args, 0, sizeof(JavaVMAttachArgs));
+	thr_args.version = JNI_VERSION_1_2;
+	thr_args.name = "jnyikes";
+	if ((*jvm)->AttachCurrentThreadAsDaemon(jvm, (void **)&jenv, &thr_args) < 0) {
+		fprintf(stderr, "%s(); Error while attaching current thread "
+		    "to the JVM.\n", __func__);
+		fflush(stderr);
+		free(ec);
+		return NULL;
+	}
+
+	ec->jvm = jvm;
+	ec->jenv = jenv;
+	if (pthread_setspecific(g_env_key, ec) != 0) {
+		(void)(*jvm)->DetachCurrentThread(jvm);
+		free(ec);
+		return NULL;
+	}
+
+	return jenv;
+}
+
+/*
+ * Worker pool.
+ */
+
+/** Name of the workers of the pools started without one. */
+#define L_POOL_DEFAULT_NAME "jnyikes-pool"
+
+/** Longest worker name, as seen by Java. */
+#define L_POOL_NAME_MAX 64
+
+/**
+ * Task submitted to a pool.
+ */
+struct task_st {
+	struct task_st *next;
+	int (*fn)(JavaVM *, JNIEnv *, void *);
+	void *arg;
+};
+
+/**
+ * Worker of a pool and the queue of the tasks submitted to it.
+ */
+struct worker_st {
+	struct pool_st *pool;
+	unsigned int index;
+	pthread_t thread;
+	char name[L_POOL_NAME_MAX];
+	/** The queue, guarded by "lock". */
+	struct task_st *head, *tail;
+	pthread_mutex_t lock;
+};
+
+struct pool_st {
+	JavaVM *jvm;
+	/** If the workers are pinned to a CPU each. */
+	int affinity;
+	/**
+	 * The round robin counter of the tasks submitted from outside, the
+	 * number of queued tasks and of sleeping workers, and the state of
+	 * the pool, guarded by "lock".
+	 */
+	unsigned int next;
+	unsigned int pending;
+	unsigned int sleeping;
+	int stopping;
+	int discard;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	/**
+	 * The number of workers done attaching to the JVM and of the ones
+	 * that failed to, which exited, guarded by "lock".
+	 */
+	unsigned int nready;
+	unsigned int nfailed;
+	/** The number of workers and of their threads started. */
+	unsigned int nworkers;
+	unsigned int nstarted;
+	struct worker_st workers[];
+};
+
+/** The worker running in the calling thread, if any. */
+static pthread_key_t g_worker_key;
+static pthread_once_t g_worker_once = PTHREAD_ONCE_INIT;
+
+static void
+l_worker_init(void)
+{
+	(void)pthread_key_create(&g_worker_key, NULL);
+}
+
+/**
+ * Appends a task to the queue of a worker.
+ */
+static void
+l_worker_push(struct worker_st *w, struct task_st *t)
+{
+	t->next = NULL;
+
+	(void)pthread_mutex_lock(&w->lock);
+	if (w->tail != NULL)
+		w->tail->next = t;
+	else
+		w->head = t;
+	w->tail = t;
+	(void)pthread_mutex_unlock(&w->lock);
+}
+
+/**
+ * Takes the oldest task of the queue of a worker, or returns NULL.
+ */
+static struct task_st *
+l_worker_pop(struct worker_st *w)
+{
+	struct task_st *t;
+
+	(void)pthread_mutex_lock(&w->lock);
+	t = w->head;
+	if (t != NULL) {
+		w->head = t->next;
+		if (w->head == NULL)
+			w->tail = NULL;
+	}
+	(void)pthread_mutex_unlock(&w->lock);
+
+	return t;
+}
+
+/**
+ * Takes a task of the worker "w" or, if it has none, steals one from the
+ * other workers, starting from its neighbour.
+ */
+static struct task_st *
+l_worker_take(struct worker_st *w)
+{
+	struct pool_st *pool;
+	struct task_st *t;
+	unsigned int i;
+
+	pool = w->pool;
+
+	t = l_worker_pop(w);
+	for (i = 1; (t == NULL) && (i < pool->nworkers); i++)
+		t = l_worker_pop(&pool->workers[(w->index + i) % pool->nworkers]);
+
+	return t;
+}
+
+/**
+ * Wrapper thread function of the workers of a pool: runs tasks until the
+ * pool is stopped and, unless the pool is discarding them, no task is left.
+ */
+static void *
+l_worker(void *param)
+{
+	struct worker_st *w;
+	struct pool_st *pool;
+	struct task_st *t;
+	JavaVMAttachArgs thr_args;
+	JNIEnv *jenv;
+#if defined(__linux__)
+	char tname[16];
+	cpu_set_t cpus;
+	long ncpus;
+#endif
+
+	w = (struct worker_st *)param;
+	pool = w->pool;
+
+	(void)pthread_once(&g_worker_once, l_worker_init);
+	(void)pthread_setspecific(g_worker_key, w);
+
+#if defined(__linux__)
+	/* The kernel takes names of up to 15 characters. */
+	strncpy(tname, w->name, sizeof(tname) - 1);
+	tname[sizeof(tname) - 1] = '\000';
+	(void)pthread_setname_np(pthread_self(), tname);
+
+	if (pool->affinity) {
+		ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		if (ncpus > 0) {
+			CPU_ZERO(&cpus);
+			CPU_SET(w->index % (unsigned int)ncpus, &cpus);
+			(void)pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+		}
+	}
+#endif
+
+	/* Attach this thread to the JVM, as a daemon: the pool is stopped by
+	 * the application, not by the JVM shutting down. */
+	memset(&thr_args, 0, sizeof(JavaVMAttachArgs));
+	thr_args.version = JNI_VERSION_1_2;
+	thr_args.name = w->name;
+	if ((*pool->jvm)->AttachCurrentThreadAsDaemon(pool->jvm, (void **)&jenv, &thr_args) < 0) {
+		fprintf(stderr, "%s(%p); Error while attaching current thread "
+		    "to the JVM.\n", __func__, param);
+		fflush(stderr);
+		jenv = NULL;
+	}
+
+	/* jy_pool_start() waits for every worker to report: a worker that
+	 * could not attach makes it fail, so it never gets a task. */
+	(void)pthread_mutex_lock(&pool->lock);
+	pool->nready++;
+	if (jenv == NULL)
+		pool->nfailed++;
+	(void)pthread_cond_broadcast(&pool->cond);
+	(void)pthread_mutex_unlock(&pool->lock);
+
+	if (jenv == NULL) {
+		(void)pthread_setspecific(g_worker_key, NULL);
+		return NULL;
+	}
+
+	for (;;) {
+		(void)pthread_mutex_lock(&pool->lock);
+		while ((pool->pending == 0) && !pool->stopping) {
+			pool->sleeping++;
+			(void)pthread_cond_wait(&pool->cond, &pool->lock);
+			pool->sleeping--;
+		}
+		if (pool->discard || (pool->stopping && (pool->pending == 0))) {
+			(void)pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		(void)pthread_mutex_unlock(&pool->lock);
+
+		/* Another worker may have taken the pending task first. */
+		t = l_worker_take(w);
+		if (t == NULL) {
+			sched_yield();
+			continue;
+		}
+
+		(void)pthread_mutex_lock(&pool->lock);
+		pool->pending--;
+		(void)pthread_mutex_unlock(&pool->lock);
+
+		(void)t->fn(pool->jvm, jenv, t->arg);
+		free(t);
+	}
+
+	if ((*pool->jvm)->DetachCurrentThread(pool->jvm) < 0) {
+		fprintf(stderr, "%s(%p); Error while dettaching current "
+		    "thread from the JVM.\n", __func__, param);
+		fflush(stderr);
+	}
+
+	(void)pthread_setspecific(g_worker_key, NULL);
+
+	return NULL;
+}
+
+/**
+ * Starts a pool of worker threads attached to the JVM, returning once every
+ * worker is attached.
+ *
+ * @param opts The options of the pool, or NULL for the defaults.
+ * @param pool Where the pool will be returned.
+ *
+ * @return 0 for success or -1 with "errno" set: EAGAIN if a worker could not
+ * be attached to the JVM.
+ */
+int
+jy_pool_start(const struct pool_opts_st *opts, struct pool_st **pool)
+{
+	struct pool_st *p;
+	struct worker_st *w;
+	const char *name;
+	unsigned int i, n, failed;
+	long ncpus;
+	int eno;
+
+	if ((pool == NULL) || (g_jvm == NULL)) {
+		errno = EINVAL;
+		return -1;
+	}
+	*pool = NULL;
+
+	n = opts != NULL ? opts->nthreads : 0;
+	if (n == 0) {
+		ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		n = ncpus > 0 ? (unsigned int)ncpus : 1;
+	}
+	name = (opts != NULL) && (opts->name != NULL) ? opts->name : L_POOL_DEFAULT_NAME;
+
+	p = calloc(1, sizeof(struct pool_st) + n * sizeof(struct worker_st));
+	if (p == NULL)
+		return -1;
+	p->jvm = g_jvm;
+	p->nworkers = n;
+	p->affinity = (opts != NULL) && opts->affinity;
+	(void)pthread_mutex_init(&p->lock, NULL);
+	(void)pthread_cond_init(&p->cond, NULL);
+
+	for (i = 0; i < n; i++) {
+		w = &p->workers[i];
+		w->pool = p;
+		w->index = i;
+		(void)snprintf(w->name, sizeof(w->name), "%s-%u", name, i);
+		(void)pthread_mutex_init(&w->lock, NULL);
+	}
+
+	for (i = 0; i < n; i++) {
+		eno = pthread_create(&p->workers[i].thread, NULL, l_worker, &p->workers[i]);
+		if (eno != 0) {
+			(void)jy_pool_stop(p, 0);
+			errno = eno;
+			return -1;
+		}
+		p->nstarted++;
+	}
+
+	/* The workers share the condition of the pool with this wait: they
+	 * check their own predicate when woken. */
+	(void)pthread_mutex_lock(&p->lock);
+	while (p->nready < p->nstarted)
+		(void)pthread_cond_wait(&p->cond, &p->lock);
+	failed = p->nfailed;
+	(void)pthread_mutex_unlock(&p->lock);
+
+	if (failed > 0) {
+		(void)jy_pool_stop(p, 0);
+		errno = EAGAIN;
+		return -1;
+	}
+
+	*pool = p;
+
+	return 0;
+}
+
+/**
+ * Submits a task to a pool.
+ *
+ * @param fn The task, called by a worker with "arg".
+ * @param arg The argument of the task.
+ *
+ * @return 0 for success or -1 with "errno" set: ESHUTDOWN if the pool is
+ * being stopped, unless a task of a draining pool submits it.
+ */
+int
+jy_pool_submit(struct pool_st *pool, int (*fn)(JavaVM *, JNIEnv *, void *), void *arg)
+{
+	struct worker_st *w;
+	struct task_st *t;
+
+	if ((pool == NULL) || (fn == NULL)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	t = malloc(sizeof(struct task_st));
+	if (t == NULL)
+		return -1;
+	t->fn = fn;
+	t->arg = arg;
+
+	/* Tasks submitted by a worker stay in its own queue, the others are
+	 * spread among the workers. */
+	(void)pthread_once(&g_worker_once, l_worker_init);
+	w = pthread_getspecific(g_worker_key);
+	if ((w != NULL) && (w->pool != pool))
+		w = NULL;
+
+	(void)pthread_mutex_lock(&pool->lock);
+	/* A draining pool still takes the tasks of its own tasks: their
+	 * worker runs them before exiting. */
+	if (pool->discard || (pool->stopping && (w == NULL))) {
+		(void)pthread_mutex_unlock(&pool->lock);
+		free(t);
+		errno = ESHUTDOWN;
+		return -1;
+	}
+	/* Queued under the pool lock so that stopping can't miss it. */
+	if (w == NULL)
+		w = &pool->workers[pool->next++ % pool->nworkers];
+	l_worker_push(w, t);
+	pool->pending++;
+	if (pool->sleeping > 0)
+		(void)pthread_cond_signal(&pool->cond);
+	(void)pthread_mutex_unlock(&pool->lock);
+
+	return 0;
+}
+
+/**
+ * Stops a pool and frees it.
+ *
+ * @param drain If the tasks already submitted are run first. Otherwise only
+ * the running tasks are waited for and the others are dropped.
+ *
+ * @return 0 for success or -1 with "errno" set: EDEADLK if called by a
+ * worker of the pool.
+ */
+int
+jy_pool_stop(struct pool_st *pool, int drain)
+{
+	struct worker_st *w;
+	struct task_st *t;
+	unsigned int i;
+
+	if (pool == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	(void)pthread_once(&g_worker_once, l_worker_init);
+	w = pthread_getspecific(g_worker_key);
+	if ((w != NULL) && (w->pool == pool)) {
+		errno = EDEADLK;
+		return -1;
+	}
+
+	(void)pthread_mutex_lock(&pool->lock);
+	pool->stopping = 1;
+	pool->discard = !drain;
+	(void)pthread_cond_broadcast(&pool->cond);
+	(void)pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < pool->nstarted; i++)
+		(void)pthread_join(pool->workers[i].thread, NULL);
+
+	/* Drop the tasks left behind. */
+	for (i = 0; i < pool->nworkers; i++) {
+		w = &pool->workers[i];
+		while ((t = l_worker_pop(w)) != NULL)
+			free(t);
+		(void)pthread_mutex_destroy(&w->lock);
+	}
+	(void)pthread_mutex_destroy(&pool->lock);
+	(void)pthread_cond_destroy(&pool->cond);
+	free(pool);
+
+	return 0;
+}
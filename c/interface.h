@@ -46,4 +46,78 @@
  */
 int start_thread(int (*thrfn)(JavaVM *, JNIEnv *));
 
+/**
+ * Gets the JNIEnv of the calling thread, attaching it to the JVM on first
+ * use, so that any thread can call the jnyikes APIs.
+ *
+ * The JNIEnv is kept in thread local storage: later calls only cost a lookup.
+ * Threads attached here are daemon threads and are detached when they exit.
+ * Java threads and threads attached otherwise get their JNIEnv without being
+ * taken over.
+ *
+ * @return The JNIEnv or NULL if the JVM was not loaded or could not attach
+ * the thread.
+ */
+JNIEnv *jy_env_get(void);
+
+/**
+ * Options of a worker pool.
+ */
+struct pool_opts_st {
+	/** The number of workers, or 0 for one per online CPU. */
+	unsigned int nthreads;
+	/**
+	 * The prefix of the names of the workers, which are numbered from 0,
+	 * or NULL for "jnyikes-pool".
+	 */
+	const char *name;
+	/** If worker "i" is pinned to CPU "i" modulo the number of CPUs. */
+	int affinity;
+};
+
+/**
+ * Pool of threads attached to the JVM running the tasks submitted to it in
+ * parallel.
+ */
+struct pool_st;
+
+/**
+ * Starts a pool of worker threads attached to the JVM, as daemon threads.
+ *
+ * Each worker has its own queue of tasks. The tasks submitted by a task stay
+ * in the queue of its worker and the others are spread among the workers.
+ * Workers with nothing to do take the tasks of the others.
+ *
+ * It returns once every worker is attached to the JVM, so every task
+ * submitted afterwards is run by an attached worker.
+ *
+ * @param opts The options of the pool, or NULL for the defaults.
+ * @param pool Where the pool will be returned.
+ *
+ * @return 0 for success or -1 with "errno" set: EAGAIN if a worker could not
+ * be attached to the JVM.
+ */
+int jy_pool_start(const struct pool_opts_st *opts, struct pool_st **pool);
+
+/**
+ * Submits a task to a pool. The task is called by a worker, with the JVM, the
+ * JNIEnv of the worker and "arg". Its return is ignored.
+ *
+ * @return 0 for success or -1 with "errno" set: ESHUTDOWN if the pool is
+ * being stopped, unless a task of a draining pool submits it.
+ */
+int jy_pool_submit(struct pool_st *pool, int (*fn)(JavaVM *, JNIEnv *, void *), void *arg);
+
+/**
+ * Stops a pool and frees it. Must not be called by a task of the pool.
+ *
+ * @param drain If the tasks already submitted are run before the workers
+ * exit. Otherwise only the running tasks are waited for and the others are
+ * dropped, without being called.
+ *
+ * @return 0 for success or -1 with "errno" set: EDEADLK if called by a
+ * worker of the pool.
+ */
+int jy_pool_stop(struct pool_st *pool, int drain);
+
 #endif /* !defined(_INTERFACE_H_) */
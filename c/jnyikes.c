@@ -47,8 +47,23 @@ jy_strerror(enum e_jy_err t)
 		CASE_RETURN(JY_ENOJCLASS);
 		CASE_RETURN(JY_ENOTFOUND);
 		CASE_RETURN(JY_EEXCEPTION);
+		CASE_RETURN(JY_ESTALE);
 		default:
 			return NULL;
 	}
 #undef CASE_NAME
 }
+
+/**
+ * Computes the hash of a NUL terminated string (FNV-1a).
+ */
+unsigned int
+jy_strhash(const char *s)
+{
+	unsigned int h;
+
+	for (h = 2166136261U; *s != '\000'; s++)
+		h = (h ^ (unsigned char)*s) * 16777619U;
+
+	return h;
+}
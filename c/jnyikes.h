@@ -90,6 +90,7 @@ enum e_jy_err {
 	JY_ENOJCLASS	=  -6, /*!< Inexistent class. */
 	JY_ENOTFOUND	=  -7, /*!< Not found. */
 	JY_EEXCEPTION	=  -8, /*!< Exception caught. */
+	JY_ESTALE	=  -9, /*!< Stale data. */
 };
 
 /**
@@ -97,4 +98,9 @@ enum e_jy_err {
  */
 const char *jy_strerror(enum e_jy_err t);
 
+/**
+ * Computes the hash of a NUL terminated string (FNV-1a).
+ */
+unsigned int jy_strhash(const char *s);
+
 #endif /* !defined(_JNYIKES_H_) */
@@ -0,0 +1,2225 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#include <jni.h>
+
+#include "jyo.h"
+#include "jyc.h"
+
+#define JY_DEBUG_ERROR
+
+/** Number of buckets of the class hash table. Must be a power of 2. */
+#define JYC_HASH_SIZE 64
+/** Local references reserved while reflecting on a class. */
+#define JYC_LOCAL_FRAME 16
+/**
+ * Number of descriptors remembered by each thread: well above the classes a
+ * thread converts in turn, nested ones included.
+ */
+#define JYC_MRU_SIZE 16
+
+/**
+ * Descriptor indexed by the name used to find its class, as passed to
+ * "FindClass()".
+ */
+struct st_jyc_name {
+	struct st_jyc_name *next;
+	char *name;
+	/** The descriptor. Each name holds a reference. */
+	struct st_jyc *c;
+};
+
+/**
+ * Options of a class, set by jyc_set_flags() and jyc_set_getters().
+ */
+struct st_jyc_opts {
+	struct st_jyc_opts *next;
+	/** The class name, with '.' as package separator. */
+	char *name;
+	unsigned int flags;
+	/** NULL terminated getter name lists or NULL. */
+	char **allow;
+	char **deny;
+};
+
+/**
+ * The descriptors a thread got last, checked by jyc_get() before asking the
+ * identity hash code of the class to Java. No reference is held: the entries
+ * are only valid while "epoch" is the one of the tables, which guarantees
+ * the tables still hold them.
+ */
+struct st_jyc_mru {
+	unsigned int epoch;
+	/** The descriptors, the most recently used first. */
+	struct st_jyc *c[JYC_MRU_SIZE];
+};
+
+/*
+ * The descriptor tables. All of them are protected by "g_jyc_lock".
+ */
+static struct st_jyc *g_jyc_table[JYC_HASH_SIZE];
+static struct st_jyc_name *g_jyc_names[JYC_HASH_SIZE];
+static struct st_jyc_opts *g_jyc_opts[JYC_HASH_SIZE];
+static unsigned int g_jyc_default_flags = 0;
+/** Bumped once the class options changed, see jyc_generation(). */
+static unsigned int g_jyc_generation = 0;
+/** Bumped whenever a descriptor leaves "g_jyc_table". */
+static unsigned int g_jyc_epoch = 0;
+
+static pthread_key_t g_jyc_mru_key;
+static pthread_once_t g_jyc_mru_once = PTHREAD_ONCE_INIT;
+static pthread_rwlock_t g_jyc_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static void jyc_drop(JNIEnv *jenv, jy_bool all, const char *name);
+
+/*
+ * Reflection classes and methods, resolved once by jyc_jinit(). The global
+ * class references keep the method IDs valid.
+ */
+static pthread_mutex_t g_jyc_jinit_mutex = PTHREAD_MUTEX_INITIALIZER;
+static jclass g_jyc_jsystem = NULL;
+static jclass g_jyc_jclass = NULL;
+static jclass g_jyc_jmethod = NULL;
+static jclass g_jyc_jfield = NULL;
+static jclass g_jyc_jproperty = NULL;
+static jmethodID g_jyc_mid_identity_hash = NULL;
+static jmethodID g_jyc_mid_get_name = NULL;
+static jmethodID g_jyc_mid_get_methods = NULL;
+static jmethodID g_jyc_mid_to_string = NULL;
+static jmethodID g_jyc_mid_is_annotation_present = NULL;
+static jmethodID g_jyc_mid_get_fields = NULL;
+static jmethodID g_jyc_mid_field_to_string = NULL;
+static jmethodID g_jyc_mid_field_is_annotation_present = NULL;
+
+static void
+jyc_free_method(struct st_method_ll *m)
+{
+	JY_ASSERT_RETURN_VOID(m != NULL);
+
+	if (m->name != NULL)
+		free(m->name);
+	if (m->sign != NULL)
+		free(m->sign);
+	llfree(m, sizeof(struct st_method_ll));
+}
+
+static void
+jyc_free_method_ll(struct st_llhead *mll)
+{
+	struct st_method_ll *m;
+
+	JY_ASSERT_RETURN_VOID(mll != NULL);
+
+	while (mll->first != NULL) {
+		m = (struct st_method_ll *)mll->first;
+		llh_cut(mll, m);
+		jyc_free_method(m);
+	}
+}
+
+static const char *
+jyc_method_str_get_param(const char *str)
+{
+	const char *p;
+
+	JY_ASSERT_RETURN(str != NULL, NULL);
+
+	p = strchr(str, (int) '(');
+	JY_ASSERT_RETURN(p != NULL, NULL);
+	JY_ASSERT_RETURN(p != str, NULL);
+	p++;
+
+	return p;
+}
+
+static const char *
+jyc_method_str_get_name(const char *str)
+{
+	const char *pparam, *pname, *p;
+
+	JY_ASSERT_RETURN(str != NULL, NULL);
+
+	pparam = jyc_method_str_get_param(str);
+	JY_ASSERT_RETURN(pparam != NULL, NULL);
+
+	pname = str;
+	for (;;) {
+		p = strchr(pname, (int) ' ');
+		if ((p == NULL) || (++p >= pparam))
+			return pname;
+		pname = p;
+	}
+
+	return pname;
+}
+
+/** Method and field modifiers which may precede the type. */
+static const char *g_jyc_modifiers[] = {
+	"public ", "static ", "final ", "synchronized ", "native ",
+	"strictfp ", "abstract ", "transient ", "volatile ", NULL
+};
+
+static const char *
+jyc_method_str_get_type(const char *str)
+{
+	const char **mod;
+
+	JY_ASSERT_RETURN(str != NULL, NULL);
+
+	if (strncmp(str, "public ", 7) != 0)
+		return NULL;
+
+	/* Skip every modifier. */
+	for (mod = g_jyc_modifiers; *mod != NULL; ) {
+		if (strncmp(str, *mod, strlen(*mod)) == 0) {
+			str += strlen(*mod);
+			mod = g_jyc_modifiers;
+		} else
+			mod++;
+	}
+
+	return str;
+}
+
+static jy_bool
+jyc_method_str_has_modifier(const char *str, const char *mod)
+{
+	const char *ptype;
+
+	JY_ASSERT_RETURN(str != NULL, JY_FALSE);
+
+	ptype = jyc_method_str_get_type(str);
+	JY_ASSERT_RETURN(ptype != NULL, JY_FALSE);
+
+	for (; str < ptype; str = strchr(str, ' ') + 1)
+		if (strncmp(str, mod, strlen(mod)) == 0)
+			return JY_TRUE;
+
+	return JY_FALSE;
+}
+
+static jy_bool
+jyc_method_str_is_static(const char *str)
+{
+	return jyc_method_str_has_modifier(str, "static ");
+}
+
+static int
+jyc_str_get_type(const char *str)
+{
+	int len;
+
+	JY_ASSERT_RETURN(str != NULL, JY_EEINVAL);
+
+	/* Types are followed by a space, a parameter separator or the end of
+	 * the parameter list. */
+	len = (int) strcspn(str, " ,)");
+
+#define JY_STRING_TYPE_BOOLEAN "boolean"
+#define JY_STRING_TYPE_BOOLEAN_LENGTH 7
+#define JY_STRING_TYPE_BYTE "byte"
+#define JY_STRING_TYPE_BYTE_LENGTH 4
+#define JY_STRING_TYPE_CHAR "char"
+#define JY_STRING_TYPE_CHAR_LENGTH 4
+#define JY_STRING_TYPE_SHORT "short"
+#define JY_STRING_TYPE_SHORT_LENGTH 5
+#define JY_STRING_TYPE_INT "int"
+#define JY_STRING_TYPE_INT_LENGTH 3
+#define JY_STRING_TYPE_LONG "long"
+#define JY_STRING_TYPE_LONG_LENGTH 4
+#define JY_STRING_TYPE_FLOAT "float"
+#define JY_STRING_TYPE_FLOAT_LENGTH 5
+#define JY_STRING_TYPE_DOUBLE "double"
+#define JY_STRING_TYPE_DOUBLE_LENGTH 6
+#define JY_STRING_TYPE_VOID "void"
+#define JY_STRING_TYPE_VOID_LENGTH 4
+#define JY_STRING_TYPE_STRING "java.lang.String"
+#define JY_STRING_TYPE_STRING_LENGTH 16
+#define JY_STRING_TYPE_BYTEARRAY "byte[]"
+#define JY_STRING_TYPE_BYTEARRAY_LENGTH 6
+#define JY_STRING_TYPE_SHORTARRAY "short[]"
+#define JY_STRING_TYPE_SHORTARRAY_LENGTH 7
+#define JY_STRING_TYPE_INTARRAY "int[]"
+#define JY_STRING_TYPE_INTARRAY_LENGTH 5
+#define JY_STRING_TYPE_LONGARRAY "long[]"
+#define JY_STRING_TYPE_LONGARRAY_LENGTH 6
+#define JY_STRING_TYPE_FLOATARRAY "float[]"
+#define JY_STRING_TYPE_FLOATARRAY_LENGTH 7
+#define JY_STRING_TYPE_DOUBLEARRAY "double[]"
+#define JY_STRING_TYPE_DOUBLEARRAY_LENGTH 8
+#define JY_STRING_TYPE_BLOB "java.nio.ByteBuffer"
+#define JY_STRING_TYPE_BLOB_LENGTH 19
+
+#define ISTYPE(x) ((len == JY_STRING_TYPE_##x##_LENGTH) && (strncmp(str, JY_STRING_TYPE_##x, len) == 0))
+
+	if (ISTYPE(BOOLEAN))
+		return JYO_TBOOLEAN;
+	else if (ISTYPE(BYTE))
+		return JYO_TBYTE;
+	else if (ISTYPE(CHAR))
+		return JYO_TCHAR;
+	else if (ISTYPE(SHORT))
+		return JYO_TSHORT;
+	else if (ISTYPE(INT))
+		return JYO_TINT;
+	else if (ISTYPE(LONG))
+		return JYO_TLONG;
+	else if (ISTYPE(FLOAT))
+		return JYO_TFLOAT;
+	else if (ISTYPE(DOUBLE))
+		return JYO_TDOUBLE;
+	else if (ISTYPE(VOID))
+		return JYO_TVOID;
+	else if (ISTYPE(STRING))
+		return JYO_TSTRING;
+	else if (ISTYPE(BYTEARRAY))
+		return JYO_TBYTEARRAY;
+	else if (ISTYPE(SHORTARRAY))
+		return JYO_TSHORTARRAY;
+	else if (ISTYPE(INTARRAY))
+		return JYO_TINTARRAY;
+	else if (ISTYPE(LONGARRAY))
+		return JYO_TLONGARRAY;
+	else if (ISTYPE(FLOATARRAY))
+		return JYO_TFLOATARRAY;
+	else if (ISTYPE(DOUBLEARRAY))
+		return JYO_TDOUBLEARRAY;
+	else if (ISTYPE(BLOB))
+		return JYO_TBLOB;
+
+	return JY_EEINVAL;
+}
+
+static const char *
+jyc_java_basename(const char *str)
+{
+	const char *pend, *p0, *p1, *p2;
+
+	if (strchr(str, '.') == NULL)
+		return str;
+
+	p0 = strchr(str, '(');
+	p1 = strchr(str, ',');
+	p2 = strchr(str, ' ');
+
+	pend = p0;
+	if (p1 > pend)
+		pend = p1;
+	if (p2 > pend)
+		pend = p2;
+	if (pend == NULL)
+		pend = str + strlen(str);
+
+	p0 = str;
+	for (;;) {
+		p1 = strchr(p0, (int) '.');
+		if ((p1 == NULL) || (++p1 >= pend))
+			return p0;
+		p0 = p1;
+	}
+
+	return p0;
+}
+
+static void
+jyc_java_convert_str(char *str, char o, char d)
+{
+	char *p;
+
+	JY_ASSERT_RETURN_VOID(str != NULL);
+
+	for (p = strchr(str, (int)o); p != NULL; p = strchr(p, (int)o))
+		*p = d;
+}
+
+static struct st_method_ll *
+jyc_method_str_to_m(const char *str)
+{
+	const char *pparam, *pname, *ptype;
+	char *temp;
+	struct st_method_ll *m;
+
+	JY_ASSERT_RETURN(str != NULL, NULL);
+
+	pparam = jyc_method_str_get_param(str);
+	JY_ASSERT_RETURN(pparam != NULL, NULL);
+
+	if (pparam[0] != ')') {
+		JY_WARN_ENOSYS();
+		return NULL;
+	}
+
+	m = llalloc(sizeof(struct st_method_ll));
+	JY_ASSERT_RETURN(m != NULL, NULL);
+	memset(m, 0, sizeof(struct st_method_ll));
+
+	pname = jyc_method_str_get_name(str);
+	JY_ASSERT_RETURN(pname != NULL, NULL);
+
+	pname = jyc_java_basename(pname);
+
+	ptype = jyc_method_str_get_type(str);
+	JY_ASSERT_RETURN(ptype != NULL, NULL);
+
+	m->sign = malloc(strlen(str) + 1); /* FIXME */
+	JY_ASSERT_RETURN(m->sign != NULL, NULL);
+	*m->sign = '\000';
+
+	strcat(m->sign, "(");
+	strcat(m->sign, ")");
+
+#define CATTYPE(t, m, cat) case JYO_T##t: strcat(m->sign, cat); m->rettype = JYO_T##t; break
+	switch (jyc_str_get_type(ptype)) {
+		CATTYPE(BOOLEAN, m, "Z");
+		CATTYPE(BYTE, m, "B");
+		CATTYPE(CHAR, m, "C");
+		CATTYPE(SHORT, m, "S");
+		CATTYPE(INT, m, "I");
+		CATTYPE(LONG, m, "J");
+		CATTYPE(FLOAT, m, "F");
+		CATTYPE(DOUBLE, m, "D");
+		/* CATTYPE(VOID, m, "V"); */
+		CATTYPE(STRING, m, "Ljava/lang/String;");
+		CATTYPE(BYTEARRAY, m, "[B");
+		CATTYPE(SHORTARRAY, m, "[S");
+		CATTYPE(INTARRAY, m, "[I");
+		CATTYPE(LONGARRAY, m, "[J");
+		CATTYPE(FLOATARRAY, m, "[F");
+		CATTYPE(DOUBLEARRAY, m, "[D");
+		CATTYPE(BLOB, m, "Ljava/nio/ByteBuffer;");
+
+		default:
+			/* Arrays of other types are not properties. */
+			if (strchr(ptype, ' ')[-1] == ']') {
+				jyc_free_method(m);
+				return NULL;
+			}
+			strcat(m->sign, "L");
+			strncat(m->sign, ptype, strchr(ptype, ' ') - ptype);
+			strcat(m->sign, ";");
+			m->rettype = JYO_TJCLASS;
+			break;
+	}
+
+	/* FIXME */
+	temp = strdup(m->sign);
+	if (temp != NULL) {
+		free(m->sign);
+		m->sign = temp;
+	}
+
+	m->name = malloc(pparam - 1 - pname + 1); /* FIXME */
+	JY_ASSERT_RETURN(m->name != NULL, NULL);
+	*m->name = '\000';
+	strncat(m->name, pname, pparam - 1 - pname);
+
+	return m;
+}
+
+static jy_bool
+jyc_method_str_is_from_java(const char *str)
+{
+	const char *pname;
+
+	JY_ASSERT_RETURN(str != NULL, JY_FALSE);
+
+	pname = jyc_method_str_get_name(str);
+	JY_ASSERT_RETURN(pname != NULL, JY_FALSE);
+
+	if ((strncmp(pname, "java.", 5) == 0) || (strncmp(pname, "javax.", 6) == 0))
+		return JY_TRUE;
+
+	return JY_FALSE;
+}
+
+static jy_bool
+jyc_method_str_void_param(const char *str)
+{
+	const char *pparam;
+
+	JY_ASSERT_RETURN(str != NULL, JY_FALSE);
+
+	pparam = jyc_method_str_get_param(str);
+	JY_ASSERT_RETURN(pparam != NULL, JY_FALSE);
+
+	if (pparam[0] == ')')
+		return JY_TRUE;
+	return JY_FALSE;
+}
+
+static jy_bool
+jyc_method_str_void_return(const char *str)
+{
+	const char *ptype;
+
+	JY_ASSERT_RETURN(str != NULL, JY_FALSE);
+
+	ptype = jyc_method_str_get_type(str);
+	JY_ASSERT_RETURN(ptype != NULL, JY_FALSE);
+
+	if (strncmp(ptype, "void ", 5) == 0)
+		return JY_TRUE;
+	return JY_FALSE;
+}
+
+/**
+ * Gets the JNI signature of a single type from its Java name.
+ *
+ * @param str The Java type name, e.g. "int" or "java.lang.String". It ends
+ * at the first space, comma or parenthesis.
+ * @param sign Where the dynamically allocated signature will be returned.
+ *
+ * @return The "e_jyo_type" of the type or an "e_jy_err" error code.
+ */
+static int
+jyc_str_get_type_sign(const char *str, char **sign)
+{
+	int type;
+	size_t len;
+
+	type = jyc_str_get_type(str);
+	switch (type) {
+		case JYO_TBOOLEAN:
+			*sign = strdup("Z");
+			break;
+		case JYO_TBYTE:
+			*sign = strdup("B");
+			break;
+		case JYO_TCHAR:
+			*sign = strdup("C");
+			break;
+		case JYO_TSHORT:
+			*sign = strdup("S");
+			break;
+		case JYO_TINT:
+			*sign = strdup("I");
+			break;
+		case JYO_TLONG:
+			*sign = strdup("J");
+			break;
+		case JYO_TFLOAT:
+			*sign = strdup("F");
+			break;
+		case JYO_TDOUBLE:
+			*sign = strdup("D");
+			break;
+		case JYO_TVOID:
+			*sign = strdup("V");
+			break;
+		case JYO_TSTRING:
+			*sign = strdup("Ljava/lang/String;");
+			break;
+		case JYO_TBYTEARRAY:
+			*sign = strdup("[B");
+			break;
+		case JYO_TSHORTARRAY:
+			*sign = strdup("[S");
+			break;
+		case JYO_TINTARRAY:
+			*sign = strdup("[I");
+			break;
+		case JYO_TLONGARRAY:
+			*sign = strdup("[J");
+			break;
+		case JYO_TFLOATARRAY:
+			*sign = strdup("[F");
+			break;
+		case JYO_TDOUBLEARRAY:
+			*sign = strdup("[D");
+			break;
+		case JYO_TBLOB:
+			*sign = strdup("Ljava/nio/ByteBuffer;");
+			break;
+		default:
+			len = strcspn(str, " ,)");
+			if ((len == 0) || (str[len - 1] == ']'))
+				return JY_EEINVAL;
+			*sign = malloc(len + 3);
+			if (*sign == NULL)
+				return JY_EENOMEM;
+			**sign = '\000';
+			strcat(*sign, "L");
+			strncat(*sign, str, len);
+			strcat(*sign, ";");
+			jyc_java_convert_str(*sign, '.', '/');
+			type = JYO_TJCLASS;
+			break;
+	}
+
+	if (*sign == NULL)
+		return JY_EENOMEM;
+
+	return type;
+}
+
+/**
+ * Parses a "Method.toString()" string into a setter: a method with at most one
+ * parameter returning "void" or "boolean". Methods without parameters are
+ * called by JYO_TVOID properties.
+ *
+ * @return The setter or NULL if the method is not a setter.
+ */
+static struct st_jyc_setter *
+jyc_method_str_to_setter(const char *str)
+{
+	const char *pparam, *pend, *pname, *ptype;
+	struct st_jyc_setter *s;
+	int rettype;
+
+	JY_ASSERT_RETURN(str != NULL, NULL);
+
+	pparam = jyc_method_str_get_param(str);
+	JY_ASSERT_RETURN(pparam != NULL, NULL);
+
+	/* At most one parameter. */
+	pend = strchr(pparam, ')');
+	if ((pend == NULL) || (memchr(pparam, ',', pend - pparam) != NULL))
+		return NULL;
+
+	ptype = jyc_method_str_get_type(str);
+	if (ptype == NULL)
+		return NULL;
+	rettype = jyc_str_get_type(ptype);
+	if ((rettype != JYO_TVOID) && (rettype != JYO_TBOOLEAN))
+		return NULL;
+
+	/* The name goes from the last '.' up to the '('. */
+	for (pname = pparam - 1; (pname > str) && (pname[-1] != '.') &&
+	    (pname[-1] != ' '); pname--);
+	if (pname == pparam - 1)
+		return NULL;
+
+	s = malloc(sizeof(struct st_jyc_setter));
+	if (s == NULL)
+		return NULL;
+	memset(s, 0, sizeof(struct st_jyc_setter));
+
+	s->rettype = rettype;
+	s->name = malloc(pparam - 1 - pname + 1);
+	if (s->name == NULL) {
+		free(s);
+		return NULL;
+	}
+	*s->name = '\000';
+	strncat(s->name, pname, pparam - 1 - pname);
+
+	if (pend == pparam) {
+		s->ptype = JYO_TVOID;
+		s->psign = strdup("");
+		if (s->psign == NULL)
+			s->ptype = JY_EENOMEM;
+	} else
+		s->ptype = jyc_str_get_type_sign(pparam, &s->psign);
+	if ((s->ptype < 0) || ((s->ptype == JYO_TVOID) && (pend != pparam))) {
+		if (s->ptype > 0)
+			free(s->psign);
+		free(s->name);
+		free(s);
+		return NULL;
+	}
+
+	return s;
+}
+
+static void
+jyc_free_setters(struct st_jyc *c)
+{
+	struct st_jyc_setter *s;
+	int i;
+
+	JY_ASSERT_RETURN_VOID(c != NULL);
+
+	for (i = 0; i < JYC_SETTER_HASH_SIZE; i++) {
+		while (c->setters[i] != NULL) {
+			s = c->setters[i];
+			c->setters[i] = s->next;
+			free(s->name);
+			free(s->psign);
+			free(s);
+		}
+	}
+}
+
+/**
+ * Adds a resolved setter to the setter table of "c".
+ */
+static void
+jyc_insert_setter(struct st_jyc *c, struct st_jyc_setter *s)
+{
+	unsigned int h;
+
+	h = s->sym->hash & (JYC_SETTER_HASH_SIZE - 1);
+	s->next = c->setters[h];
+	c->setters[h] = s;
+}
+
+/**
+ * Resolves the method ID of a setter and adds it to the descriptor.
+ */
+static int
+jyc_add_setter(JNIEnv *jenv, jclass cls, struct st_jyc *c, struct st_jyc_setter *s)
+{
+	char *sig;
+
+	s->sym = jys_intern(s->name);
+	if (s->sym == NULL)
+		return JY_EENOMEM;
+
+	sig = malloc(strlen(s->psign) + 4);
+	if (sig == NULL)
+		return JY_EENOMEM;
+	*sig = '\000';
+	strcat(sig, "(");
+	strcat(sig, s->psign);
+	strcat(sig, s->rettype == JYO_TVOID ? ")V" : ")Z");
+
+	s->jmid = (*jenv)->GetMethodID(jenv, cls, s->name, sig);
+	if ((s->jmid == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Could not get method id of \"%s%s\" at \"%s:%d\".\n", s->name, sig, __FILE__, __LINE__);
+#endif
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+		}
+		fflush(stderr);
+		free(sig);
+
+		return JY_EEINVAL;
+	}
+	free(sig);
+
+	jyc_insert_setter(c, s);
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Frees a NULL terminated string list.
+ */
+static void
+jyc_strv_free(char **v)
+{
+	size_t i;
+
+	if (v == NULL)
+		return;
+
+	for (i = 0; v[i] != NULL; i++)
+		free(v[i]);
+	free(v);
+}
+
+/**
+ * Duplicates a NULL terminated string list. A NULL list is duplicated as NULL.
+ */
+static int
+jyc_strv_dup(char *const *v, char ***dup)
+{
+	size_t i, n;
+
+	*dup = NULL;
+	if (v == NULL)
+		return JY_ESUCCESS;
+
+	for (n = 0; v[n] != NULL; n++);
+
+	*dup = malloc((n + 1) * sizeof(char *));
+	if (*dup == NULL)
+		return JY_EENOMEM;
+	memset(*dup, 0, (n + 1) * sizeof(char *));
+
+	for (i = 0; i < n; i++) {
+		(*dup)[i] = strdup(v[i]);
+		if ((*dup)[i] == NULL) {
+			jyc_strv_free(*dup);
+			*dup = NULL;
+			return JY_EENOMEM;
+		}
+	}
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Checks if "str" is in the NULL terminated string list "v".
+ */
+static jy_bool
+jyc_strv_has(char *const *v, const char *str)
+{
+	for (; *v != NULL; v++)
+		if (strcmp(*v, str) == 0)
+			return JY_TRUE;
+
+	return JY_FALSE;
+}
+
+/**
+ * Copies the options set for the class of "c" into it.
+ */
+static int
+jyc_get_opts(struct st_jyc *c)
+{
+	struct st_jyc_opts *o;
+	int ret;
+
+	ret = JY_ESUCCESS;
+
+	(void)pthread_rwlock_rdlock(&g_jyc_lock);
+	c->flags = g_jyc_default_flags;
+	for (o = g_jyc_opts[jy_strhash(c->name) & (JYC_HASH_SIZE - 1)];
+	    o != NULL; o = o->next) {
+		if (strcmp(o->name, c->name) == 0) {
+			c->flags = o->flags;
+			ret = jyc_strv_dup(o->allow, &c->allow);
+			if (ret == JY_ESUCCESS)
+				ret = jyc_strv_dup(o->deny, &c->deny);
+			break;
+		}
+	}
+	(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+	return ret;
+}
+
+/**
+ * Applies the property discovery policy of the class of "c" to the getter
+ * or field "m".
+ *
+ * @param jmember The "java.lang.reflect.Method" of the getter or the
+ * "java.lang.reflect.Field" of the field.
+ * @param field If "m" is a field.
+ */
+static jy_bool
+jyc_getter_selected(JNIEnv *jenv, const struct st_jyc *c, const struct st_method_ll *m, jobject jmember, jy_bool field)
+{
+	jboolean annotated;
+	jmethodID jmid;
+
+	if ((c->deny != NULL) && jyc_strv_has(c->deny, m->name))
+		return JY_FALSE;
+
+	/* An explicit list overrides everything else. */
+	if (c->allow != NULL)
+		return jyc_strv_has(c->allow, m->name);
+
+	if (!field && ((c->flags & JYC_FBEAN) != 0)) {
+		if ((strncmp(m->name, "get", 3) == 0) && isupper((int)m->name[3]))
+			;
+		else if ((strncmp(m->name, "is", 2) == 0) &&
+		    isupper((int)m->name[2]) && (m->rettype == JYO_TBOOLEAN))
+			;
+		else
+			return JY_FALSE;
+	}
+
+	if ((c->flags & JYC_FANNOTATED) != 0) {
+		jmid = field ? g_jyc_mid_field_is_annotation_present :
+		    g_jyc_mid_is_annotation_present;
+		if ((g_jyc_jproperty == NULL) || (jmid == NULL))
+			return JY_FALSE;
+
+		annotated = (*jenv)->CallBooleanMethod(jenv, jmember, jmid, g_jyc_jproperty);
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+			fflush(stderr);
+			return JY_FALSE;
+		}
+		if (!annotated)
+			return JY_FALSE;
+	}
+
+	return JY_TRUE;
+}
+
+
+/**
+ * Parses a "Method.toString()" string and adds the method to the setter table
+ * of "c" if it is a setter and to its getter list if it is a getter.
+ *
+ * @param jmethod The "java.lang.reflect.Method" of the method.
+ */
+static int
+jyc_add_method(JNIEnv *jenv, jclass cls, struct st_jyc *c, jobject jmethod, const char *str)
+{
+	struct st_jyc_setter *s;
+	struct st_method_ll *m;
+
+	if (jyc_method_str_is_from_java(str) || jyc_method_str_is_static(str))
+		return JY_ESUCCESS;
+
+	/* Methods with at most one parameter and returning "void" or
+	 * "boolean" are setters. */
+	s = jyc_method_str_to_setter(str);
+	if ((s != NULL) && (jyc_add_setter(jenv, cls, c, s) != JY_ESUCCESS)) {
+		free(s->name);
+		free(s->psign);
+		free(s);
+		return JY_EEINVAL;
+	}
+
+	/* Methods without parameters that doesn't return void are getters. */
+	if (jyc_method_str_void_return(str) || !jyc_method_str_void_param(str))
+		return JY_ESUCCESS;
+
+	m = jyc_method_str_to_m(str);
+	if (m == NULL)
+		return JY_ESUCCESS;
+	if (!jyc_getter_selected(jenv, c, m, jmethod, JY_FALSE)) {
+		jyc_free_method(m);
+		return JY_ESUCCESS;
+	}
+
+	jyc_java_convert_str(m->sign, '.', '/');
+	m->jmid = (*jenv)->GetMethodID(jenv, cls, m->name, m->sign);
+	if ((m->jmid == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Could not get method id at \"%s:%d\".\n", __FILE__, __LINE__);
+#endif
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+		}
+		fflush(stderr);
+
+		jyc_free_method(m);
+		return JY_EEINVAL;
+	}
+
+	m->sym = jys_intern(m->name);
+	if (m->sym == NULL) {
+		jyc_free_method(m);
+		return JY_EENOMEM;
+	}
+
+	llh_append(&c->getters, m);
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Fills the getter list and the setter table of "c" in a single pass over the
+ * public methods of "cls".
+ */
+static int
+jyc_get_method_lists(JNIEnv *jenv, jclass cls, struct st_jyc *c)
+{
+	jobjectArray jmethods;
+	jobject jmethod;
+	jstring jstr;
+	const char *str;
+	jsize i, len;
+	int ret;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(cls != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(c != NULL, JY_EEINVAL);
+
+	llh_init(&c->getters);
+
+	/* A "jclass" is a "java.lang.Class" instance: ask it directly. */
+	jmethods = (jobjectArray)(*jenv)->CallObjectMethod(jenv, cls, g_jyc_mid_get_methods);
+	if ((jmethods == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+		if (jmethods != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jmethods);
+		return JY_EEXCEPTION;
+	}
+
+	ret = JY_ESUCCESS;
+	len = (*jenv)->GetArrayLength(jenv, jmethods);
+	for (i = 0; (i < len) && (ret == JY_ESUCCESS); i++) {
+		jmethod = (*jenv)->GetObjectArrayElement(jenv, jmethods, i);
+		if (jmethod == NULL) {
+			ret = JY_EEXCEPTION;
+			break;
+		}
+
+		jstr = (jstring)(*jenv)->CallObjectMethod(jenv, jmethod, g_jyc_mid_to_string);
+		str = NULL;
+		if (jstr != NULL)
+			str = (*jenv)->GetStringUTFChars(jenv, jstr, 0);
+		if (str != NULL) {
+			ret = jyc_add_method(jenv, cls, c, jmethod, str);
+			(*jenv)->ReleaseStringUTFChars(jenv, jstr, str);
+		} else
+			ret = JY_EEXCEPTION;
+
+		if (jstr != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jstr);
+		(*jenv)->DeleteLocalRef(jenv, jmethod);
+	}
+
+	(*jenv)->DeleteLocalRef(jenv, jmethods);
+
+	return ret;
+}
+
+/**
+ * Parses a "Field.toString()" string and adds the field to the getter list
+ * "fields" and, unless it is final, to the setter table of "c". Static
+ * fields, fields declared by Java itself and fields of unsupported types are
+ * ignored.
+ *
+ * @param jfield The "java.lang.reflect.Field" of the field.
+ */
+static int
+jyc_add_field(JNIEnv *jenv, jclass cls, struct st_jyc *c, struct st_llhead *fields, jobject jfield, const char *str)
+{
+	const char *ptype, *pname;
+	struct st_method_ll *m;
+	struct st_jyc_setter *s;
+	char *sign;
+	int type;
+
+	ptype = jyc_method_str_get_type(str);
+	if ((ptype == NULL) || jyc_method_str_is_static(str))
+		return JY_ESUCCESS;
+
+	pname = strchr(ptype, ' ');
+	if (pname == NULL)
+		return JY_EEINVAL;
+	pname++;
+	if ((strncmp(pname, "java.", 5) == 0) || (strncmp(pname, "javax.", 6) == 0))
+		return JY_ESUCCESS;
+	if (strrchr(pname, '.') != NULL)
+		pname = strrchr(pname, '.') + 1;
+
+	type = jyc_str_get_type_sign(ptype, &sign);
+	if (type == JY_EENOMEM)
+		return JY_EENOMEM;
+	if (type < 0)
+		return JY_ESUCCESS;
+
+	m = llalloc(sizeof(struct st_method_ll));
+	if (m == NULL) {
+		free(sign);
+		return JY_EENOMEM;
+	}
+	memset(m, 0, sizeof(struct st_method_ll));
+	m->sign = sign;
+	m->rettype = type;
+	m->name = strdup(pname);
+	m->sym = jys_intern(pname);
+	if ((m->name == NULL) || (m->sym == NULL)) {
+		jyc_free_method(m);
+		return JY_EENOMEM;
+	}
+
+	if (!jyc_getter_selected(jenv, c, m, jfield, JY_TRUE)) {
+		jyc_free_method(m);
+		return JY_ESUCCESS;
+	}
+
+	m->jfid = (*jenv)->GetFieldID(jenv, cls, m->name, m->sign);
+	if ((m->jfid == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Could not get field id of \"%s\" at \"%s:%d\".\n", m->name, __FILE__, __LINE__);
+#endif
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+		}
+		fflush(stderr);
+		jyc_free_method(m);
+
+		return JY_EEINVAL;
+	}
+
+	if (!jyc_method_str_has_modifier(str, "final ")) {
+		s = malloc(sizeof(struct st_jyc_setter));
+		if (s == NULL) {
+			jyc_free_method(m);
+			return JY_EENOMEM;
+		}
+		memset(s, 0, sizeof(struct st_jyc_setter));
+		s->name = strdup(m->name);
+		s->psign = strdup(m->sign);
+		if ((s->name == NULL) || (s->psign == NULL)) {
+			free(s->name);
+			free(s->psign);
+			free(s);
+			jyc_free_method(m);
+			return JY_EENOMEM;
+		}
+		s->sym = m->sym;
+		s->ptype = type;
+		s->rettype = JYO_TVOID;
+		s->jfid = m->jfid;
+
+		jyc_insert_setter(c, s);
+	}
+
+	llh_append(fields, m);
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Adds the public instance fields of "cls" to the getter list and the setter
+ * table of "c".
+ */
+static int
+jyc_get_field_list(JNIEnv *jenv, jclass cls, struct st_jyc *c)
+{
+	struct st_llhead fields = LLHEAD_INITIALIZER;
+	jobjectArray jfields;
+	jobject jfield;
+	jstring jstr;
+	const char *str;
+	jsize i, len;
+	int ret;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(cls != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(c != NULL, JY_EEINVAL);
+
+	jfields = (jobjectArray)(*jenv)->CallObjectMethod(jenv, cls, g_jyc_mid_get_fields);
+	if ((jfields == NULL) || (*jenv)->ExceptionCheck(jenv))
+		return JY_EEXCEPTION;
+
+	ret = JY_ESUCCESS;
+	len = (*jenv)->GetArrayLength(jenv, jfields);
+	for (i = 0; (i < len) && (ret == JY_ESUCCESS); i++) {
+		jfield = (*jenv)->GetObjectArrayElement(jenv, jfields, i);
+		if (jfield == NULL) {
+			ret = JY_EEXCEPTION;
+			break;
+		}
+
+		jstr = (jstring)(*jenv)->CallObjectMethod(jenv, jfield, g_jyc_mid_field_to_string);
+		str = NULL;
+		if (jstr != NULL)
+			str = (*jenv)->GetStringUTFChars(jenv, jstr, 0);
+		if (str != NULL) {
+			ret = jyc_add_field(jenv, cls, c, &fields, jfield, str);
+			(*jenv)->ReleaseStringUTFChars(jenv, jstr, str);
+		} else
+			ret = JY_EEXCEPTION;
+
+		if (jstr != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jstr);
+		(*jenv)->DeleteLocalRef(jenv, jfield);
+	}
+
+	(*jenv)->DeleteLocalRef(jenv, jfields);
+
+	/* The fields go after the getter methods. */
+	if (ret == JY_ESUCCESS)
+		llh_splice(&c->getters, &fields);
+	else
+		jyc_free_method_ll(&fields);
+
+	return ret;
+}
+
+/**
+ * Creates a global reference of the class "clazz" and stores it in "jcls".
+ */
+static int
+jyc_jinit_class(JNIEnv *jenv, const char *clazz, jclass *jcls)
+{
+	jclass jlocal;
+
+	jlocal = (*jenv)->FindClass(jenv, clazz);
+	if ((jlocal == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Could not find class \"%s\".\n", clazz);
+#endif
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+		}
+		fflush(stderr);
+
+		if (jlocal != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jlocal);
+
+		return JY_ENOJCLASS;
+	}
+
+	*jcls = (*jenv)->NewGlobalRef(jenv, jlocal);
+	(*jenv)->DeleteLocalRef(jenv, jlocal);
+	if (*jcls == NULL)
+		return JY_EENOMEM;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Resolves the reflection classes and methods used by this module.
+ */
+static int
+jyc_jinit(JNIEnv *jenv)
+{
+	int ret;
+
+	(void)pthread_mutex_lock(&g_jyc_jinit_mutex);
+
+	if (g_jyc_mid_identity_hash != NULL) {
+		(void)pthread_mutex_unlock(&g_jyc_jinit_mutex);
+		return JY_ESUCCESS;
+	}
+
+	ret = JY_ESUCCESS;
+	if (g_jyc_jsystem == NULL)
+		ret = jyc_jinit_class(jenv, "java/lang/System", &g_jyc_jsystem);
+	if ((ret == JY_ESUCCESS) && (g_jyc_jclass == NULL))
+		ret = jyc_jinit_class(jenv, "java/lang/Class", &g_jyc_jclass);
+	if ((ret == JY_ESUCCESS) && (g_jyc_jmethod == NULL))
+		ret = jyc_jinit_class(jenv, "java/lang/reflect/Method", &g_jyc_jmethod);
+	if ((ret == JY_ESUCCESS) && (g_jyc_jfield == NULL))
+		ret = jyc_jinit_class(jenv, "java/lang/reflect/Field", &g_jyc_jfield);
+	if (ret != JY_ESUCCESS) {
+		(void)pthread_mutex_unlock(&g_jyc_jinit_mutex);
+		return ret;
+	}
+
+	g_jyc_mid_get_name = (*jenv)->GetMethodID(jenv, g_jyc_jclass, "getName", "()Ljava/lang/String;");
+	g_jyc_mid_get_methods = (*jenv)->GetMethodID(jenv, g_jyc_jclass, "getMethods", "()[Ljava/lang/reflect/Method;");
+	g_jyc_mid_to_string = (*jenv)->GetMethodID(jenv, g_jyc_jmethod, "toString", "()Ljava/lang/String;");
+	g_jyc_mid_get_fields = (*jenv)->GetMethodID(jenv, g_jyc_jclass, "getFields", "()[Ljava/lang/reflect/Field;");
+	g_jyc_mid_field_to_string = (*jenv)->GetMethodID(jenv, g_jyc_jfield, "toString", "()Ljava/lang/String;");
+	if ((g_jyc_mid_get_name == NULL) || (g_jyc_mid_get_methods == NULL) ||
+	    (g_jyc_mid_to_string == NULL) || (g_jyc_mid_get_fields == NULL) ||
+	    (g_jyc_mid_field_to_string == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+			fflush(stderr);
+		}
+		(void)pthread_mutex_unlock(&g_jyc_jinit_mutex);
+		return JY_ENOTFOUND;
+	}
+
+	/* The annotation is only needed by JYC_FANNOTATED classes, so it is not
+	 * an error if the Java side was built without it. */
+	if ((g_jyc_jproperty == NULL) &&
+	    (jyc_jinit_class(jenv, "com/googlecode/jnyikes/Property", &g_jyc_jproperty) == JY_ESUCCESS)) {
+		g_jyc_mid_is_annotation_present = (*jenv)->GetMethodID(jenv, g_jyc_jmethod, "isAnnotationPresent", "(Ljava/lang/Class;)Z");
+		g_jyc_mid_field_is_annotation_present = (*jenv)->GetMethodID(jenv, g_jyc_jfield, "isAnnotationPresent", "(Ljava/lang/Class;)Z");
+		if ((g_jyc_mid_is_annotation_present == NULL) ||
+		    (g_jyc_mid_field_is_annotation_present == NULL) ||
+		    (*jenv)->ExceptionCheck(jenv)) {
+			if ((*jenv)->ExceptionCheck(jenv)) {
+				(*jenv)->ExceptionDescribe(jenv);
+				(*jenv)->ExceptionClear(jenv);
+				fflush(stderr);
+			}
+			(*jenv)->DeleteGlobalRef(jenv, g_jyc_jproperty);
+			g_jyc_jproperty = NULL;
+			g_jyc_mid_is_annotation_present = NULL;
+			g_jyc_mid_field_is_annotation_present = NULL;
+		}
+	}
+
+	/* This one is tested without the lock: it must be the last one set. */
+	__sync_synchronize();
+	g_jyc_mid_identity_hash = (*jenv)->GetStaticMethodID(jenv, g_jyc_jsystem, "identityHashCode", "(Ljava/lang/Object;)I");
+	if ((g_jyc_mid_identity_hash == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+			fflush(stderr);
+		}
+		g_jyc_mid_identity_hash = NULL;
+		(void)pthread_mutex_unlock(&g_jyc_jinit_mutex);
+		return JY_ENOTFOUND;
+	}
+
+	(void)pthread_mutex_unlock(&g_jyc_jinit_mutex);
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Gets the name of a Java class, as returned by "Class.getName()".
+ *
+ * @return A dynamically allocated string or NULL in case of error.
+ */
+static char *
+jyc_get_jclass_name(JNIEnv *jenv, jclass jcls)
+{
+	jstring _name;
+	const char *str;
+	char *ret;
+
+	JY_ASSERT_RETURN(jenv != NULL, NULL);
+	JY_ASSERT_RETURN(jcls != NULL, NULL);
+
+	_name = (jstring)(*jenv)->CallObjectMethod(jenv, jcls, g_jyc_mid_get_name);
+	if ((_name == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+			fflush(stderr);
+		}
+		(*jenv)->DeleteLocalRef(jenv, _name);
+		return NULL;
+	}
+
+	str = (*jenv)->GetStringUTFChars(jenv, _name, 0);
+	if (str == NULL) {
+		(*jenv)->DeleteLocalRef(jenv, _name);
+		return NULL;
+	}
+
+	ret = strdup(str);
+
+	(*jenv)->ReleaseStringUTFChars(jenv, _name, str);
+	(*jenv)->DeleteLocalRef(jenv, _name);
+
+	return ret;
+}
+
+/**
+ * Frees a descriptor and everything it holds.
+ */
+static void
+jyc_free(JNIEnv *jenv, struct st_jyc *c)
+{
+	JY_ASSERT_RETURN_VOID(c != NULL);
+
+	if (c->jcls != NULL)
+		(*jenv)->DeleteWeakGlobalRef(jenv, c->jcls);
+	if (c->name != NULL)
+		free(c->name);
+	jyc_free_method_ll(&c->getters);
+	jyc_free_setters(c);
+	jyc_strv_free(c->allow);
+	jyc_strv_free(c->deny);
+	jystr_free(jenv, c->strings);
+
+	free(c);
+}
+
+/**
+ * Builds the shape of the objects made by jyo_j2p() from "c", one slot per
+ * getter. Classes with getters a shape can't store are left without one.
+ */
+static void
+jyc_build_shape(struct st_jyc *c)
+{
+	struct st_jyo_shape *shape;
+	const struct st_method_ll *m;
+	enum e_jyo_type type;
+
+	if (c->getters.len == 0)
+		return;
+
+	if (jyo_shape_new(c->name, c->getters.len, &shape) != JY_ESUCCESS)
+		return;
+
+	for (m = (const struct st_method_ll *)c->getters.first; m != NULL;
+	    m = (const struct st_method_ll *)m->ll.next) {
+		/* Object getters are converted into JYO_TJYO properties. */
+		type = m->rettype == JYO_TJCLASS ? JYO_TJYO : m->rettype;
+		if (jyo_shape_add(shape, m->sym, type) != JY_ESUCCESS) {
+			jyo_shape_free(shape);
+			return;
+		}
+	}
+
+	c->shape = jyo_shape_intern(shape);
+}
+
+/**
+ * Builds the descriptor of "jcls" by introspecting it.
+ */
+static int
+jyc_build(JNIEnv *jenv, jclass jcls, jint hash, struct st_jyc **c)
+{
+	int ret;
+
+	*c = malloc(sizeof(struct st_jyc));
+	if (*c == NULL)
+		return JY_EENOMEM;
+	memset(*c, 0, sizeof(struct st_jyc));
+
+	(*c)->hash = hash;
+	(*c)->refcnt = 1;
+
+	(*c)->jcls = (*jenv)->NewWeakGlobalRef(jenv, jcls);
+	if ((*c)->jcls == NULL) {
+		jyc_free(jenv, *c);
+		*c = NULL;
+		return JY_EENOMEM;
+	}
+
+	(*c)->name = jyc_get_jclass_name(jenv, jcls);
+	if ((*c)->name == NULL) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Could not get class name at \"%s:%d\".\n", __FILE__, __LINE__);
+		fflush(stderr);
+#endif
+		jyc_free(jenv, *c);
+		*c = NULL;
+		return JY_EEINVAL;
+	}
+
+	ret = jyc_get_opts(*c);
+	if ((ret == JY_ESUCCESS) && (((*c)->flags & JYC_FSTRINGS) != 0))
+		ret = jystr_new(JYC_STRING_CACHE_SIZE, &(*c)->strings);
+	if (ret != JY_ESUCCESS) {
+		jyc_free(jenv, *c);
+		*c = NULL;
+		return ret;
+	}
+
+	/* The constructor without parameters, if there is one. */
+	(*c)->ctor = (*jenv)->GetMethodID(jenv, jcls, "<init>", "()V");
+	if ((*c)->ctor == NULL || (*jenv)->ExceptionCheck(jenv)) {
+		if ((*jenv)->ExceptionCheck(jenv))
+			(*jenv)->ExceptionClear(jenv);
+		(*c)->ctor = NULL;
+	}
+
+	/* Reflection makes many local references. They are all released with
+	 * this frame, whichever way the member lists are left. */
+	if ((*jenv)->PushLocalFrame(jenv, JYC_LOCAL_FRAME) != 0) {
+		(*jenv)->ExceptionClear(jenv);
+		jyc_free(jenv, *c);
+		*c = NULL;
+		return JY_EENOMEM;
+	}
+
+	/* Fills the getters list with the methods without parameters that
+	 * doesn't return void and the setters table with the methods with one
+	 * parameter. */
+	ret = jyc_get_method_lists(jenv, jcls, *c);
+	if ((ret == JY_ESUCCESS) && (((*c)->flags & JYC_FFIELDS) != 0))
+		ret = jyc_get_field_list(jenv, jcls, *c);
+
+	if (ret != JY_ESUCCESS) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Error %s while getting the members of class \"%s\" at \"%s:%d\".\n", jy_strerror(ret), (*c)->name, __FILE__, __LINE__);
+#endif
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+		}
+		fflush(stderr);
+	}
+
+	(void)(*jenv)->PopLocalFrame(jenv, NULL);
+
+	if (ret != JY_ESUCCESS) {
+		jyc_free(jenv, *c);
+		*c = NULL;
+		return ret;
+	}
+
+	jyc_build_shape(*c);
+
+	return JY_ESUCCESS;
+}
+
+static void
+jyc_mru_init(void)
+{
+	(void)pthread_key_create(&g_jyc_mru_key, free);
+}
+
+/**
+ * Gets the descriptors the calling thread got last, or NULL.
+ */
+static struct st_jyc_mru *
+jyc_mru_get(void)
+{
+	struct st_jyc_mru *mru;
+
+	(void)pthread_once(&g_jyc_mru_once, jyc_mru_init);
+
+	mru = pthread_getspecific(g_jyc_mru_key);
+	if (mru == NULL) {
+		mru = calloc(1, sizeof(struct st_jyc_mru));
+		if (mru == NULL)
+			return NULL;
+		if (pthread_setspecific(g_jyc_mru_key, mru) != 0) {
+			free(mru);
+			return NULL;
+		}
+	}
+
+	return mru;
+}
+
+/**
+ * Forgets the descriptors of "mru" if the tables changed since they were
+ * remembered. The cache lock must be held.
+ */
+static void
+jyc_mru_validate(struct st_jyc_mru *mru)
+{
+	if (mru->epoch != g_jyc_epoch) {
+		memset(mru->c, 0, sizeof(mru->c));
+		mru->epoch = g_jyc_epoch;
+	}
+}
+
+/**
+ * Looks "jcls" up among the descriptors the thread got last, moving it to the
+ * front if found. The cache lock must be held.
+ */
+static struct st_jyc *
+jyc_mru_lookup(JNIEnv *jenv, struct st_jyc_mru *mru, jclass jcls)
+{
+	struct st_jyc *c;
+	unsigned int i;
+
+	jyc_mru_validate(mru);
+	for (i = 0; (i < JYC_MRU_SIZE) && (mru->c[i] != NULL); i++) {
+		if (!(*jenv)->IsSameObject(jenv, mru->c[i]->jcls, jcls))
+			continue;
+
+		c = mru->c[i];
+		memmove(&mru->c[1], &mru->c[0], i * sizeof(mru->c[0]));
+		mru->c[0] = c;
+		return c;
+	}
+
+	return NULL;
+}
+
+/**
+ * Remembers "c", held by the tables, as got last by the thread, forgetting
+ * the least recently used descriptor. The cache lock must be held.
+ */
+static void
+jyc_mru_insert(struct st_jyc_mru *mru, struct st_jyc *c)
+{
+	jyc_mru_validate(mru);
+	memmove(&mru->c[1], &mru->c[0], (JYC_MRU_SIZE - 1) * sizeof(mru->c[0]));
+	mru->c[0] = c;
+}
+
+/**
+ * Looks "jcls" up in its hash bucket. The cache lock must be held.
+ *
+ * @param stale Incremented for each unloaded class found in the bucket.
+ */
+static struct st_jyc *
+jyc_lookup(JNIEnv *jenv, jclass jcls, jint hash, int *stale)
+{
+	struct st_jyc *c;
+
+	for (c = g_jyc_table[hash & (JYC_HASH_SIZE - 1)]; c != NULL; c = c->next) {
+		if (c->hash != hash)
+			continue;
+		if ((*jenv)->IsSameObject(jenv, c->jcls, jcls))
+			return c;
+		if ((*jenv)->IsSameObject(jenv, c->jcls, NULL))
+			(*stale)++;
+	}
+
+	return NULL;
+}
+
+/**
+ * Gets the descriptor of a Java class, building and caching it on first use.
+ *
+ * Every successful call must be paired with a jyc_release() call.
+ *
+ * @param jcls The Java class.
+ * @param c Where the descriptor will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyc_get(JNIEnv *jenv, jclass jcls, struct st_jyc **c)
+{
+	struct st_jyc_mru *mru;
+	struct st_jyc *cnew;
+	jint hash;
+	int ret, stale;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(jcls != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(c != NULL, JY_EEINVAL);
+
+	*c = NULL;
+
+	if (g_jyc_mid_identity_hash == NULL) {
+		ret = jyc_jinit(jenv);
+		if (ret != JY_ESUCCESS)
+			return ret;
+	}
+
+	/* Fastest path: the thread got the class last, no upcall needed. */
+	mru = jyc_mru_get();
+	if (mru != NULL) {
+		(void)pthread_rwlock_rdlock(&g_jyc_lock);
+		*c = jyc_mru_lookup(jenv, mru, jcls);
+		if (*c != NULL)
+			__sync_fetch_and_add(&(*c)->refcnt, 1);
+		(void)pthread_rwlock_unlock(&g_jyc_lock);
+		if (*c != NULL)
+			return JY_ESUCCESS;
+	}
+
+	hash = (*jenv)->CallStaticIntMethod(jenv, g_jyc_jsystem, g_jyc_mid_identity_hash, jcls);
+	if ((*jenv)->ExceptionCheck(jenv)) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+		return JY_EEXCEPTION;
+	}
+
+	/* Fast path: the class is already known. */
+	stale = 0;
+	(void)pthread_rwlock_rdlock(&g_jyc_lock);
+	*c = jyc_lookup(jenv, jcls, hash, &stale);
+	if (*c != NULL) {
+		__sync_fetch_and_add(&(*c)->refcnt, 1);
+		if (mru != NULL)
+			jyc_mru_insert(mru, *c);
+	}
+	(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+	if (stale > 0)
+		jyc_purge(jenv);
+	if (*c != NULL)
+		return JY_ESUCCESS;
+
+	/* Slow path: introspect the class without holding the lock. */
+	ret = jyc_build(jenv, jcls, hash, &cnew);
+	if (ret != JY_ESUCCESS)
+		return ret;
+
+	(void)pthread_rwlock_wrlock(&g_jyc_lock);
+	*c = jyc_lookup(jenv, jcls, hash, &stale);
+	if (*c == NULL) {
+		/* One reference for the cache, another for the caller. */
+		cnew->refcnt = 2;
+		cnew->next = g_jyc_table[hash & (JYC_HASH_SIZE - 1)];
+		g_jyc_table[hash & (JYC_HASH_SIZE - 1)] = cnew;
+		*c = cnew;
+		cnew = NULL;
+	} else {
+		/* Another thread was faster. */
+		__sync_fetch_and_add(&(*c)->refcnt, 1);
+	}
+	if (mru != NULL)
+		jyc_mru_insert(mru, *c);
+	(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+	if (cnew != NULL)
+		jyc_free(jenv, cnew);
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Compares the parameter signature of a setter with "clazz", where '.' and '/'
+ * are considered equal.
+ */
+static jy_bool
+jyc_psign_is_class(const char *psign, const char *clazz)
+{
+	if (*psign++ != 'L')
+		return JY_FALSE;
+
+	for (; (*clazz != '\000') && (*psign != ';'); clazz++, psign++) {
+		if ((*psign != *clazz) &&
+		    !((*psign == '/') && (*clazz == '.')))
+			return JY_FALSE;
+	}
+
+	return (*clazz == '\000') && (*psign == ';');
+}
+
+/**
+ * Checks if a setter parameter accepts the data type "type".
+ *
+ * @param clazz The class name of JYO_TJYO data. NULL accepts any class.
+ */
+static jy_bool
+jyc_setter_accepts(const struct st_jyc_setter *s, enum e_jyo_type type, const char *clazz)
+{
+	switch (type) {
+		case JYO_TBOOLEAN:
+		case JYO_TBYTE:
+		case JYO_TCHAR:
+		case JYO_TSHORT:
+		case JYO_TINT:
+		case JYO_TLONG:
+		case JYO_TFLOAT:
+		case JYO_TDOUBLE:
+		case JYO_TSTRING:
+		case JYO_TBYTEARRAY:
+		case JYO_TSHORTARRAY:
+		case JYO_TINTARRAY:
+		case JYO_TLONGARRAY:
+		case JYO_TFLOATARRAY:
+		case JYO_TDOUBLEARRAY:
+		case JYO_TBLOB:
+			return s->ptype == (int)type;
+		case JYO_TVOID:
+			return s->ptype == JYO_TVOID;
+		case JYO_TUINT:
+			return s->ptype == JYO_TINT;
+		case JYO_TULONG:
+			return s->ptype == JYO_TLONG;
+		case JYO_TJYO:
+		case JYO_TJCLASS:
+			if (s->ptype != JYO_TJCLASS)
+				return JY_FALSE;
+			return (clazz == NULL) || jyc_psign_is_class(s->psign, clazz);
+		default:
+			return JY_FALSE;
+	}
+}
+
+/**
+ * Finds the setter "name" accepting "type" with a "void" return, or else with
+ * a "boolean" return.
+ */
+static const struct st_jyc_setter *
+jyc_find_setter(const struct st_jyc *c, const struct st_jys *name, enum e_jyo_type type, const char *clazz)
+{
+	const struct st_jyc_setter *s, *sbool;
+
+	sbool = NULL;
+	for (s = c->setters[name->hash & (JYC_SETTER_HASH_SIZE - 1)];
+	    s != NULL; s = s->next) {
+		if ((s->sym != name) ||
+		    !jyc_setter_accepts(s, type, clazz))
+			continue;
+		if (s->rettype == JYO_TVOID)
+			return s;
+		if (sbool == NULL)
+			sbool = s;
+	}
+
+	return sbool;
+}
+
+/**
+ * Gets the descriptor of a Java class by its name, finding the class and
+ * building the descriptor on first use.
+ *
+ * Every successful call must be paired with a jyc_release() call.
+ *
+ * @param clazz The class name, as passed to "FindClass()".
+ * @param c Where the descriptor will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyc_get_by_name(JNIEnv *jenv, const char *clazz, struct st_jyc **c)
+{
+	struct st_jyc_name *n;
+	unsigned int h;
+	jclass jcls;
+	int ret, stale;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(c != NULL, JY_EEINVAL);
+
+	*c = NULL;
+	h = jy_strhash(clazz) & (JYC_HASH_SIZE - 1);
+
+	/* Fast path: the name is already known. */
+	stale = 0;
+	(void)pthread_rwlock_rdlock(&g_jyc_lock);
+	for (n = g_jyc_names[h]; n != NULL; n = n->next) {
+		if (strcmp(n->name, clazz) != 0)
+			continue;
+		if ((*jenv)->IsSameObject(jenv, n->c->jcls, NULL)) {
+			stale++;
+			continue;
+		}
+		*c = n->c;
+		__sync_fetch_and_add(&(*c)->refcnt, 1);
+		break;
+	}
+	(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+	if (stale > 0)
+		jyc_purge(jenv);
+	if (*c != NULL)
+		return JY_ESUCCESS;
+
+	/* Slow path: find the class and index its descriptor by name. */
+	jcls = (*jenv)->FindClass(jenv, clazz);
+	if ((jcls == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Could not find class \"%s\".\n", clazz);
+#endif
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+		}
+		fflush(stderr);
+
+		if (jcls != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jcls);
+
+		return JY_ENOJCLASS;
+	}
+
+	ret = jyc_get(jenv, jcls, c);
+	(*jenv)->DeleteLocalRef(jenv, jcls);
+	if (ret != JY_ESUCCESS)
+		return ret;
+
+	n = malloc(sizeof(struct st_jyc_name));
+	if (n == NULL)
+		return JY_ESUCCESS;	/* Not indexed, but usable. */
+	n->name = strdup(clazz);
+	if (n->name == NULL) {
+		free(n);
+		return JY_ESUCCESS;
+	}
+	n->c = *c;
+
+	(void)pthread_rwlock_wrlock(&g_jyc_lock);
+	for (n->next = g_jyc_names[h]; n->next != NULL; n->next = n->next->next)
+		if (strcmp(n->next->name, clazz) == 0)
+			break;
+	if (n->next == NULL) {
+		__sync_fetch_and_add(&(*c)->refcnt, 1);
+		n->next = g_jyc_names[h];
+		g_jyc_names[h] = n;
+		n = NULL;
+	}
+	(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+	/* Another thread was faster. */
+	if (n != NULL) {
+		free(n->name);
+		free(n);
+	}
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Creates a new object of the class of "c", calling its constructor without
+ * parameters or, for JYC_FALLOC classes, just allocating it.
+ *
+ * @param jobj Where the new local reference will be returned.
+ *
+ * @return A "e_jy_err" error code. JY_ENOJCLASS if the class has been
+ * unloaded, JY_ENOTFOUND if it has no constructor without parameters.
+ */
+int
+jyc_new_object(JNIEnv *jenv, const struct st_jyc *c, jobject *jobj)
+{
+	jclass jcls;
+
+	JY_ASSERT_RETURN(jobj != NULL, JY_EEINVAL);
+	*jobj = NULL;
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(c != NULL, JY_EEINVAL);
+
+	jcls = (*jenv)->NewLocalRef(jenv, c->jcls);
+	if (jcls == NULL)
+		return JY_ENOJCLASS;
+
+	if ((c->flags & JYC_FALLOC) != 0)
+		*jobj = (*jenv)->AllocObject(jenv, jcls);
+	else if (c->ctor != NULL)
+		*jobj = (*jenv)->NewObject(jenv, jcls, c->ctor);
+	else {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Class \"%s\" has no constructor without parameters.\n", c->name);
+		fflush(stderr);
+#endif
+		(*jenv)->DeleteLocalRef(jenv, jcls);
+		return JY_ENOTFOUND;
+	}
+	(*jenv)->DeleteLocalRef(jenv, jcls);
+
+	if ((*jenv)->ExceptionCheck(jenv)) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+		if (*jobj != NULL)
+			(*jenv)->DeleteLocalRef(jenv, *jobj);
+		*jobj = NULL;
+		return JY_EEXCEPTION;
+	}
+
+	return *jobj != NULL ? JY_ESUCCESS : JY_EENOMEM;
+}
+
+/**
+ * Finds the options of the class "name", creating them if needed. The cache
+ * lock must be held for writing.
+ */
+static struct st_jyc_opts *
+jyc_opts_get_locked(const char *name)
+{
+	struct st_jyc_opts *o;
+	unsigned int h;
+
+	h = jy_strhash(name) & (JYC_HASH_SIZE - 1);
+	for (o = g_jyc_opts[h]; o != NULL; o = o->next)
+		if (strcmp(o->name, name) == 0)
+			return o;
+
+	o = malloc(sizeof(struct st_jyc_opts));
+	if (o == NULL)
+		return NULL;
+	memset(o, 0, sizeof(struct st_jyc_opts));
+
+	o->name = strdup(name);
+	if (o->name == NULL) {
+		free(o);
+		return NULL;
+	}
+	o->flags = g_jyc_default_flags;
+
+	o->next = g_jyc_opts[h];
+	g_jyc_opts[h] = o;
+
+	return o;
+}
+
+/**
+ * Duplicates a class name, converting it to the '.' package separator.
+ */
+static char *
+jyc_dup_dotted(const char *clazz)
+{
+	char *name;
+
+	name = strdup(clazz);
+	if (name != NULL)
+		jyc_java_convert_str(name, '/', '.');
+
+	return name;
+}
+
+/**
+ * Sets the flags of a class. Descriptors already built for the class are
+ * dropped, so the new flags apply to every object converted afterwards.
+ *
+ * @param clazz The class name, with '.' or '/' as package separator. NULL
+ * sets the flags of the classes without flags of their own.
+ * @param flags A combination of "e_jyc_flag" values.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyc_set_flags(JNIEnv *jenv, const char *clazz, unsigned int flags)
+{
+	struct st_jyc_opts *o;
+	char *name;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+
+	if (clazz == NULL) {
+		(void)pthread_rwlock_wrlock(&g_jyc_lock);
+		g_jyc_default_flags = flags;
+		(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+		jyc_drop(jenv, JY_TRUE, NULL);
+		(void)__sync_add_and_fetch(&g_jyc_generation, 1);
+		return JY_ESUCCESS;
+	}
+
+	name = jyc_dup_dotted(clazz);
+	if (name == NULL)
+		return JY_EENOMEM;
+
+	(void)pthread_rwlock_wrlock(&g_jyc_lock);
+	o = jyc_opts_get_locked(name);
+	if (o != NULL)
+		o->flags = flags;
+	(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+	if (o != NULL) {
+		jyc_drop(jenv, JY_FALSE, name);
+		(void)__sync_add_and_fetch(&g_jyc_generation, 1);
+	}
+	free(name);
+
+	return o != NULL ? JY_ESUCCESS : JY_EENOMEM;
+}
+
+/**
+ * Sets which getters of a class are converted by jyo_j2p(), overriding the
+ * JYC_FBEAN and JYC_FANNOTATED flags. Descriptors already built for the class
+ * are dropped.
+ *
+ * @param clazz The class name, with '.' or '/' as package separator.
+ * @param allow NULL terminated list of the only getters to be called or NULL
+ * to apply the class flags.
+ * @param deny NULL terminated list of getters never to be called or NULL.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyc_set_getters(JNIEnv *jenv, const char *clazz, char *const *allow, char *const *deny)
+{
+	struct st_jyc_opts *o;
+	char **allow_dup, **deny_dup;
+	char *name;
+	int ret;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
+
+	ret = jyc_strv_dup(allow, &allow_dup);
+	if (ret != JY_ESUCCESS)
+		return ret;
+	ret = jyc_strv_dup(deny, &deny_dup);
+	if (ret != JY_ESUCCESS) {
+		jyc_strv_free(allow_dup);
+		return ret;
+	}
+
+	name = jyc_dup_dotted(clazz);
+	if (name == NULL) {
+		jyc_strv_free(allow_dup);
+		jyc_strv_free(deny_dup);
+		return JY_EENOMEM;
+	}
+
+	(void)pthread_rwlock_wrlock(&g_jyc_lock);
+	o = jyc_opts_get_locked(name);
+	if (o != NULL) {
+		jyc_strv_free(o->allow);
+		jyc_strv_free(o->deny);
+		o->allow = allow_dup;
+		o->deny = deny_dup;
+	}
+	(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+	if (o != NULL) {
+		jyc_drop(jenv, JY_FALSE, name);
+		(void)__sync_add_and_fetch(&g_jyc_generation, 1);
+	} else {
+		jyc_strv_free(allow_dup);
+		jyc_strv_free(deny_dup);
+	}
+	free(name);
+
+	return o != NULL ? JY_ESUCCESS : JY_EENOMEM;
+}
+
+/**
+ * Gets the generation of the class options, bumped by every jyc_set_flags(),
+ * jyc_set_getters() and jyc_flush() call once the descriptors they affect
+ * are dropped. Anything derived from descriptors read after a generation was
+ * taken is stale as soon as the generation changes.
+ */
+unsigned int
+jyc_generation(void)
+{
+	return __sync_add_and_fetch(&g_jyc_generation, 0);
+}
+
+/**
+ * Resolves the setter of a property.
+ *
+ * The setter table holds every setter of the class, so no JNI call is made
+ * and a missing setter costs just a hash lookup. Setters taking exactly the
+ * property type are preferred; "java.lang.Object" setters are accepted for
+ * JYO_TJYO properties.
+ *
+ * @param name The interned setter name.
+ * @param type The property data type.
+ * @param clazz The class name of JYO_TJYO properties or NULL.
+ * @param s Where the setter will be returned.
+ *
+ * @return JY_ESUCCESS or JY_ENOTFOUND.
+ */
+int
+jyc_get_setter(const struct st_jyc *c, const struct st_jys *name, enum e_jyo_type type, const char *clazz, const struct st_jyc_setter **s)
+{
+	JY_ASSERT_RETURN(c != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(name != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(s != NULL, JY_EEINVAL);
+
+	*s = jyc_find_setter(c, name, type, clazz);
+	if ((*s == NULL) && (type == JYO_TJYO))
+		*s = jyc_find_setter(c, name, JYO_TJCLASS, "java.lang.Object");
+
+	return *s != NULL ? JY_ESUCCESS : JY_ENOTFOUND;
+}
+
+/**
+ * Releases a descriptor returned by jyc_get() or jyc_get_by_name().
+ */
+void
+jyc_release(JNIEnv *jenv, struct st_jyc *c)
+{
+	JY_ASSERT_RETURN_VOID(jenv != NULL);
+	JY_ASSERT_RETURN_VOID(c != NULL);
+
+	if (__sync_sub_and_fetch(&c->refcnt, 1) == 0)
+		jyc_free(jenv, c);
+}
+
+/**
+ * Checks if the descriptor "c" must be dropped by jyc_drop().
+ */
+static jy_bool
+jyc_must_drop(JNIEnv *jenv, const struct st_jyc *c, jy_bool all, const char *name)
+{
+	if (all)
+		return JY_TRUE;
+	if ((name != NULL) && (strcmp(c->name, name) == 0))
+		return JY_TRUE;
+
+	/* Was the class unloaded? */
+	return (*jenv)->IsSameObject(jenv, c->jcls, NULL);
+}
+
+/**
+ * Unlinks the descriptors whose class was unloaded, whose class is "name" or
+ * all of them if "all" is true.
+ */
+static void
+jyc_drop(JNIEnv *jenv, jy_bool all, const char *name)
+{
+	struct st_jyc **pc, *c, *dropped;
+	struct st_jyc_name **pn, *n, *ndropped;
+	int i;
+
+	dropped = NULL;
+	ndropped = NULL;
+
+	(void)pthread_rwlock_wrlock(&g_jyc_lock);
+	for (i = 0; i < JYC_HASH_SIZE; i++) {
+		for (pc = &g_jyc_table[i]; *pc != NULL; ) {
+			c = *pc;
+			if (jyc_must_drop(jenv, c, all, name)) {
+				*pc = c->next;
+				c->next = dropped;
+				dropped = c;
+				g_jyc_epoch++;
+			} else
+				pc = &c->next;
+		}
+
+		for (pn = &g_jyc_names[i]; *pn != NULL; ) {
+			n = *pn;
+			if (jyc_must_drop(jenv, n->c, all, name)) {
+				*pn = n->next;
+				n->next = ndropped;
+				ndropped = n;
+			} else
+				pn = &n->next;
+		}
+	}
+	(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+	/* Drop the references held by the tables. */
+	while (dropped != NULL) {
+		c = dropped;
+		dropped = c->next;
+		c->next = NULL;
+		jyc_release(jenv, c);
+	}
+	while (ndropped != NULL) {
+		n = ndropped;
+		ndropped = n->next;
+		jyc_release(jenv, n->c);
+		free(n->name);
+		free(n);
+	}
+}
+
+/**
+ * Drops the descriptors of every Java class which has been unloaded.
+ */
+void
+jyc_purge(JNIEnv *jenv)
+{
+	JY_ASSERT_RETURN_VOID(jenv != NULL);
+
+	jyc_drop(jenv, JY_FALSE, NULL);
+}
+
+/**
+ * Drops every cached descriptor, the options set by jyc_set_flags() and
+ * jyc_set_getters() and the references held by the cache.
+ */
+void
+jyc_flush(JNIEnv *jenv)
+{
+	struct st_jyc_opts *o;
+	int i;
+
+	JY_ASSERT_RETURN_VOID(jenv != NULL);
+
+	jyc_drop(jenv, JY_TRUE, NULL);
+
+	(void)pthread_rwlock_wrlock(&g_jyc_lock);
+	for (i = 0; i < JYC_HASH_SIZE; i++) {
+		while (g_jyc_opts[i] != NULL) {
+			o = g_jyc_opts[i];
+			g_jyc_opts[i] = o->next;
+			jyc_strv_free(o->allow);
+			jyc_strv_free(o->deny);
+			free(o->name);
+			free(o);
+		}
+	}
+	g_jyc_default_flags = 0;
+	(void)pthread_rwlock_unlock(&g_jyc_lock);
+
+	(void)__sync_add_and_fetch(&g_jyc_generation, 1);
+
+	(void)pthread_mutex_lock(&g_jyc_jinit_mutex);
+	g_jyc_mid_identity_hash = NULL;
+	g_jyc_mid_get_name = NULL;
+	g_jyc_mid_get_methods = NULL;
+	g_jyc_mid_to_string = NULL;
+	g_jyc_mid_is_annotation_present = NULL;
+	g_jyc_mid_get_fields = NULL;
+	g_jyc_mid_field_to_string = NULL;
+	g_jyc_mid_field_is_annotation_present = NULL;
+	if (g_jyc_jfield != NULL)
+		(*jenv)->DeleteGlobalRef(jenv, g_jyc_jfield);
+	g_jyc_jfield = NULL;
+	if (g_jyc_jproperty != NULL)
+		(*jenv)->DeleteGlobalRef(jenv, g_jyc_jproperty);
+	g_jyc_jproperty = NULL;
+	if (g_jyc_jsystem != NULL)
+		(*jenv)->DeleteGlobalRef(jenv, g_jyc_jsystem);
+	if (g_jyc_jclass != NULL)
+		(*jenv)->DeleteGlobalRef(jenv, g_jyc_jclass);
+	if (g_jyc_jmethod != NULL)
+		(*jenv)->DeleteGlobalRef(jenv, g_jyc_jmethod);
+	g_jyc_jsystem = g_jyc_jclass = g_jyc_jmethod = NULL;
+	(void)pthread_mutex_unlock(&g_jyc_jinit_mutex);
+}
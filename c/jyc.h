@@ -0,0 +1,265 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_JYC_H_)
+#define _JYC_H_
+
+#include <jni.h>
+
+#include "jnyikes.h"
+#include "jyo.h"
+#include "llist.h"
+#include "jys.h"
+#include "jystr.h"
+
+/**
+ * A getter method of a Java class: no parameters, non "void" return.
+ */
+struct st_method_ll {
+	struct st_llist ll;
+	char *name;
+	/** The interned "name": the name of the fetched properties. */
+	const struct st_jys *sym;
+	char *sign;
+	int rettype;
+	jmethodID jmid;
+	/** The field read instead of calling "jmid", for field properties. */
+	jfieldID jfid;
+};
+
+/**
+ * Class flags, see jyc_set_flags().
+ */
+enum e_jyc_flag {
+	/**
+	 * The class constructor has no side effects: create objects with
+	 * "AllocObject()", without calling it.
+	 */
+	JYC_FALLOC	= 0x0001,
+	/**
+	 * Only JavaBeans getters are properties: "getX()", or "isX()"
+	 * returning "boolean". Keeps jyo_j2p() from calling methods like
+	 * "hashCode()" or "toString()" on every object.
+	 */
+	JYC_FBEAN	= 0x0002,
+	/**
+	 * Only getters annotated with "com.googlecode.jnyikes.Property" are
+	 * properties.
+	 */
+	JYC_FANNOTATED	= 0x0004,
+	/**
+	 * The public instance fields of the class are properties too, named
+	 * after the fields. They are read and written directly, without any
+	 * getter or setter call.
+	 */
+	JYC_FFIELDS	= 0x0008,
+	/**
+	 * The String properties set by jyo_p2j() reuse the Strings of a cache
+	 * of the class, which holds its JYC_STRING_CACHE_SIZE most recently
+	 * used values. Meant for classes whose strings repeat a small set of
+	 * values, like status codes or unit names.
+	 */
+	JYC_FSTRINGS	= 0x0010,
+};
+
+/** Number of Strings held by the cache of a JYC_FSTRINGS class. */
+#define JYC_STRING_CACHE_SIZE 256
+
+/**
+ * A setter method of a Java class: one parameter, "void" or "boolean" return.
+ * Field properties are setters without a method.
+ */
+struct st_jyc_setter {
+	/** Next setter of the same hash bucket. */
+	struct st_jyc_setter *next;
+	char *name;
+	/** The interned "name". */
+	const struct st_jys *sym;
+	/** The parameter signature, e.g. "I" or "Ljava/lang/String;". */
+	char *psign;
+	/** The parameter type: a "e_jyo_type", JYO_TJCLASS for objects. */
+	int ptype;
+	/** JYO_TVOID or JYO_TBOOLEAN. */
+	int rettype;
+	jmethodID jmid;
+	/** The field written instead of calling "jmid", for field properties. */
+	jfieldID jfid;
+};
+
+/** Number of buckets of the setter table of a class. Must be a power of 2. */
+#define JYC_SETTER_HASH_SIZE 32
+
+/**
+ * Java class descriptor.
+ *
+ * Holds everything the jyo APIs need to know about a Java class to convert its
+ * objects, so the reflection work is done once per class instead of once per
+ * object. Descriptors are created by jyc_get(), shared by all threads and
+ * must be treated as read only.
+ */
+struct st_jyc {
+	/** Next descriptor of the same hash bucket. */
+	struct st_jyc *next;
+	/** Identity hash code of the Java class. */
+	jint hash;
+	/**
+	 * Weak global reference to the Java class. It does not keep the class
+	 * from being unloaded; once it is, this reference compares equal to
+	 * NULL and the descriptor is dropped.
+	 */
+	jweak jcls;
+	/** The class name, as returned by "java.lang.Class.getName()". */
+	char *name;
+	/** The getter methods and fields of the class, a list of st_method_ll. */
+	struct st_llhead getters;
+	/**
+	 * The shape of the objects made by jyo_j2p() from the getters, or
+	 * NULL if some getter can't be stored in a shape.
+	 */
+	const struct st_jyo_shape *shape;
+	/** Every setter of the class, hashed by name. */
+	struct st_jyc_setter *setters[JYC_SETTER_HASH_SIZE];
+	/** The constructor without parameters or NULL. */
+	jmethodID ctor;
+	/** The "e_jyc_flag" flags of the class. */
+	unsigned int flags;
+	/** The String cache of JYC_FSTRINGS classes or NULL. */
+	struct st_jystr *strings;
+	/** Getter lists set by jyc_set_getters() or NULL. */
+	char **allow;
+	char **deny;
+	/** Reference counter. The cache itself holds one reference. */
+	unsigned int refcnt;
+};
+
+/**
+ * Gets the descriptor of a Java class, building and caching it on first use.
+ *
+ * Every successful call must be paired with a jyc_release() call.
+ *
+ * @param jcls The Java class.
+ * @param c Where the descriptor will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyc_get(JNIEnv *jenv, jclass jcls, struct st_jyc **c);
+
+/**
+ * Gets the descriptor of a Java class by its name, finding the class and
+ * building the descriptor on first use.
+ *
+ * Every successful call must be paired with a jyc_release() call.
+ *
+ * @param clazz The class name, as passed to "FindClass()".
+ * @param c Where the descriptor will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyc_get_by_name(JNIEnv *jenv, const char *clazz, struct st_jyc **c);
+
+/**
+ * Creates a new object of the class of "c", calling its constructor without
+ * parameters or, for JYC_FALLOC classes, just allocating it.
+ *
+ * @param jobj Where the new local reference will be returned.
+ *
+ * @return A "e_jy_err" error code. JY_ENOJCLASS if the class has been
+ * unloaded, JY_ENOTFOUND if it has no constructor without parameters.
+ */
+int jyc_new_object(JNIEnv *jenv, const struct st_jyc *c, jobject *jobj);
+
+/**
+ * Sets the flags of a class. Descriptors already built for the class are
+ * dropped, so the new flags apply to every object converted afterwards.
+ *
+ * @param clazz The class name, with '.' or '/' as package separator. NULL
+ * sets the flags of the classes without flags of their own.
+ * @param flags A combination of "e_jyc_flag" values.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyc_set_flags(JNIEnv *jenv, const char *clazz, unsigned int flags);
+
+/**
+ * Sets which getters of a class are converted by jyo_j2p(), overriding the
+ * JYC_FBEAN and JYC_FANNOTATED flags. Descriptors already built for the class
+ * are dropped.
+ *
+ * @param clazz The class name, with '.' or '/' as package separator.
+ * @param allow NULL terminated list of the only getters to be called or NULL
+ * to apply the class flags.
+ * @param deny NULL terminated list of getters never to be called or NULL.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyc_set_getters(JNIEnv *jenv, const char *clazz, char *const *allow, char *const *deny);
+
+/**
+ * Gets the generation of the class options, bumped by every jyc_set_flags(),
+ * jyc_set_getters() and jyc_flush() call once the descriptors they affect
+ * are dropped. Anything derived from descriptors read after a generation was
+ * taken is stale as soon as the generation changes.
+ */
+unsigned int jyc_generation(void);
+
+/**
+ * Releases a descriptor returned by jyc_get() or jyc_get_by_name().
+ */
+void jyc_release(JNIEnv *jenv, struct st_jyc *c);
+
+/**
+ * Resolves the setter of a property.
+ *
+ * The setter table holds every setter of the class, so no JNI call is made
+ * and a missing setter costs just a hash lookup. Setters taking exactly the
+ * property type are preferred; "java.lang.Object" setters are accepted for
+ * JYO_TJYO properties.
+ *
+ * @param name The interned setter name.
+ * @param type The property data type.
+ * @param clazz The class name of JYO_TJYO properties or NULL.
+ * @param s Where the setter will be returned.
+ *
+ * @return JY_ESUCCESS or JY_ENOTFOUND.
+ */
+int jyc_get_setter(const struct st_jyc *c, const struct st_jys *name, enum e_jyo_type type, const char *clazz, const struct st_jyc_setter **s);
+
+/**
+ * Drops the descriptors of every Java class which has been unloaded.
+ */
+void jyc_purge(JNIEnv *jenv);
+
+/**
+ * Drops every cached descriptor, the options set by jyc_set_flags() and
+ * jyc_set_getters() and the references held by the cache.
+ */
+void jyc_flush(JNIEnv *jenv);
+
+#endif /* !defined(_JYC_H_) */
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <jni.h>
+
+#include "jnyikes.h"
+#include "jys.h"
+#include "jyo.h"
+#include "jyh.h"
+
+/** Number of buckets of the handler table. Must be a power of 2. */
+#define JYH_HASH_SIZE 64
+
+/** Bucket of an interned class name, hashed by address. */
+#define JYH_HASH(clazz) \
+	((unsigned int)((uintptr_t)(clazz) >> 3) & (JYH_HASH_SIZE - 1))
+
+/**
+ * Handler of the POJOs of a class.
+ */
+struct st_jyh {
+	/** Next handler of the same bucket. */
+	struct st_jyh *next;
+	/** The class name. Interned with jys_intern(). */
+	const char *clazz;
+	int (*fn)(JNIEnv *, struct st_jyo *, void *);
+	void *arg;
+};
+
+/** The handlers by class and the default one, guarded by "g_jyh_lock". */
+static struct st_jyh *g_jyh_table[JYH_HASH_SIZE];
+static struct st_jyh g_jyh_default;
+static pthread_rwlock_t g_jyh_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/**
+ * Registers the handler of the POJOs of a class sent by Java with
+ * JNyIkes.j2n(), replacing the one already registered.
+ *
+ * @param clazz The class name, dotted or slash separated, or NULL for the
+ * handler of the classes without one.
+ * @param fn The handler, or NULL to unregister it.
+ * @param arg The argument of the handler.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyh_register(const char *clazz, int (*fn)(JNIEnv *, struct st_jyo *, void *), void *arg)
+{
+	const struct st_jys *sym;
+	struct st_jyh **hp, *h;
+
+	if (clazz == NULL) {
+		(void)pthread_rwlock_wrlock(&g_jyh_lock);
+		g_jyh_default.fn = fn;
+		g_jyh_default.arg = arg;
+		(void)pthread_rwlock_unlock(&g_jyh_lock);
+		return JY_ESUCCESS;
+	}
+
+	sym = jys_intern_class(clazz);
+	if (sym == NULL)
+		return JY_EENOMEM;
+
+	(void)pthread_rwlock_wrlock(&g_jyh_lock);
+
+	for (hp = &g_jyh_table[JYH_HASH(sym->name)]; *hp != NULL; hp = &(*hp)->next) {
+		if ((*hp)->clazz == sym->name)
+			break;
+	}
+
+	h = *hp;
+	if (fn == NULL) {
+		if (h != NULL) {
+			*hp = h->next;
+			free(h);
+		}
+		(void)pthread_rwlock_unlock(&g_jyh_lock);
+		return JY_ESUCCESS;
+	}
+
+	if (h == NULL) {
+		h = malloc(sizeof(struct st_jyh));
+		if (h == NULL) {
+			(void)pthread_rwlock_unlock(&g_jyh_lock);
+			return JY_EENOMEM;
+		}
+		h->next = NULL;
+		h->clazz = sym->name;
+		*hp = h;
+	}
+	h->fn = fn;
+	h->arg = arg;
+
+	(void)pthread_rwlock_unlock(&g_jyh_lock);
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Calls the handler of the class of a POJO.
+ *
+ * @return The "e_jy_err" error code of the handler, or JY_ENOTFOUND if there
+ * is no handler for the class of "o".
+ */
+int
+jyh_dispatch(JNIEnv *jenv, struct st_jyo *o)
+{
+	int (*fn)(JNIEnv *, struct st_jyo *, void *);
+	const struct st_jyh *h;
+	void *arg;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(o != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(o->clazz != NULL, JY_EEINVAL);
+
+	/* Class names are interned: they are compared by address. */
+	(void)pthread_rwlock_rdlock(&g_jyh_lock);
+	for (h = g_jyh_table[JYH_HASH(o->clazz)]; h != NULL; h = h->next) {
+		if (h->clazz == o->clazz)
+			break;
+	}
+	if (h == NULL)
+		h = &g_jyh_default;
+	fn = h->fn;
+	arg = h->arg;
+	(void)pthread_rwlock_unlock(&g_jyh_lock);
+
+	/* The handler runs unlocked: it may register handlers. */
+	if (fn == NULL)
+		return JY_ENOTFOUND;
+
+	return fn(jenv, o, arg);
+}
+
+/**
+ * Unregisters every handler.
+ */
+void
+jyh_flush(void)
+{
+	struct st_jyh *h;
+	unsigned int i;
+
+	(void)pthread_rwlock_wrlock(&g_jyh_lock);
+	for (i = 0; i < JYH_HASH_SIZE; i++) {
+		while ((h = g_jyh_table[i]) != NULL) {
+			g_jyh_table[i] = h->next;
+			free(h);
+		}
+	}
+	g_jyh_default.fn = NULL;
+	g_jyh_default.arg = NULL;
+	(void)pthread_rwlock_unlock(&g_jyh_lock);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_JYH_H_)
+#define _JYH_H_
+
+#include <jni.h>
+
+#include "jyo.h"
+
+/**
+ * Registers the handler of the POJOs of a class sent by Java with
+ * JNyIkes.j2n(), replacing the one already registered.
+ *
+ * The handler is called in the Java thread that sent the POJO, with its
+ * JNIEnv, the POJO and "arg". The POJO is freed once the handler returns, so
+ * it must not be kept. The handler's return, an "e_jy_err" error code, is
+ * returned to Java.
+ *
+ * @param clazz The class name, either in the form of "st_jyo.clazz"
+ * ("com/example/Foo") or dotted ("com.example.Foo"), or NULL for the handler
+ * of the classes without one.
+ * @param fn The handler, or NULL to unregister it. A handler still running
+ * when it is unregistered is not waited for.
+ * @param arg The argument of the handler.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyh_register(const char *clazz, int (*fn)(JNIEnv *, struct st_jyo *, void *), void *arg);
+
+/**
+ * Calls the handler of the class of a POJO.
+ *
+ * @return The "e_jy_err" error code of the handler, or JY_ENOTFOUND if there
+ * is no handler for the class of "o".
+ */
+int jyh_dispatch(JNIEnv *jenv, struct st_jyo *o);
+
+/**
+ * Unregisters every handler.
+ */
+void jyh_flush(void);
+
+#endif /* !defined(_JYH_H_) */
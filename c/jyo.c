@@ -31,10 +31,14 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
 
 #include <jni.h>
 
 #include "jyo.h"
+#include "jyc.h"
+#include "jyutf.h"
 
 #define JY_DEBUG_ERROR
 /*
@@ -63,31 +67,37 @@
 #endif
 
 static const char *g_str_clazz_string = "java/lang/String";
-static const char *g_str_clazz_object = "java/lang/Object";
 
-struct st_method_ll {
-	struct st_llist ll;
-	char *name;
-	char *sign;
-	int rettype;
-	jmethodID jmid;
-};
+/**
+ * Local references reserved for each nesting level of jyo_p2j() and
+ * jyo_j2p(). A level deletes the references of each property once it is
+ * converted, so it never holds more than a few at a time.
+ */
+#define JYO_LOCAL_FRAME 8
 
-static void jyo_free_method_ll(struct st_method_ll **mll);
+/**
+ * Size in bytes from which arrays are copied from and to the Java heap while
+ * pinned by GetPrimitiveArrayCritical() instead of by region calls.
+ */
+#define JYO_ARRAY_CRITICAL_MIN 4096
 
-static void
-jyo_free_method_ll(struct st_method_ll **mll)
-{
-	JY_ASSERT_RETURN_VOID(mll != NULL);
+/**
+ * Strings up to this many characters are copied out of Java before being
+ * converted to UTF-8. Longer ones are converted from the pinned String.
+ */
+#define JYO_STRING_REGION_MAX 256
 
-	while (*mll != NULL) {
-		if ((*mll)->name != NULL)
-			free((*mll)->name);
-		if ((*mll)->sign != NULL)
-			free((*mll)->sign);
-		lldel((void **)mll, *mll);
-	}
-}
+/** Signature of the receivers of jyo_send_batch(). */
+#define JYO_BATCH_SIGNATURE "([Ljava/lang/Object;)[Z"
+/** Batches up to this many objects are sent without allocating memory. */
+#define JYO_BATCH_STACK 256
+
+static int jyo_j2p_in(JNIEnv *jenv, jobject j, struct st_jyo *p, struct st_arena *arena);
+static void jyo_values_free(struct st_jyo *p);
+static jy_bool jyo_type_is_inline(enum e_jyo_type t);
+static void jyo_lease_unref(void *lease_v);
+static int jyo_p2j_class(JNIEnv *jenv, struct st_jyo *p, const struct st_jyc *c, jobject *j);
+static int jyo_p2j_frame(JNIEnv *jenv, struct st_jyo *p, const struct st_jyc *c, jobject *j);
 
 /*
  * Memory freeing functions.
@@ -101,38 +111,53 @@ jyo_property_free(struct st_jyo_property *p)
 {
 	JY_ASSERT_RETURN_VOID(p != NULL);
 
-	if (p->method_name != NULL) {
-		free(p->method_name);
-		p->method_name = NULL;
-	}
+	/* The name belongs to the symbol table. */
+	p->sym = NULL;
+
+	if (jyo_type_is_inline(p->data_type) || (p->value.ref.data == NULL))
+		return;
 
-	if (p->data != NULL) {
-		free(p->data);
-		p->data = NULL;
+	if (p->data_type == JYO_TBLOB) {
+		jyo_lease_unref(p->value.ref.data);
+	} else {
+		/* The contents of a child belong to its parent too. */
+		if (p->data_type == JYO_TJYO)
+			jyo_free((struct st_jyo *)p->value.ref.data);
+		free(p->value.ref.data);
 	}
+	p->value.ref.data = NULL;
+}
+
+/**
+ * Free a property node.
+ */
+static void
+jyo_property_ll_free(struct st_jyo_property_ll *p_ll)
+{
+	JY_ASSERT_RETURN_VOID(p_ll != NULL);
+
+	jyo_property_free(&p_ll->st);
+	llfree(p_ll, sizeof(struct st_jyo_property_ll));
 }
 
 /**
  * Free a linked list of properties.
  */
 static void
-jyo_property_ll_free(struct st_jyo_property_ll **head_ll)
+jyo_property_list_free(struct st_llhead *h)
 {
 	struct st_jyo_property_ll *p_ll;
 
-	JY_ASSERT_RETURN_VOID(head_ll != NULL);
-
-	if (*head_ll == NULL)
-		return;
+	JY_ASSERT_RETURN_VOID(h != NULL);
 
 	/* Free the contents of each "st_property". */
-	for (p_ll = *head_ll; p_ll != NULL;
+	for (p_ll = (struct st_jyo_property_ll *)h->first; p_ll != NULL;
 	    p_ll = (struct st_jyo_property_ll *)p_ll->ll.next) {
 		jyo_property_free(&p_ll->st);
 	}
 
-	/* Destroy the linked list. */
-	lldestroy((void **)head_ll);
+	/* Destroy the linked list, recycling its nodes. */
+	llh_destroy(h, sizeof(struct st_jyo_property_ll));
 }
 
 /**
@@ -145,14 +170,112 @@ jyo_free(struct st_jyo *p)
 {
 	JY_ASSERT_RETURN_VOID(p != NULL);
 
-	if (p->clazz != NULL) {
-		free(p->clazz);
-		p->clazz = NULL;
+	/* Everything was allocated from the arena. */
+	if (p->arena != NULL) {
+		if (p->freearena)
+			arena_destroy(p->arena);
+		memset(p, 0, sizeof(struct st_jyo));
+		return;
+	}
+
+	/* The class name belongs to the symbol table. */
+	p->clazz = NULL;
+
+	jyo_values_free(p);
+	jyo_property_list_free(&p->properties);
+
+	if (p->index != NULL) {
+		free(p->index);
+		p->index = NULL;
 	}
+	p->index_size = 0;
 
-	jyo_property_ll_free(&p->properties);
+	p->error = JY_ESUCCESS;
+}
+
+/**
+ * jyo_free() as an arena_cleanup() function: frees a child copied into the
+ * arena of its parent along with the arena.
+ */
+static void
+jyo_free_cleanup(void *p)
+{
+	jyo_free((struct st_jyo *)p);
+}
+
+/**
+ * Allocates from "arena" the copy of the child "orig_data" set as a property
+ * of a parent backed by "arena". The contents of the child are freed with the
+ * arena, unless they are in the arena already.
+ *
+ * @return The memory of the copy or NULL if there is no memory.
+ */
+static void *
+jyo_child_alloc_in(struct st_arena *arena, const struct st_jyo *orig_data)
+{
+	void *data;
+
+	data = arena_alloc(arena, sizeof(struct st_jyo));
+	if ((data != NULL) && (orig_data->arena != arena) &&
+	    (arena_cleanup(arena, jyo_free_cleanup, data) != 0))
+		return NULL;
+
+	return data;
+}
+
+/**
+ * Clears the properties of the "st_jyo" struct, keeping its class and the
+ * memory it has allocated so it can be filled again without allocating.
+ *
+ * Arena backed structs rewind their arena. The properties of other structs
+ * are freed, but their nodes are recycled by llfree() and their index is
+ * kept.
+ *
+ * @param o Pointer to the "st_jyo" struct. It must not be a child sharing
+ * the arena of its parent.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyo_reset(struct st_jyo *p)
+{
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+
+	if (p->arena != NULL) {
+		/* The arena of a child also holds its parent. */
+		JY_ASSERT_RETURN(p->freearena, JY_EEINVAL);
+
+		arena_reset(p->arena);
+		llh_init(&p->properties);
+		p->index = NULL;
+		p->index_size = 0;
+		p->shape = NULL;
+		p->values = NULL;
+	} else {
+		jyo_values_free(p);
+		jyo_property_list_free(&p->properties);
+		if (p->index != NULL)
+			memset(p->index, 0, p->index_size * sizeof(struct st_jyo_property_ll *));
+	}
 
 	p->error = JY_ESUCCESS;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Interns a class name in the "FindClass()" form, so that the names of a
+ * class from C ("com/example/Foo") and from "Class.getName()"
+ * ("com.example.Foo") are the same pointer.
+ */
+static char *
+jyo_intern_clazz(const char *clazz)
+{
+	const struct st_jys *sym;
+
+	sym = jys_intern_class(clazz);
+
+	return sym != NULL ? (char *)sym->name : NULL;
 }
 
 /**
@@ -173,7 +296,7 @@ jyo_init(struct st_jyo *p, char *clazz)
 	memset(p, 0, sizeof(struct st_jyo));
 
 	if (clazz != NULL) {
-		p->clazz = strdup(clazz);
+		p->clazz = jyo_intern_clazz(clazz);
 		if (p->clazz == NULL)
 			return JY_EENOMEM;
 	}
@@ -181,6 +304,275 @@ jyo_init(struct st_jyo *p, char *clazz)
 	return JY_ESUCCESS;
 }
 
+/**
+ * Initializes a "st_jyo" struct allocating from "arena", which is not owned
+ * by it.
+ */
+static int
+jyo_init_in(struct st_jyo *p, char *clazz, struct st_arena *arena)
+{
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+
+	if (arena == NULL)
+		return jyo_init(p, clazz);
+
+	memset(p, 0, sizeof(struct st_jyo));
+	p->arena = arena;
+
+	if (clazz != NULL) {
+		p->clazz = jyo_intern_clazz(clazz);
+		if (p->clazz == NULL) {
+			memset(p, 0, sizeof(struct st_jyo));
+			return JY_EENOMEM;
+		}
+	}
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Initializes a "st_jyo" struct backed by an arena: its properties and their
+ * data are carved from a few large blocks instead of being allocated one by
+ * one, and jyo_free() releases them all at once.
+ *
+ * The other jyo APIs work unchanged on such a struct.
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param clazz The name of the class to be created.
+ * @param hint The expected memory use, in bytes, or 0 for a default.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyo_init_arena(struct st_jyo *p, char *clazz, size_t hint)
+{
+	struct st_arena *arena;
+	int ret;
+
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+
+	arena = arena_new(hint);
+	if (arena == NULL) {
+		memset(p, 0, sizeof(struct st_jyo));
+		return JY_EENOMEM;
+	}
+
+	ret = jyo_init_in(p, clazz, arena);
+	if (ret != JY_ESUCCESS) {
+		arena_destroy(arena);
+		return ret;
+	}
+	p->freearena = JNI_TRUE;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Initializes a "st_jyo" struct to be set as a JYO_TJYO property of "parent",
+ * sharing its arena if it has one. Such a child is released with its parent
+ * and must not be used after it.
+ *
+ * @param parent The "st_jyo" struct the child will belong to.
+ * @param o The pointer to the child "st_jyo" struct.
+ * @param clazz The name of the class to be created.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyo_init_child(struct st_jyo *parent, struct st_jyo *p, char *clazz)
+{
+	JY_ASSERT_RETURN(parent != NULL, JY_EEINVAL);
+
+	return jyo_init_in(p, clazz, parent->arena);
+}
+
+
+/*
+ * Object pool.
+ */
+
+/** Default number of structs kept per class and thread. */
+#define JYO_POOL_DEFAULT_LIMIT 16
+
+/**
+ * A "st_jyo" struct handed out by jyo_acquire().
+ */
+struct st_jyo_pooled {
+	/** The struct itself. Must be the first member. */
+	struct st_jyo o;
+	/** Next free struct of the same class. */
+	struct st_jyo_pooled *next;
+};
+
+/**
+ * The free structs of a class in the pool of a thread.
+ */
+struct st_jyo_pool_class {
+	struct st_jyo_pool_class *next;
+	/** The class name. Interned with jys_intern(). */
+	const char *clazz;
+	struct st_jyo_pooled *free;
+	unsigned int count;
+};
+
+static pthread_key_t g_jyo_pool_key;
+static pthread_once_t g_jyo_pool_once = PTHREAD_ONCE_INIT;
+static volatile unsigned int g_jyo_pool_limit = JYO_POOL_DEFAULT_LIMIT;
+
+/**
+ * Frees the pool of an exiting thread.
+ */
+static void
+jyo_pool_destroy(void *pool_v)
+{
+	struct st_jyo_pool_class *pc;
+	struct st_jyo_pooled *po;
+
+	while ((pc = pool_v) != NULL) {
+		pool_v = pc->next;
+		while ((po = pc->free) != NULL) {
+			pc->free = po->next;
+			jyo_free(&po->o);
+			free(po);
+		}
+		free(pc);
+	}
+}
+
+static void
+jyo_pool_init(void)
+{
+	(void)pthread_key_create(&g_jyo_pool_key, jyo_pool_destroy);
+}
+
+/**
+ * Gets the free structs of the class "clazz" in the pool of the calling
+ * thread, creating them if "create" is true.
+ */
+static struct st_jyo_pool_class *
+jyo_pool_get(const char *clazz, jy_bool create)
+{
+	struct st_jyo_pool_class *first, *pc;
+
+	(void)pthread_once(&g_jyo_pool_once, jyo_pool_init);
+
+	first = pthread_getspecific(g_jyo_pool_key);
+	for (pc = first; pc != NULL; pc = pc->next) {
+		if (pc->clazz == clazz)
+			return pc;
+	}
+
+	if (!create)
+		return NULL;
+
+	pc = calloc(1, sizeof(struct st_jyo_pool_class));
+	if (pc == NULL)
+		return NULL;
+	pc->clazz = clazz;
+	pc->next = first;
+	if (pthread_setspecific(g_jyo_pool_key, pc) != 0) {
+		free(pc);
+		return NULL;
+	}
+
+	return pc;
+}
+
+/**
+ * Gets an empty arena backed "st_jyo" struct of the class "clazz", reusing
+ * one released by the calling thread if there is one. A thread that keeps
+ * acquiring and releasing structs of the same classes ends up allocating no
+ * memory at all.
+ *
+ * @param clazz The name of the class to be created.
+ * @param o Where the struct will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyo_acquire(char *clazz, struct st_jyo **p)
+{
+	struct st_jyo_pool_class *pc;
+	struct st_jyo_pooled *po;
+	char *name;
+	int ret;
+
+	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+
+	*p = NULL;
+
+	name = jyo_intern_clazz(clazz);
+	if (name == NULL)
+		return JY_EENOMEM;
+
+	pc = jyo_pool_get(name, JY_FALSE);
+	if ((pc != NULL) && (pc->free != NULL)) {
+		po = pc->free;
+		pc->free = po->next;
+		pc->count--;
+		po->next = NULL;
+		*p = &po->o;
+		return JY_ESUCCESS;
+	}
+
+	po = malloc(sizeof(struct st_jyo_pooled));
+	if (po == NULL)
+		return JY_EENOMEM;
+	po->next = NULL;
+
+	ret = jyo_init_arena(&po->o, name, 0);
+	if (ret != JY_ESUCCESS) {
+		free(po);
+		return ret;
+	}
+
+	*p = &po->o;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Gives back a struct returned by jyo_acquire(). It is reset with
+ * jyo_reset() and kept in the pool of the calling thread, or freed if the
+ * pool is full.
+ *
+ * @param o The struct. It must not be used afterwards.
+ */
+void
+jyo_release(struct st_jyo *p)
+{
+	struct st_jyo_pool_class *pc;
+	struct st_jyo_pooled *po;
+
+	JY_ASSERT_RETURN_VOID(p != NULL);
+
+	po = (struct st_jyo_pooled *)p;
+
+	pc = NULL;
+	if ((p->clazz != NULL) && (g_jyo_pool_limit > 0))
+		pc = jyo_pool_get(p->clazz, JY_TRUE);
+	if ((pc == NULL) || (pc->count >= g_jyo_pool_limit) ||
+	    (jyo_reset(p) != JY_ESUCCESS)) {
+		jyo_free(p);
+		free(po);
+		return;
+	}
+
+	po->next = pc->free;
+	pc->free = po;
+	pc->count++;
+}
+
+/**
+ * Sets the number of structs of each class kept by the pool of each thread.
+ * 0 disables the pool.
+ */
+void
+jyo_pool_limit(unsigned int n)
+{
+	g_jyo_pool_limit = n;
+}
 
 /*
  * General usage functions.
@@ -225,660 +617,2811 @@ jyo_get_type_size(enum e_jyo_type t)
 }
 
 /**
- * Returns the string description of a type.
+ * Gets the size of the elements of the array type "t".
+ *
+ * @return The size or 0 if "t" is not an array type.
  */
-const char *
-jyo_get_type_name(enum e_jyo_type t)
+static size_t
+jyo_get_array_elem_size(enum e_jyo_type t)
 {
-#define CASE_RETURN(x) case x: return #x
 	switch (t) {
-		CASE_RETURN(JYO_TDOUBLE);
-		CASE_RETURN(JYO_TFLOAT);
-		CASE_RETURN(JYO_TINT);
-		CASE_RETURN(JYO_TLONG);
-		CASE_RETURN(JYO_TJYO);
-		CASE_RETURN(JYO_TSTRING);
-		CASE_RETURN(JYO_TUINT);
-		CASE_RETURN(JYO_TULONG);
-		CASE_RETURN(JYO_TBOOLEAN);
-		CASE_RETURN(JYO_TBYTE);
-		CASE_RETURN(JYO_TCHAR);
-		CASE_RETURN(JYO_TSHORT);
-		CASE_RETURN(JYO_TVOID);
-		CASE_RETURN(JYO_TJCLASS);
+		case JYO_TBYTEARRAY:
+			return sizeof(jbyte);
+		case JYO_TSHORTARRAY:
+			return sizeof(jshort);
+		case JYO_TINTARRAY:
+			return sizeof(jint);
+		case JYO_TLONGARRAY:
+			return sizeof(jlong);
+		case JYO_TFLOATARRAY:
+			return sizeof(jfloat);
+		case JYO_TDOUBLEARRAY:
+			return sizeof(jdouble);
 		default:
-			return NULL;
+			return 0;
 	}
-#undef CASE_NAME
 }
 
 /**
- * Sets up the property of an "st_jyo" struct.
+ * Copies the elements of the array "a" of type "data_type", allocating from
+ * "arena" or with malloc(3). Empty arrays get a buffer too, so they can be
+ * told from null ones.
  *
- * @param o The pointer to the "st_jyo" struct.
- * @param setter The name of the property to be set.
- * @param data_type The data type enum of the data to be set.
- * @param data The pointer to the data to be set.
+ * @param size Where the size in bytes of the elements will be returned.
  *
- * @return -1 in case of error and 0 for success.
+ * @return The copy or NULL if there is no memory.
  */
-int
-jyo_set_property(struct st_jyo *p, const char *method_name, enum e_jyo_type data_type, const void *orig_data)
+static void *
+jyo_array_dup(struct st_arena *arena, enum e_jyo_type data_type, const struct st_jyo_array *a, size_t *size)
 {
-	struct st_jyo_property_ll *p_ll;
-	size_t data_size;
+	size_t elem_size;
 	void *data;
 
-	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(method_name != NULL, JY_EEINVAL);
+	elem_size = jyo_get_array_elem_size(data_type);
+	if (a->length > SIZE_MAX / elem_size)
+		return NULL;
+	*size = a->length * elem_size;
 
-	if (jyo_error(p) != JY_ESUCCESS)
-		return JY_EEINVAL;
+	if (arena != NULL)
+		data = arena_alloc(arena, *size > 0 ? *size : 1);
+	else
+		data = malloc(*size > 0 ? *size : 1);
+	if ((data != NULL) && (*size > 0))
+		memcpy(data, a->data, *size);
 
-	/*
-	 * Checks the size of "orig_data".
-	 */
-	if (data_type == JYO_TSTRING) {
-		if (orig_data != NULL) {
-			data_size = strlen((char *)orig_data) + 1;
-DEBUG_STR(method_name);
-DEBUG_STR((char *)orig_data);
-		} else
-			data_size = 0;
-	} else {
-		if (orig_data != NULL) {
-			data_size = jyo_get_type_size(data_type);
-			JY_ASSERT_RETURN(data_size != JY_EEINVAL, JY_EEINVAL);
-DEBUG_STR(method_name);
-		} else
-			data_size = 0;
-	}
+	return data;
+}
 
-	if (data_size > 0 ) {
-/*	JY_ASSERT_RETURN(data_size > 0, JY_EEINVAL);*/
-		data = malloc(data_size);
-		if (data == NULL) {
-			p->error = JY_EENOMEM;
-			return JY_EENOMEM;
-		}
-		memcpy(data, orig_data, data_size);
-	} else
-		data = NULL;
+/*
+ * Blobs.
+ */
 
-	p_ll = malloc(sizeof(struct st_jyo_property_ll));
-	if (p_ll == NULL) {
-		if (data_size > 0 )
-			free(data);
+/** Number of buckets of the table of lent blobs. Must be a power of 2. */
+#define JYO_LENT_HASH_SIZE 64
 
-		p->error = JY_EENOMEM;
-		return JY_EENOMEM;
-	}
+#define JYO_LENT_HASH(data) \
+	((unsigned int)((uintptr_t)(data) >> 4) & (JYO_LENT_HASH_SIZE - 1))
 
-	memset(p_ll, 0, sizeof(struct st_jyo_property_ll));
+/**
+ * A blob counting its holders: the properties storing it and the ByteBuffers
+ * made of it Java has not given back. It is released by the last one.
+ */
+struct st_jyo_lease {
+	/** Next lease of the same bucket of the lent table. */
+	struct st_jyo_lease *next;
+	struct st_jyo_blob blob;
+	/** Number of holders. */
+	unsigned int refs;
+	/** Number of ByteBuffers Java holds: it is in the lent table if not 0. */
+	unsigned int lent;
+};
 
-	p_ll->st.data_type = data_type;
-	p_ll->st.data = data;
+/** The leases with ByteBuffers held by Java, by the address of their memory. */
+static struct st_jyo_lease *g_jyo_lent_table[JYO_LENT_HASH_SIZE];
+/** Protects "g_jyo_lent_table" and the counters of every lease. */
+static pthread_mutex_t g_jyo_lease_lock = PTHREAD_MUTEX_INITIALIZER;
+/** The JVM of the ByteBuffers of the blobs made by jyo_j2p(). */
+static JavaVM *g_jyo_jvm = NULL;
 
-	p_ll->st.method_name = strdup(method_name);
-	if (p_ll->st.method_name == NULL) {
-		jyo_property_ll_free(&p_ll);
+/**
+ * Makes a lease of the blob "blob", with one reference for the caller.
+ *
+ * @return The lease or NULL if there is no memory, in which case the blob was
+ * released.
+ */
+static struct st_jyo_lease *
+jyo_lease_new(const struct st_jyo_blob *blob)
+{
+	struct st_jyo_lease *l;
 
-		p->error = JY_EENOMEM;
-		return JY_EENOMEM;
+	l = malloc(sizeof(struct st_jyo_lease));
+	if (l == NULL) {
+		if (blob->release != NULL)
+			blob->release(blob->data, blob->arg);
+		return NULL;
 	}
 
-	llappend((void *)&p->properties, p_ll);
+	l->next = NULL;
+	l->blob = *blob;
+	l->refs = 1;
+	l->lent = 0;
 
-	return JY_ESUCCESS;
+	return l;
 }
 
-/** XXX TODO COMMENT */
-static int
-jyo_get_static_mid(JNIEnv *jenv, const char *clazz, const char *method, char *sig, jclass *jcls, jmethodID *jmid)
+static void
+jyo_lease_ref(struct st_jyo_lease *l)
 {
-	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(method != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(sig != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(jcls != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(jmid != NULL, JY_EEINVAL);
+	pthread_mutex_lock(&g_jyo_lease_lock);
+	l->refs++;
+	pthread_mutex_unlock(&g_jyo_lease_lock);
+}
 
-	*jcls = (*jenv)->FindClass(jenv, clazz);
-	if ((*jcls == NULL) || ((*jenv)->ExceptionCheck(jenv))) {
-#ifdef JY_DEBUG_ERROR
-		fprintf(stderr, "Could not find class \"%s\".\n", clazz);
-#endif
-		if ((*jenv)->ExceptionCheck(jenv)) {
-			(*jenv)->ExceptionDescribe(jenv);
-			(*jenv)->ExceptionClear(jenv);
-		}
-		fflush(stderr);
+/**
+ * Drops a reference of a lease, releasing the blob with the last one. Takes a
+ * void pointer to be an arena_cleanup() function.
+ */
+static void
+jyo_lease_unref(void *lease_v)
+{
+	struct st_jyo_lease *l;
+	unsigned int refs;
 
-		if (*jcls != NULL)
-			(*jenv)->DeleteLocalRef(jenv, *jcls);
+	l = lease_v;
 
-		*jcls = NULL;
-		*jmid = NULL;
+	pthread_mutex_lock(&g_jyo_lease_lock);
+	refs = --l->refs;
+	pthread_mutex_unlock(&g_jyo_lease_lock);
 
-		return JY_ENOJCLASS;
+	if (refs > 0)
+		return;
+
+	if (l->blob.release != NULL)
+		l->blob.release(l->blob.data, l->blob.arg);
+	free(l);
+}
+
+/**
+ * Releases the memory of a blob made by jyo_j2p(): the global reference "arg"
+ * to its ByteBuffer. The thread is attached to the JVM while deleting it if it
+ * was not.
+ */
+static void
+jyo_jbuf_release(void *data, void *arg)
+{
+	JNIEnv *jenv;
+	jint ret;
+
+	ret = (*g_jyo_jvm)->GetEnv(g_jyo_jvm, (void **)&jenv, JNI_VERSION_1_2);
+	if (ret == JNI_EDETACHED) {
+		if ((*g_jyo_jvm)->AttachCurrentThread(g_jyo_jvm, (void **)&jenv, NULL) != JNI_OK)
+			return;
+	} else if (ret != JNI_OK)
+		return;
+
+	(*jenv)->DeleteGlobalRef(jenv, (jobject)arg);
+
+	if (ret == JNI_EDETACHED)
+		(void)(*g_jyo_jvm)->DetachCurrentThread(g_jyo_jvm);
+}
+
+/**
+ * Releases the memory of a blob copied by jyo_j2p() from a heap ByteBuffer.
+ */
+static void
+jyo_heap_release(void *data, void *arg)
+{
+	free(data);
+}
+
+/**
+ * Makes a ByteBuffer of the memory of a lease for Java. Blobs made by
+ * jyo_j2p() give their own ByteBuffer back. Any other ByteBuffer holds a
+ * reference until JNyIkes.release() gives it back.
+ *
+ * @param jbuf Where the local reference to the ByteBuffer will be returned.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+static int
+jyo_lease_lend(JNIEnv *jenv, struct st_jyo_lease *l, jobject *jbuf)
+{
+	unsigned int i;
+
+	if (l->blob.release == jyo_jbuf_release) {
+		*jbuf = (*jenv)->NewLocalRef(jenv, (jobject)l->blob.arg);
+		return *jbuf != NULL ? JY_ESUCCESS : JY_EENOMEM;
 	}
 
-	*jmid = (*jenv)->GetStaticMethodID(jenv, *jcls, method, sig);
-	if ((*jmid == NULL) || ((*jenv)->ExceptionCheck(jenv))) {
-#ifdef JY_DEBUG_ERROR
-		fprintf(stderr, "Could not find static method \"%s\" with signature \"%s\" for class \"%s\".\n", method, sig, clazz);
-#endif
-		if ((*jenv)->ExceptionCheck(jenv)) {
-			(*jenv)->ExceptionDescribe(jenv);
-			(*jenv)->ExceptionClear(jenv);
-		}
-		fflush(stderr);
+	*jbuf = (*jenv)->NewDirectByteBuffer(jenv, l->blob.data, (jlong)l->blob.size);
+	if (*jbuf == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		return JY_EENOMEM;
+	}
 
-		(*jenv)->DeleteLocalRef(jenv, *jcls);
-		*jcls = NULL;
-		*jmid = NULL;
+	pthread_mutex_lock(&g_jyo_lease_lock);
+	l->refs++;
+	if (l->lent++ == 0) {
+		i = JYO_LENT_HASH(l->blob.data);
+		l->next = g_jyo_lent_table[i];
+		g_jyo_lent_table[i] = l;
+	}
+	pthread_mutex_unlock(&g_jyo_lease_lock);
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Gives back a ByteBuffer made of a blob by jyo_p2j(): its memory is released
+ * once no one else holds it. Java must not use the ByteBuffer afterwards.
+ *
+ * @return The "e_jy_err" error enumerator: JY_ENOTFOUND if "jbuf" was not
+ * made by jyo_p2j() or was already given back.
+ */
+int
+jyo_blob_release(JNIEnv *jenv, jobject jbuf)
+{
+	struct st_jyo_lease **lp, *l;
+	void *data;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(jbuf != NULL, JY_EEINVAL);
 
+	data = (*jenv)->GetDirectBufferAddress(jenv, jbuf);
+	if (data == NULL)
 		return JY_ENOTFOUND;
+
+	pthread_mutex_lock(&g_jyo_lease_lock);
+	for (lp = &g_jyo_lent_table[JYO_LENT_HASH(data)]; *lp != NULL;
+	    lp = &(*lp)->next) {
+		if ((*lp)->blob.data == data)
+			break;
+	}
+	l = *lp;
+	if ((l != NULL) && (--l->lent == 0)) {
+		*lp = l->next;
+		l->next = NULL;
 	}
+	pthread_mutex_unlock(&g_jyo_lease_lock);
+
+	if (l == NULL)
+		return JY_ENOTFOUND;
+
+	jyo_lease_unref(l);
 
 	return JY_ESUCCESS;
 }
 
-/** XXX TODO COMMENT */
-static char *
-jyo_get_method_signature(enum e_jyo_type type_ret, void *type_ret_detail, enum e_jyo_type type_param, const char *type_param_detail)
+/**
+ * Returns the string description of a type.
+ */
+const char *
+jyo_get_type_name(enum e_jyo_type t)
 {
-#define SWITCH_TYPE_CAT_s(type, param) do {				\
-	switch (type) {							\
-		case JYO_TBOOLEAN:				\
-			strcat(s, "Z");					\
-			break;						\
-		case JYO_TBYTE:					\
-			strcat(s, "B");					\
-			break;						\
-		case JYO_TCHAR:					\
-			strcat(s, "C");					\
-			break;						\
-		case JYO_TSHORT:				\
-			strcat(s, "S");					\
-			break;						\
-		case JYO_TUINT:					\
-		case JYO_TINT:					\
-			strcat(s, "I");					\
-			break;						\
-		case JYO_TULONG:				\
-		case JYO_TLONG:					\
-			strcat(s, "J");					\
-			break;						\
-		case JYO_TFLOAT:				\
-			strcat(s, "F");					\
-			break;						\
-		case JYO_TDOUBLE:				\
-			strcat(s, "D");					\
-			break;						\
-		case JYO_TVOID:					\
-			strcat(s, "V");					\
-			break;						\
-		case JYO_TSTRING:				\
-			strcat(s, "L");					\
-			strcat(s, g_str_clazz_string);			\
-			strcat(s, ";");					\
-			break;						\
-		case JYO_TJYO:				\
-			strcat(s, "L");					\
-			strcat(s, ((struct st_jyo *)param)->clazz);	\
-			strcat(s, ";");					\
-			break;						\
-		case JYO_TJCLASS:				\
-			strcat(s, "L");					\
-			strcat(s, (char *)param);			\
-			strcat(s, ";");					\
-			break;						\
-	}								\
-} while (0)
+#define CASE_RETURN(x) case x: return #x
+	switch (t) {
+		CASE_RETURN(JYO_TDOUBLE);
+		CASE_RETURN(JYO_TFLOAT);
+		CASE_RETURN(JYO_TINT);
+		CASE_RETURN(JYO_TLONG);
+		CASE_RETURN(JYO_TJYO);
+		CASE_RETURN(JYO_TSTRING);
+		CASE_RETURN(JYO_TUINT);
+		CASE_RETURN(JYO_TULONG);
+		CASE_RETURN(JYO_TBOOLEAN);
+		CASE_RETURN(JYO_TBYTE);
+		CASE_RETURN(JYO_TCHAR);
+		CASE_RETURN(JYO_TSHORT);
+		CASE_RETURN(JYO_TVOID);
+		CASE_RETURN(JYO_TJCLASS);
+		CASE_RETURN(JYO_TBYTEARRAY);
+		CASE_RETURN(JYO_TSHORTARRAY);
+		CASE_RETURN(JYO_TINTARRAY);
+		CASE_RETURN(JYO_TLONGARRAY);
+		CASE_RETURN(JYO_TFLOATARRAY);
+		CASE_RETURN(JYO_TDOUBLEARRAY);
+		CASE_RETURN(JYO_TBLOB);
+		default:
+			return NULL;
+	}
+#undef CASE_NAME
+}
 
-	char *s;
-	size_t slen;
+/** Initial number of buckets of the property index of a "st_jyo" struct. */
+#define JYO_INDEX_MIN_SIZE 8
 
-	/* Verify the passed parameters. */
-	if (type_param == JYO_TJCLASS)
-		JY_ASSERT_RETURN(type_param_detail != NULL, NULL);
-	else if (type_param != JYO_TSTRING)
-		JY_ASSERT_RETURN(jyo_get_type_size(type_param) > 0, NULL);
+/**
+ * Finds the first property named "sym" of "p" or NULL.
+ */
+static struct st_jyo_property_ll *
+jyo_property_find(const struct st_jyo *p, const struct st_jys *sym)
+{
+	struct st_jyo_property_ll *p_ll;
 
-	if (type_ret == JYO_TJCLASS)
-		JY_ASSERT_RETURN(type_ret_detail != NULL, NULL);
-	else if (type_ret != JYO_TSTRING)
-		JY_ASSERT_RETURN(jyo_get_type_size(type_ret) > 0, NULL);
+	if ((p->index == NULL) || (sym == NULL))
+		return NULL;
 
-	slen = 1;	/* EOS - '\000' */
+	for (p_ll = p->index[sym->hash & (p->index_size - 1)]; p_ll != NULL;
+	    p_ll = p_ll->hnext) {
+		if (p_ll->st.sym == sym)
+			return p_ll;
+	}
 
-	if (type_ret == JYO_TJCLASS)		/* Lpath/Class; */
-		slen += strlen(type_ret_detail) + 2;
-	else if (type_ret == JYO_TSTRING)	/* Lpath/Class; */
-		slen += strlen(g_str_clazz_string) + 2;
-	else						/* T */
-		slen += 1;
+	return NULL;
+}
 
-	if (type_param == JYO_TJCLASS)		/* Lpath/Class; */
-		slen += strlen(type_param_detail) + 2;
-	else if (type_param == JYO_TSTRING)	/* Lpath/Class; */
-		slen += strlen(g_str_clazz_string) + 2;
-	else if (type_param == JYO_TJYO)	/* Lpath/Class; */
-		slen += strlen(((struct st_jyo *)type_param_detail)->clazz) + 2;
-	else						/* T */
-		slen += 1;
+/**
+ * Adds "p_ll" to the index of "p", growing it when there are more properties
+ * than buckets. Properties with the same name are kept in the order they were
+ * set, so the first one is found.
+ */
+static int
+jyo_property_index(struct st_jyo *p, struct st_jyo_property_ll *p_ll)
+{
+	struct st_jyo_property_ll **index, **pp, *e;
+	unsigned int i, size;
+
+	if (p->properties.len + 1 > p->index_size) {
+		size = p->index_size == 0 ? JYO_INDEX_MIN_SIZE : p->index_size * 2;
+		/* Arena indexes are not freed when they grow, but since they
+		 * double the waste is bounded by the final index size. */
+		if (p->arena != NULL)
+			index = arena_alloc(p->arena, size * sizeof(struct st_jyo_property_ll *));
+		else
+			index = malloc(size * sizeof(struct st_jyo_property_ll *));
+		if (index == NULL)
+			return JY_EENOMEM;
+		memset(index, 0, size * sizeof(struct st_jyo_property_ll *));
+
+		/* Rehash in list order to keep each bucket ordered. */
+		for (e = (struct st_jyo_property_ll *)p->properties.first; e != NULL;
+		    e = (struct st_jyo_property_ll *)e->ll.next) {
+			for (pp = &index[e->st.sym->hash & (size - 1)]; *pp != NULL;
+			    pp = &(*pp)->hnext);
+			e->hnext = NULL;
+			*pp = e;
+		}
 
-	slen += 2;	/* () */
+		if (p->arena == NULL)
+			free(p->index);
+		p->index = index;
+		p->index_size = size;
+	}
 
-	s = malloc(slen);
+	i = p_ll->st.sym->hash & (p->index_size - 1);
+	for (pp = &p->index[i]; *pp != NULL; pp = &(*pp)->hnext);
+	p_ll->hnext = NULL;
+	*pp = p_ll;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Checks if data of type "t" is stored inline in "st_jyo_property.value".
+ */
+static jy_bool
+jyo_type_is_inline(enum e_jyo_type t)
+{
+	switch (t) {
+		case JYO_TBOOLEAN:
+		case JYO_TBYTE:
+		case JYO_TCHAR:
+		case JYO_TSHORT:
+		case JYO_TINT:
+		case JYO_TLONG:
+		case JYO_TFLOAT:
+		case JYO_TDOUBLE:
+			return JY_TRUE;
+		default:
+			return JY_FALSE;
+	}
+}
+
+/**
+ * Gets the address of the data of "pp": its inline value for scalars. NULL if
+ * the data is null.
+ */
+static void *
+jyo_property_data(const struct st_jyo_property *pp)
+{
+	if (jyo_type_is_inline(pp->data_type))
+		return pp->isnull ? NULL : (void *)&pp->value;
+
+	return pp->value.ref.data;
+}
+
+/**
+ * Gets the size of the data of "pp" in bytes, or 0 if it is null.
+ */
+static size_t
+jyo_property_size(const struct st_jyo_property *pp)
+{
+	if (jyo_type_is_inline(pp->data_type))
+		return pp->isnull ? 0 : jyo_get_type_size(pp->data_type);
+
+	return pp->value.ref.size;
+}
+
+/*
+ * Shapes.
+ */
+
+/** Number of buckets of the shape table. Must be a power of 2. */
+#define JYO_SHAPE_HASH_SIZE 64
+
+/**
+ * A property of a shape and where its value is stored.
+ */
+struct st_jyo_slot {
+	/** The interned property name. */
+	const struct st_jys *sym;
+	/**
+	 * The type of the value: strings and objects are stored as pointers
+	 * and arrays as "st_jyo_array".
+	 */
+	enum e_jyo_type data_type;
+	/** The offset of the value in the "values" of an object. */
+	size_t offset;
+};
+
+struct st_jyo_shape {
+	/** Next shape of the same shape table bucket. */
+	struct st_jyo_shape *next;
+	/** Hash of the class name and of the names and types of the slots. */
+	unsigned int hash;
+	/** The class name. Interned with jys_intern(). */
+	const char *clazz;
+	/** The size of the "values" of an object. */
+	size_t size;
+	/** Number of slots and the number of slots allocated. */
+	unsigned int nslots;
+	unsigned int maxslots;
+	/**
+	 * Index of "slots" by name: the slot number plus 1, or 0 for empty
+	 * entries. "index_size" is a power of 2 at least twice "maxslots".
+	 */
+	unsigned int *index;
+	unsigned int index_size;
+	/** The slots, in the order the properties were added. */
+	struct st_jyo_slot slots[];
+};
+
+/** The interned shapes, guarded by "g_jyo_shape_lock". */
+static struct st_jyo_shape *g_jyo_shape_table[JYO_SHAPE_HASH_SIZE];
+static pthread_mutex_t g_jyo_shape_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Starts building the shape of the objects of a class.
+ *
+ * @param clazz The class name.
+ * @param nslots The number of properties the shape will have.
+ * @param shape Where the shape will be returned.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int
+jyo_shape_new(const char *clazz, unsigned int nslots, struct st_jyo_shape **shape)
+{
+	struct st_jyo_shape *s;
+	unsigned int index_size;
+
+	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(shape != NULL, JY_EEINVAL);
+
+	*shape = NULL;
+
+	for (index_size = JYO_INDEX_MIN_SIZE; index_size < nslots * 2;
+	    index_size *= 2);
+
+	/* The index is allocated right after the slots. */
+	s = malloc(sizeof(struct st_jyo_shape) +
+	    nslots * sizeof(struct st_jyo_slot) +
+	    index_size * sizeof(unsigned int));
+	if (s == NULL)
+		return JY_EENOMEM;
+	memset(s, 0, sizeof(struct st_jyo_shape));
+
+	s->clazz = jyo_intern_clazz(clazz);
+	if (s->clazz == NULL) {
+		free(s);
+		return JY_EENOMEM;
+	}
+
+	s->hash = jy_strhash(s->clazz);
+	s->maxslots = nslots;
+	s->index = (unsigned int *)&s->slots[nslots];
+	s->index_size = index_size;
+	memset(s->index, 0, index_size * sizeof(unsigned int));
+
+	*shape = s;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Finds the slot named "sym" of "shape" or NULL.
+ */
+static const struct st_jyo_slot *
+jyo_shape_find(const struct st_jyo_shape *shape, const struct st_jys *sym)
+{
+	unsigned int i, n;
+
+	for (i = sym->hash & (shape->index_size - 1);
+	    (n = shape->index[i]) != 0; i = (i + 1) & (shape->index_size - 1)) {
+		if (shape->slots[n - 1].sym == sym)
+			return &shape->slots[n - 1];
+	}
+
+	return NULL;
+}
+
+/**
+ * Adds a property to a shape being built. Properties keep the order they are
+ * added in, which is the order jyo_p2j() sets them.
+ *
+ * @param sym The interned property name.
+ * @param data_type The type of the property: a scalar, JYO_TSTRING, JYO_TJYO
+ * or one of the JYO_T*ARRAY types. Blobs can't be stored in a shape.
+ *
+ * @return The "e_jy_err" error enumerator: JY_EEINVAL if the type can't be
+ * stored in a shape or the shape already has such a property.
+ */
+int
+jyo_shape_add(struct st_jyo_shape *shape, const struct st_jys *sym, enum e_jyo_type data_type)
+{
+	struct st_jyo_slot *slot;
+	size_t size;
+	unsigned int i;
+
+	JY_ASSERT_RETURN(shape != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(sym != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(shape->nslots < shape->maxslots, JY_EEINVAL);
+
+	if (jyo_type_is_inline(data_type))
+		size = jyo_get_type_size(data_type);
+	else if ((data_type == JYO_TSTRING) || (data_type == JYO_TJYO))
+		size = sizeof(void *);
+	else if (jyo_get_array_elem_size(data_type) > 0)
+		size = sizeof(struct st_jyo_array);
+	else
+		return JY_EEINVAL;
+
+	/* Objects could not tell the slots with the same name apart. */
+	if (jyo_shape_find(shape, sym) != NULL)
+		return JY_EEINVAL;
+
+	slot = &shape->slots[shape->nslots];
+	slot->sym = sym;
+	slot->data_type = data_type;
+	/* Every value is aligned to its size, which is a power of 2. */
+	slot->offset = (shape->size + size - 1) & ~(size - 1);
+	shape->size = slot->offset + size;
+	shape->nslots++;
+
+	for (i = sym->hash & (shape->index_size - 1); shape->index[i] != 0;
+	    i = (i + 1) & (shape->index_size - 1));
+	shape->index[i] = shape->nslots;
+
+	shape->hash = shape->hash * 31 + sym->hash + data_type;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Checks if the shapes "a" and "b" have the same class and slots.
+ */
+static jy_bool
+jyo_shape_equal(const struct st_jyo_shape *a, const struct st_jyo_shape *b)
+{
+	unsigned int i;
+
+	if ((a->hash != b->hash) || (a->clazz != b->clazz) ||
+	    (a->nslots != b->nslots))
+		return JY_FALSE;
+
+	for (i = 0; i < a->nslots; i++) {
+		if ((a->slots[i].sym != b->slots[i].sym) ||
+		    (a->slots[i].data_type != b->slots[i].data_type))
+			return JY_FALSE;
+	}
+
+	return JY_TRUE;
+}
+
+/**
+ * Interns a shape built by jyo_shape_new(), so identical shapes are shared.
+ * "shape" must not be used afterwards.
+ *
+ * @return The interned shape or NULL if there is no memory.
+ */
+const struct st_jyo_shape *
+jyo_shape_intern(struct st_jyo_shape *shape)
+{
+	struct st_jyo_shape *s;
+	unsigned int i;
+
+	JY_ASSERT_RETURN(shape != NULL, NULL);
+
+	i = shape->hash & (JYO_SHAPE_HASH_SIZE - 1);
+
+	pthread_mutex_lock(&g_jyo_shape_lock);
+	for (s = g_jyo_shape_table[i]; s != NULL; s = s->next) {
+		if (jyo_shape_equal(s, shape))
+			break;
+	}
+	if (s == NULL) {
+		shape->next = g_jyo_shape_table[i];
+		g_jyo_shape_table[i] = shape;
+		s = shape;
+	}
+	pthread_mutex_unlock(&g_jyo_shape_lock);
+
+	if (s != shape)
+		free(shape);
+
+	return s;
+}
+
+/**
+ * Frees a shape built by jyo_shape_new() that was not interned.
+ */
+void
+jyo_shape_free(struct st_jyo_shape *shape)
+{
+	free(shape);
+}
+
+/**
+ * Gives "p" the shape "shape", allocating its zeroed "values".
+ */
+static int
+jyo_shape_apply(struct st_jyo *p, const struct st_jyo_shape *shape)
+{
+	void *values;
+
+	if (p->arena != NULL)
+		values = arena_alloc(p->arena, shape->size);
+	else
+		values = malloc(shape->size);
+	if (values == NULL)
+		return JY_EENOMEM;
+	memset(values, 0, shape->size);
+
+	p->shape = shape;
+	p->values = values;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Frees the "values" of "p", with the strings and objects in them, and drops
+ * its shape.
+ */
+static void
+jyo_values_free(struct st_jyo *p)
+{
+	const struct st_jyo_slot *slot;
+	void *v;
+	unsigned int i;
+
+	if (p->values == NULL)
+		return;
+
+	/* Arena values go away with the arena. */
+	if (p->arena == NULL) {
+		for (i = 0; i < p->shape->nslots; i++) {
+			slot = &p->shape->slots[i];
+			if (jyo_type_is_inline(slot->data_type))
+				continue;
+
+			v = (char *)p->values + slot->offset;
+			if (jyo_get_array_elem_size(slot->data_type) > 0) {
+				free((void *)((struct st_jyo_array *)v)->data);
+				continue;
+			}
+			if (*(void **)v == NULL)
+				continue;
+			if (slot->data_type == JYO_TJYO)
+				jyo_free(*(struct st_jyo **)v);
+			free(*(void **)v);
+		}
+		free(p->values);
+	}
+
+	p->values = NULL;
+	p->shape = NULL;
+}
+
+/**
+ * Describes the slot "slot" of "p" as a property. Scalar data is copied: it is
+ * borrowed right from the "values" of "p".
+ */
+static void
+jyo_slot_view(const struct st_jyo *p, const struct st_jyo_slot *slot, struct st_jyo_property *pp)
+{
+	void *v;
+
+	v = (char *)p->values + slot->offset;
+
+	pp->freeme = JNI_FALSE;
+	pp->isnull = JNI_FALSE;
+	pp->sym = slot->sym;
+	pp->data_type = slot->data_type;
+
+	switch (slot->data_type) {
+		case JYO_TSTRING:
+			pp->value.ref.data = *(void **)v;
+			pp->value.ref.size = pp->value.ref.data != NULL ?
+			    strlen((char *)pp->value.ref.data) + 1 : 0;
+			break;
+		case JYO_TJYO:
+			pp->value.ref.data = *(void **)v;
+			pp->value.ref.size = pp->value.ref.data != NULL ?
+			    sizeof(struct st_jyo) : 0;
+			break;
+		case JYO_TBYTEARRAY:
+		case JYO_TSHORTARRAY:
+		case JYO_TINTARRAY:
+		case JYO_TLONGARRAY:
+		case JYO_TFLOATARRAY:
+		case JYO_TDOUBLEARRAY:
+			pp->value.ref.data = (void *)((struct st_jyo_array *)v)->data;
+			pp->value.ref.size = ((struct st_jyo_array *)v)->length *
+			    jyo_get_array_elem_size(slot->data_type);
+			break;
+		default:
+			memcpy(&pp->value, v, jyo_get_type_size(slot->data_type));
+			break;
+	}
+}
+
+/**
+ * Stores a copy of the array "a", or NULL, in the array slot "slot" of "p",
+ * overwriting the elements in place if they have the same size.
+ */
+static int
+jyo_slot_store_array(struct st_jyo *p, const struct st_jyo_slot *slot, const struct st_jyo_array *a)
+{
+	struct st_jyo_array *v;
+	size_t elem_size, size;
+	void *data;
+
+	v = (struct st_jyo_array *)((char *)p->values + slot->offset);
+	elem_size = jyo_get_array_elem_size(slot->data_type);
+
+	if ((a != NULL) && (v->data != NULL) && (a->length == v->length)) {
+		memcpy((void *)v->data, a->data, a->length * elem_size);
+		return JY_ESUCCESS;
+	}
+
+	data = NULL;
+	if (a != NULL) {
+		data = jyo_array_dup(p->arena, slot->data_type, a, &size);
+		if (data == NULL) {
+			p->error = JY_EENOMEM;
+			return JY_EENOMEM;
+		}
+	}
+
+	if (p->arena == NULL)
+		free((void *)v->data);
+	v->data = data;
+	v->length = a != NULL ? a->length : 0;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Stores a copy of "orig_data" in the slot "slot" of "p", freeing its
+ * previous string or object. The type of the data must be the type of the
+ * slot and scalar data can't be NULL.
+ */
+static int
+jyo_slot_store(struct st_jyo *p, const struct st_jyo_slot *slot, const void *orig_data)
+{
+	size_t data_size;
+	void *v, *data, *old;
+
+	v = (char *)p->values + slot->offset;
+
+	if (jyo_type_is_inline(slot->data_type)) {
+		memcpy(v, orig_data, jyo_get_type_size(slot->data_type));
+		return JY_ESUCCESS;
+	}
+
+	if (jyo_get_array_elem_size(slot->data_type) > 0)
+		return jyo_slot_store_array(p, slot, orig_data);
+
+	data = NULL;
+	if (orig_data != NULL) {
+		if (slot->data_type == JYO_TSTRING)
+			data_size = strlen((const char *)orig_data) + 1;
+		else
+			data_size = sizeof(struct st_jyo);
+
+		if ((p->arena != NULL) && (slot->data_type == JYO_TJYO))
+			data = jyo_child_alloc_in(p->arena, orig_data);
+		else if (p->arena != NULL)
+			data = arena_alloc(p->arena, data_size);
+		else
+			data = malloc(data_size);
+		if (data == NULL) {
+			p->error = JY_EENOMEM;
+			return JY_EENOMEM;
+		}
+		memcpy(data, orig_data, data_size);
+	}
+
+	old = *(void **)v;
+	*(void **)v = data;
+
+	if ((old != NULL) && (p->arena == NULL)) {
+		if (slot->data_type == JYO_TJYO)
+			jyo_free((struct st_jyo *)old);
+		free(old);
+	}
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Finds the first property named "sym" of "p", looking in the slots of its
+ * shape before its list of properties. Slots are described in "view".
+ */
+static const struct st_jyo_property *
+jyo_property_lookup(const struct st_jyo *p, const struct st_jys *sym, struct st_jyo_property *view)
+{
+	const struct st_jyo_slot *slot;
+	const struct st_jyo_property_ll *p_ll;
+
+	if (p->shape != NULL) {
+		slot = jyo_shape_find(p->shape, sym);
+		if (slot != NULL) {
+			jyo_slot_view(p, slot, view);
+			return view;
+		}
+	}
+
+	p_ll = jyo_property_find(p, sym);
+
+	return p_ll != NULL ? &p_ll->st : NULL;
+}
+
+/**
+ * Stores a copy of "orig_data" in the property "pp": scalars inline, strings,
+ * objects and arrays in dynamically allocated memory. "pp" is left untouched on
+ * errors and its previous data is not freed.
+ *
+ * @param arena The arena to allocate from or NULL to use malloc(3).
+ */
+static int
+jyo_property_store(struct st_arena *arena, const char *method_name, struct st_jyo_property *pp, enum e_jyo_type data_type, const void *orig_data)
+{
+	size_t data_size;
+	void *data;
+
+	/* Blobs are not copied: the property holds a reference of the lease
+	 * "orig_data", dropped by the arena of the object if it has one. */
+	if (data_type == JYO_TBLOB) {
+		if (orig_data != NULL) {
+			if ((arena != NULL) &&
+			    (arena_cleanup(arena, jyo_lease_unref, (void *)orig_data) != 0))
+				return JY_EENOMEM;
+			jyo_lease_ref((struct st_jyo_lease *)orig_data);
+		}
+
+		pp->data_type = data_type;
+		pp->isnull = JNI_FALSE;
+		pp->value.ref.data = (void *)orig_data;
+		pp->value.ref.size = orig_data != NULL ?
+		    ((const struct st_jyo_lease *)orig_data)->blob.size : 0;
+
+		return JY_ESUCCESS;
+	}
+
+	/* Arrays are always copied apart, even when empty. */
+	if (jyo_get_array_elem_size(data_type) > 0) {
+		data = NULL;
+		data_size = 0;
+		if (orig_data != NULL) {
+			data = jyo_array_dup(arena, data_type, orig_data, &data_size);
+			if (data == NULL)
+				return JY_EENOMEM;
+		}
+
+		pp->data_type = data_type;
+		pp->isnull = JNI_FALSE;
+		pp->value.ref.data = data;
+		pp->value.ref.size = data_size;
+
+		return JY_ESUCCESS;
+	}
+
+	/*
+	 * Checks the size of "orig_data".
+	 */
+	if (data_type == JYO_TSTRING) {
+		if (orig_data != NULL) {
+			data_size = strlen((char *)orig_data) + 1;
+DEBUG_STR(method_name);
+DEBUG_STR((char *)orig_data);
+		} else
+			data_size = 0;
+	} else {
+		if (orig_data != NULL) {
+			data_size = jyo_get_type_size(data_type);
+			JY_ASSERT_RETURN(data_size != JY_EEINVAL, JY_EEINVAL);
+DEBUG_STR(method_name);
+		} else
+			data_size = 0;
+	}
+
+	if (jyo_type_is_inline(data_type)) {
+		if (data_size > 0)
+			memcpy(&pp->value, orig_data, data_size);
+		pp->data_type = data_type;
+		pp->isnull = data_size == 0;
+
+		return JY_ESUCCESS;
+	}
+
+	if (data_size > 0 ) {
+/*	JY_ASSERT_RETURN(data_size > 0, JY_EEINVAL);*/
+		if ((arena != NULL) && (data_type == JYO_TJYO))
+			data = jyo_child_alloc_in(arena, orig_data);
+		else if (arena != NULL)
+			data = arena_alloc(arena, data_size);
+		else
+			data = malloc(data_size);
+		if (data == NULL)
+			return JY_EENOMEM;
+		memcpy(data, orig_data, data_size);
+	} else
+		data = NULL;
+
+	pp->data_type = data_type;
+	pp->isnull = JNI_FALSE;
+	pp->value.ref.data = data;
+	pp->value.ref.size = data != NULL ? data_size : 0;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Sets up the property of an "st_jyo" struct.
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param setter The name of the property to be set.
+ * @param data_type The data type enum of the data to be set.
+ * @param data The pointer to the data to be set. A JYO_TJYO struct is copied
+ * and its contents belong to "o" afterwards, so it must not be used nor freed.
+ *
+ * @return -1 in case of error and 0 for success.
+ */
+int
+jyo_set_property(struct st_jyo *p, const char *method_name, enum e_jyo_type data_type, const void *orig_data)
+{
+	const struct st_jys *sym;
+
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(method_name != NULL, JY_EEINVAL);
+
+	if (jyo_error(p) != JY_ESUCCESS)
+		return JY_EEINVAL;
+
+	sym = jys_intern(method_name);
+	if (sym == NULL) {
+		p->error = JY_EENOMEM;
+		return JY_EENOMEM;
+	}
+
+	return jyo_set_property_sym(p, sym, data_type, orig_data);
+}
+
+/**
+ * jyo_set_property_sym() taking the blobs as leases.
+ */
+static int
+jyo_set_property_in(struct st_jyo *p, const struct st_jys *sym, enum e_jyo_type data_type, const void *orig_data)
+{
+	struct st_jyo_property_ll *p_ll;
+	int ret;
+
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(sym != NULL, JY_EEINVAL);
+
+	if (jyo_error(p) != JY_ESUCCESS)
+		return JY_EEINVAL;
+
+	if (p->arena != NULL)
+		p_ll = arena_alloc(p->arena, sizeof(struct st_jyo_property_ll));
+	else
+		p_ll = llalloc(sizeof(struct st_jyo_property_ll));
+	if (p_ll == NULL) {
+		p->error = JY_EENOMEM;
+		return JY_EENOMEM;
+	}
+
+	memset(p_ll, 0, sizeof(struct st_jyo_property_ll));
+	p_ll->st.sym = sym;
+
+	ret = jyo_property_store(p->arena, sym->name, &p_ll->st, data_type, orig_data);
+	if (ret != JY_ESUCCESS) {
+		/* Nothing allocated from the arena is freed on errors. */
+		if (p->arena == NULL)
+			jyo_property_ll_free(p_ll);
+
+		if (ret == JY_EENOMEM)
+			p->error = JY_EENOMEM;
+		return ret;
+	}
+
+	if (jyo_property_index(p, p_ll) != JY_ESUCCESS) {
+		if (p->arena == NULL)
+			jyo_property_ll_free(p_ll);
+
+		p->error = JY_EENOMEM;
+		return JY_EENOMEM;
+	}
+
+	llh_append(&p->properties, p_ll);
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * jyo_set_property() taking the property name interned by jys_intern(), which
+ * saves hashing it.
+ */
+int
+jyo_set_property_sym(struct st_jyo *p, const struct st_jys *sym, enum e_jyo_type data_type, const void *orig_data)
+{
+	struct st_jyo_lease *l;
+	int ret;
+
+	if ((data_type != JYO_TBLOB) || (orig_data == NULL))
+		return jyo_set_property_in(p, sym, data_type, orig_data);
+
+	/* The property takes a reference of its own: dropping this one
+	 * releases the blob if it could not be set. */
+	l = jyo_lease_new(orig_data);
+	if (l == NULL) {
+		if (p != NULL)
+			p->error = JY_EENOMEM;
+		return JY_EENOMEM;
+	}
+	ret = jyo_set_property_in(p, sym, data_type, l);
+	jyo_lease_unref(l);
+
+	return ret;
+}
+
+/**
+ * Turns "p" into an object without shape: its slots become properties again,
+ * ahead of the properties set afterwards.
+ */
+static int
+jyo_unshape(struct st_jyo *p)
+{
+	const struct st_jyo_slot *slot;
+	struct st_jyo_property view;
+	struct st_jyo_property_ll *p_ll;
+	struct st_jyo_array a;
+	struct st_llhead later;
+	const void *data;
+	unsigned int i;
+	int ret;
+
+	/* The properties set afterwards are indexed again after the slots. */
+	later = p->properties;
+	llh_init(&p->properties);
+	if (p->arena == NULL)
+		free(p->index);
+	p->index = NULL;
+	p->index_size = 0;
+
+	ret = JY_ESUCCESS;
+	for (i = 0; i < p->shape->nslots; i++) {
+		slot = &p->shape->slots[i];
+		jyo_slot_view(p, slot, &view);
+		data = jyo_property_data(&view);
+		if ((jyo_get_array_elem_size(slot->data_type) > 0) &&
+		    (data != NULL)) {
+			a.data = data;
+			a.length = view.value.ref.size / jyo_get_array_elem_size(slot->data_type);
+			data = &a;
+		}
+		ret = jyo_set_property_sym(p, slot->sym, slot->data_type, data);
+		if (ret != JY_ESUCCESS)
+			break;
+
+		/* The contents of the object now belong to the property. */
+		if ((slot->data_type == JYO_TJYO) && (view.value.ref.data != NULL))
+			memset(view.value.ref.data, 0, sizeof(struct st_jyo));
+	}
+
+	while ((p_ll = (struct st_jyo_property_ll *)later.first) != NULL) {
+		llh_cut(&later, p_ll);
+		if (ret == JY_ESUCCESS)
+			ret = jyo_property_index(p, p_ll);
+		llh_append(&p->properties, p_ll);
+	}
+
+	jyo_values_free(p);
+
+	if (ret != JY_ESUCCESS)
+		p->error = ret;
+
+	return ret;
+}
+
+/**
+ * Sets up the property of an "st_jyo" struct, replacing its value in place if
+ * the property is already set.
+ *
+ * Unlike jyo_set_property(), setting the same property repeatedly does not
+ * make the "st_jyo" struct grow nor the setter be called more than once by
+ * jyo_p2j().
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param setter The name of the property to be set.
+ * @param data_type The data type enum of the data to be set.
+ * @param data The pointer to the data to be set, like jyo_set_property().
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyo_put_property(struct st_jyo *p, const char *method_name, enum e_jyo_type data_type, const void *orig_data)
+{
+	const struct st_jys *sym;
+
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(method_name != NULL, JY_EEINVAL);
+
+	if (jyo_error(p) != JY_ESUCCESS)
+		return JY_EEINVAL;
+
+	sym = jys_intern(method_name);
+	if (sym == NULL) {
+		p->error = JY_EENOMEM;
+		return JY_EENOMEM;
+	}
+
+	return jyo_put_property_sym(p, sym, data_type, orig_data);
+}
+
+/**
+ * jyo_put_property_sym() taking the blobs as leases.
+ */
+static int
+jyo_put_property_in(struct st_jyo *p, const struct st_jys *sym, enum e_jyo_type data_type, const void *orig_data)
+{
+	const struct st_jyo_slot *slot;
+	struct st_jyo_property_ll *p_ll;
+	enum e_jyo_type old_type;
+	void *data;
+	int ret;
+
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(sym != NULL, JY_EEINVAL);
+
+	if (jyo_error(p) != JY_ESUCCESS)
+		return JY_EEINVAL;
+
+	if (p->shape != NULL) {
+		slot = jyo_shape_find(p->shape, sym);
+		if (slot != NULL) {
+			/* Slots only hold values of their type and scalars in
+			 * them can't be null. */
+			if ((slot->data_type == data_type) &&
+			    ((orig_data != NULL) || !jyo_type_is_inline(data_type)))
+				return jyo_slot_store(p, slot, orig_data);
+
+			ret = jyo_unshape(p);
+			if (ret != JY_ESUCCESS)
+				return ret;
+		}
+	}
+
+	p_ll = jyo_property_find(p, sym);
+	if (p_ll == NULL)
+		return jyo_set_property_in(p, sym, data_type, orig_data);
+
+	/* Scalars of the same type are overwritten in place. Objects are
+	 * not: the contents of the old one are freed. */
+	data = jyo_property_data(&p_ll->st);
+	if ((p_ll->st.data_type == data_type) && (data_type != JYO_TSTRING) &&
+	    (data_type != JYO_TBLOB) && (data_type != JYO_TJYO) &&
+	    (jyo_get_array_elem_size(data_type) == 0) &&
+	    (data != NULL) && (orig_data != NULL)) {
+		memcpy(data, orig_data, jyo_get_type_size(data_type));
+		return JY_ESUCCESS;
+	}
+
+	/* So are arrays of the same type and length. */
+	if ((p_ll->st.data_type == data_type) &&
+	    (jyo_get_array_elem_size(data_type) > 0) &&
+	    (data != NULL) && (orig_data != NULL) &&
+	    (((const struct st_jyo_array *)orig_data)->length *
+	    jyo_get_array_elem_size(data_type) == p_ll->st.value.ref.size)) {
+		memcpy(data, ((const struct st_jyo_array *)orig_data)->data,
+		    p_ll->st.value.ref.size);
+		return JY_ESUCCESS;
+	}
+
+	old_type = p_ll->st.data_type;
+	if (jyo_type_is_inline(old_type))
+		data = NULL;
+	ret = jyo_property_store(p->arena, sym->name, &p_ll->st, data_type, orig_data);
+	if (ret != JY_ESUCCESS) {
+		if (ret == JY_EENOMEM)
+			p->error = JY_EENOMEM;
+		return ret;
+	}
+
+	/* Scalars have nothing allocated apart. */
+	if ((data != NULL) && (p->arena == NULL)) {
+		if (old_type == JYO_TBLOB) {
+			jyo_lease_unref(data);
+		} else {
+			if (old_type == JYO_TJYO)
+				jyo_free((struct st_jyo *)data);
+			free(data);
+		}
+	}
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * jyo_put_property() taking the property name interned by jys_intern(), which
+ * saves hashing it.
+ */
+int
+jyo_put_property_sym(struct st_jyo *p, const struct st_jys *sym, enum e_jyo_type data_type, const void *orig_data)
+{
+	struct st_jyo_lease *l;
+	int ret;
+
+	if ((data_type != JYO_TBLOB) || (orig_data == NULL))
+		return jyo_put_property_in(p, sym, data_type, orig_data);
+
+	/* Like jyo_set_property_sym(). */
+	l = jyo_lease_new(orig_data);
+	if (l == NULL) {
+		if (p != NULL)
+			p->error = JY_EENOMEM;
+		return JY_EENOMEM;
+	}
+	ret = jyo_put_property_in(p, sym, data_type, l);
+	jyo_lease_unref(l);
+
+	return ret;
+}
+
+/** XXX TODO COMMENT */
+static int
+jyo_get_static_mid(JNIEnv *jenv, const char *clazz, const char *method, char *sig, jclass *jcls, jmethodID *jmid)
+{
+	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(method != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(sig != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(jcls != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(jmid != NULL, JY_EEINVAL);
+
+	*jcls = (*jenv)->FindClass(jenv, clazz);
+	if ((*jcls == NULL) || ((*jenv)->ExceptionCheck(jenv))) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Could not find class \"%s\".\n", clazz);
+#endif
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+		}
+		fflush(stderr);
+
+		if (*jcls != NULL)
+			(*jenv)->DeleteLocalRef(jenv, *jcls);
+
+		*jcls = NULL;
+		*jmid = NULL;
+
+		return JY_ENOJCLASS;
+	}
+
+	*jmid = (*jenv)->GetStaticMethodID(jenv, *jcls, method, sig);
+	if ((*jmid == NULL) || ((*jenv)->ExceptionCheck(jenv))) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Could not find static method \"%s\" with signature \"%s\" for class \"%s\".\n", method, sig, clazz);
+#endif
+		if ((*jenv)->ExceptionCheck(jenv)) {
+			(*jenv)->ExceptionDescribe(jenv);
+			(*jenv)->ExceptionClear(jenv);
+		}
+		fflush(stderr);
+
+		(*jenv)->DeleteLocalRef(jenv, *jcls);
+		*jcls = NULL;
+		*jmid = NULL;
+
+		return JY_ENOTFOUND;
+	}
+
+	return JY_ESUCCESS;
+}
+
+/** XXX TODO COMMENT */
+static char *
+jyo_get_method_signature(enum e_jyo_type type_ret, void *type_ret_detail, enum e_jyo_type type_param, const char *type_param_detail)
+{
+#define SWITCH_TYPE_CAT_s(type, param) do {				\
+	switch (type) {							\
+		case JYO_TBOOLEAN:				\
+			strcat(s, "Z");					\
+			break;						\
+		case JYO_TBYTE:					\
+			strcat(s, "B");					\
+			break;						\
+		case JYO_TCHAR:					\
+			strcat(s, "C");					\
+			break;						\
+		case JYO_TSHORT:				\
+			strcat(s, "S");					\
+			break;						\
+		case JYO_TUINT:					\
+		case JYO_TINT:					\
+			strcat(s, "I");					\
+			break;						\
+		case JYO_TULONG:				\
+		case JYO_TLONG:					\
+			strcat(s, "J");					\
+			break;						\
+		case JYO_TFLOAT:				\
+			strcat(s, "F");					\
+			break;						\
+		case JYO_TDOUBLE:				\
+			strcat(s, "D");					\
+			break;						\
+		case JYO_TVOID:					\
+			strcat(s, "V");					\
+			break;						\
+		case JYO_TSTRING:				\
+			strcat(s, "L");					\
+			strcat(s, g_str_clazz_string);			\
+			strcat(s, ";");					\
+			break;						\
+		case JYO_TJYO:				\
+			strcat(s, "L");					\
+			strcat(s, ((struct st_jyo *)param)->clazz);	\
+			strcat(s, ";");					\
+			break;						\
+		case JYO_TJCLASS:				\
+			strcat(s, "L");					\
+			strcat(s, (char *)param);			\
+			strcat(s, ";");					\
+			break;						\
+		default:					\
+			break;						\
+	}								\
+} while (0)
+
+	char *s;
+	size_t slen;
+
+	/* Verify the passed parameters. */
+	if (type_param == JYO_TJCLASS)
+		JY_ASSERT_RETURN(type_param_detail != NULL, NULL);
+	else if (type_param != JYO_TSTRING)
+		JY_ASSERT_RETURN(jyo_get_type_size(type_param) > 0, NULL);
+
+	if (type_ret == JYO_TJCLASS)
+		JY_ASSERT_RETURN(type_ret_detail != NULL, NULL);
+	else if (type_ret != JYO_TSTRING)
+		JY_ASSERT_RETURN(jyo_get_type_size(type_ret) > 0, NULL);
+
+	slen = 1;	/* EOS - '\000' */
+
+	if (type_ret == JYO_TJCLASS)		/* Lpath/Class; */
+		slen += strlen(type_ret_detail) + 2;
+	else if (type_ret == JYO_TSTRING)	/* Lpath/Class; */
+		slen += strlen(g_str_clazz_string) + 2;
+	else						/* T */
+		slen += 1;
+
+	if (type_param == JYO_TJCLASS)		/* Lpath/Class; */
+		slen += strlen(type_param_detail) + 2;
+	else if (type_param == JYO_TSTRING)	/* Lpath/Class; */
+		slen += strlen(g_str_clazz_string) + 2;
+	else if (type_param == JYO_TJYO)	/* Lpath/Class; */
+		slen += strlen(((struct st_jyo *)type_param_detail)->clazz) + 2;
+	else						/* T */
+		slen += 1;
+
+	slen += 2;	/* () */
+
+	s = malloc(slen);
 	if (s == NULL)
 		return NULL;
-	*s = '\000';
+	*s = '\000';
+
+	strcat(s, "(");
+
+	SWITCH_TYPE_CAT_s(type_param, type_param_detail);
+	strcat(s, ")");
+	SWITCH_TYPE_CAT_s(type_ret, type_ret_detail);
+
+	return s;
+
+#undef SWITCH_TYPE_CAT_s
+}
+
+/**
+ * Converts "p" into a Java object and passes it to the static method "jmid" of
+ * "jcls".
+ *
+ * @param c The descriptor of the class of "p", or NULL to look it up.
+ */
+static int
+jyo_send_call(JNIEnv *jenv, struct st_jyo *p, const struct st_jyc *c, jclass jcls, jmethodID jmid)
+{
+	int ret;
+	jobject jobj;
+	jboolean jret;
+
+	if (c != NULL)
+		ret = jyo_p2j_frame(jenv, p, c, &jobj);
+	else
+		ret = jyo_p2j(jenv, p, &jobj);
+	if (ret != JY_ESUCCESS)
+		return ret;
+
+	jret = (*jenv)->CallStaticBooleanMethod(jenv, jcls, jmid, jobj);
+	(*jenv)->DeleteLocalRef(jenv, jobj);
+	if ((*jenv)->ExceptionCheck(jenv)) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+		return JY_EEXCEPTION;
+	}
+
+	return jret == JNI_FALSE ? JY_EEXCEPTION : JY_ESUCCESS;
+}
+
+/**
+ * Converts the "st_jyo" struct to a Java object (jobject) and send it to a
+ * Java static method of a defined class.
+ *
+ * @param o Pointer to the "st_jyo" struct.
+ * @param clazz Name of the receiving class.
+ * @param method Name of the receiving method.
+ *
+ * @return -1 in case of error and 0 for success.
+ */
+int
+jyo_send(JNIEnv *jenv, struct st_jyo *p, const char *clazz, const char *method)
+{
+	int ret;
+	jclass jcls;
+	jmethodID jmid;
+	char *sig;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(method != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p->clazz != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p->error == JY_ESUCCESS, p->error);
+
+	sig = jyo_get_method_signature(JYO_TBOOLEAN, NULL, JYO_TJCLASS, p->clazz);
+	if (sig == NULL)
+		return JY_EENOMEM;
+
+	ret = jyo_get_static_mid(jenv, clazz, method, sig, &jcls, &jmid);
+
+	free(sig);
+	if (ret != JY_ESUCCESS)
+		return ret;
+
+	ret = jyo_send_call(jenv, p, NULL, jcls, jmid);
+	(*jenv)->DeleteLocalRef(jenv, jcls);
+
+	return ret;
+}
+
+/**
+ * Converts the objects "objs" into the elements of "jarr", marking the ones
+ * that could not be converted in "status".
+ */
+static void
+jyo_send_batch_fill(JNIEnv *jenv, struct st_jyo **objs, size_t n, jobjectArray jarr, int *status)
+{
+	struct st_jyc *c;
+	const char *clazz;
+	jobject jobj;
+	size_t i;
+	int ret;
+
+	/* Consecutive objects of the same class share its descriptor. Class
+	 * names are interned: comparing them is comparing pointers. */
+	c = NULL;
+	clazz = NULL;
+	for (i = 0; i < n; i++) {
+		if ((objs[i] == NULL) || (objs[i]->clazz == NULL) ||
+		    (jyo_error(objs[i]) != JY_ESUCCESS)) {
+			status[i] = JY_EEINVAL;
+			continue;
+		}
+
+		if (objs[i]->clazz != clazz) {
+			if (c != NULL)
+				jyc_release(jenv, c);
+			c = NULL;
+			clazz = objs[i]->clazz;
+			ret = jyc_get_by_name(jenv, clazz, &c);
+			if (ret != JY_ESUCCESS) {
+				c = NULL;
+				clazz = NULL;
+				status[i] = ret;
+				continue;
+			}
+		}
+
+		/* Every object converts in its own local frame. */
+		if ((*jenv)->PushLocalFrame(jenv, JYO_LOCAL_FRAME) != 0) {
+			(*jenv)->ExceptionClear(jenv);
+			status[i] = JY_EENOMEM;
+			continue;
+		}
+		ret = jyo_p2j_class(jenv, objs[i], c, &jobj);
+		if (ret == JY_ESUCCESS)
+			(*jenv)->SetObjectArrayElement(jenv, jarr, (jsize)i, jobj);
+		(void)(*jenv)->PopLocalFrame(jenv, NULL);
+
+		status[i] = ret;
+	}
+
+	if (c != NULL)
+		jyc_release(jenv, c);
+}
+
+/**
+ * Converts the objects "objs" and calls the receiver "jmid" of "jcls" with
+ * them, setting the "status" of each one.
+ */
+static int
+jyo_send_batch_call(JNIEnv *jenv, struct st_jyo **objs, size_t n, jclass jcls, jmethodID jmid, int *status)
+{
+	jboolean stack[JYO_BATCH_STACK], *accepted;
+	jclass jobjcls;
+	jobjectArray jarr;
+	jbooleanArray jret;
+	jsize len;
+	size_t i;
+
+	jobjcls = (*jenv)->FindClass(jenv, "java/lang/Object");
+	if (jobjcls == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		return JY_ENOJCLASS;
+	}
+	jarr = (*jenv)->NewObjectArray(jenv, (jsize)n, jobjcls, NULL);
+	(*jenv)->DeleteLocalRef(jenv, jobjcls);
+	if (jarr == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		return JY_EENOMEM;
+	}
+
+	jyo_send_batch_fill(jenv, objs, n, jarr, status);
+
+	jret = (jbooleanArray)(*jenv)->CallStaticObjectMethod(jenv, jcls, jmid, jarr);
+	(*jenv)->DeleteLocalRef(jenv, jarr);
+	if ((*jenv)->ExceptionCheck(jenv)) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+
+		if (jret != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jret);
+
+		return JY_EEXCEPTION;
+	}
+
+	/* The objects without a status in the result were not accepted. */
+	len = jret != NULL ? (*jenv)->GetArrayLength(jenv, jret) : 0;
+	if ((size_t)len > n)
+		len = (jsize)n;
+
+	if (n <= JYO_BATCH_STACK)
+		accepted = stack;
+	else {
+		accepted = malloc(n * sizeof(jboolean));
+		if (accepted == NULL) {
+			(*jenv)->DeleteLocalRef(jenv, jret);
+			return JY_EENOMEM;
+		}
+	}
+	memset(accepted, 0, n * sizeof(jboolean));
+	if (len > 0)
+		(*jenv)->GetBooleanArrayRegion(jenv, jret, 0, len, accepted);
+	if (jret != NULL)
+		(*jenv)->DeleteLocalRef(jenv, jret);
+
+	for (i = 0; i < n; i++) {
+		if ((status[i] == JY_ESUCCESS) && (accepted[i] == JNI_FALSE))
+			status[i] = JY_EEXCEPTION;
+	}
+
+	if (accepted != stack)
+		free(accepted);
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Converts the "st_jyo" structs "objs" to Java objects and sends them all at
+ * once to a Java static method of a defined class, in a single call.
+ *
+ * The receiving method takes an "Object[]" with the objects in order and
+ * returns a "boolean[]" telling, for each one, if it was accepted. The objects
+ * that could not be converted are null in the array.
+ *
+ * @param objs The "st_jyo" structs.
+ * @param n The number of "st_jyo" structs.
+ * @param clazz Name of the receiving class.
+ * @param method Name of the receiving method.
+ * @param status Where the "e_jy_err" error code of each object will be
+ * returned, or NULL: JY_EEXCEPTION for the objects not accepted.
+ *
+ * @return The "e_jy_err" error enumerator: JY_ESUCCESS if every object was
+ * sent and accepted, or else the error of the first that was not.
+ */
+int
+jyo_send_batch(JNIEnv *jenv, struct st_jyo **objs, size_t n, const char *clazz, const char *method, int *status)
+{
+	int stack[JYO_BATCH_STACK], *st;
+	jclass jcls;
+	jmethodID jmid;
+	size_t i;
+	int ret;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN((objs != NULL) || (n == 0), JY_EEINVAL);
+	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(method != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(n <= (size_t)INT32_MAX, JY_EEINVAL);
+
+	if (n == 0)
+		return JY_ESUCCESS;
+
+	st = status;
+	if (st == NULL) {
+		if (n <= JYO_BATCH_STACK)
+			st = stack;
+		else {
+			st = malloc(n * sizeof(int));
+			if (st == NULL)
+				return JY_EENOMEM;
+		}
+	}
+
+	ret = jyo_get_static_mid(jenv, clazz, method, JYO_BATCH_SIGNATURE, &jcls, &jmid);
+	if (ret == JY_ESUCCESS) {
+		ret = jyo_send_batch_call(jenv, objs, n, jcls, jmid, st);
+		(*jenv)->DeleteLocalRef(jenv, jcls);
+	}
+
+	if (ret != JY_ESUCCESS) {
+		/* Nothing was sent. */
+		for (i = 0; i < n; i++)
+			st[i] = ret;
+	} else {
+		for (i = 0; (i < n) && (st[i] == JY_ESUCCESS); i++);
+		if (i < n)
+			ret = st[i];
+	}
+
+	if ((st != status) && (st != stack))
+		free(st);
+
+	return ret;
+}
+
+/**
+ * Pre-resolved jyo_send() target.
+ */
+struct st_jyo_target {
+	/**
+	 * Weak global reference to the receiving class. A global reference
+	 * would keep the class from ever being unloaded; instead, sending to
+	 * a target whose class was unloaded fails with JY_ENOJCLASS.
+	 */
+	jweak jcls;
+	/** The receiving static method. */
+	jmethodID jmid;
+	/** The interned class of the objects sent to this target. */
+	const char *pclazz;
+	/**
+	 * The descriptor of "pclazz", a jyc_get_by_name() reference, which
+	 * saves looking it up on each send.
+	 */
+	struct st_jyc *pc;
+};
+
+/**
+ * Resolves a jyo_send() target once, so it can be used by jyo_send_to()
+ * without any class or method lookup.
+ *
+ * @param clazz Name of the receiving class.
+ * @param method Name of the receiving static method.
+ * @param pclazz Name of the class of the objects to be sent, dotted or slash
+ * separated.
+ * @param t Where the target will be returned.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int
+jyo_target_new(JNIEnv *jenv, const char *clazz, const char *method, const char *pclazz, struct st_jyo_target **t)
+{
+	int ret;
+	jclass jcls;
+	char *sig;
+
+	JY_ASSERT_RETURN(t != NULL, JY_EEINVAL);
+	*t = NULL;
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(method != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(pclazz != NULL, JY_EEINVAL);
+
+	*t = malloc(sizeof(struct st_jyo_target));
+	if (*t == NULL)
+		return JY_EENOMEM;
+	memset(*t, 0, sizeof(struct st_jyo_target));
+
+	(*t)->pclazz = jyo_intern_clazz(pclazz);
+	if ((*t)->pclazz == NULL) {
+		jyo_target_free(jenv, *t);
+		*t = NULL;
+		return JY_EENOMEM;
+	}
+
+	ret = jyc_get_by_name(jenv, (*t)->pclazz, &(*t)->pc);
+	if (ret != JY_ESUCCESS) {
+		jyo_target_free(jenv, *t);
+		*t = NULL;
+		return ret;
+	}
+
+	sig = jyo_get_method_signature(JYO_TBOOLEAN, NULL, JYO_TJCLASS, (*t)->pclazz);
+	if (sig == NULL) {
+		jyo_target_free(jenv, *t);
+		*t = NULL;
+		return JY_EENOMEM;
+	}
+
+	ret = jyo_get_static_mid(jenv, clazz, method, sig, &jcls, &(*t)->jmid);
+	free(sig);
+	if (ret != JY_ESUCCESS) {
+		jyo_target_free(jenv, *t);
+		*t = NULL;
+		return ret;
+	}
+
+	(*t)->jcls = (*jenv)->NewWeakGlobalRef(jenv, jcls);
+	(*jenv)->DeleteLocalRef(jenv, jcls);
+	if ((*t)->jcls == NULL) {
+		jyo_target_free(jenv, *t);
+		*t = NULL;
+		return JY_EENOMEM;
+	}
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Converts the "st_jyo" struct to a Java object (jobject) and send it to a
+ * target resolved by jyo_target_new().
+ *
+ * @param t The target.
+ * @param p Pointer to the "st_jyo" struct. Its class must be the one the
+ * target was resolved for.
+ *
+ * @return The "e_jy_err" error enumerator. JY_ENOJCLASS if the receiving
+ * class has been unloaded.
+ */
+int
+jyo_send_to(JNIEnv *jenv, struct st_jyo_target *t, struct st_jyo *p)
+{
+	int ret;
+	jclass jcls;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(t != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p->clazz != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p->error == JY_ESUCCESS, p->error);
+	/* Class names are interned slash separated: comparing them is
+	 * comparing pointers. */
+	JY_ASSERT_RETURN(p->clazz == t->pclazz, JY_EEINVAL);
+
+	/* Promote the weak reference: NULL means the class was unloaded. */
+	jcls = (*jenv)->NewLocalRef(jenv, t->jcls);
+	if (jcls == NULL) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Receiving class of a send target has been unloaded at \"%s:%d\".\n", __FILE__, __LINE__);
+		fflush(stderr);
+#endif
+		return JY_ENOJCLASS;
+	}
+
+	ret = jyo_send_call(jenv, p, t->pc, jcls, t->jmid);
+	(*jenv)->DeleteLocalRef(jenv, jcls);
+
+	return ret;
+}
+
+/**
+ * Frees a target returned by jyo_target_new().
+ */
+void
+jyo_target_free(JNIEnv *jenv, struct st_jyo_target *t)
+{
+	JY_ASSERT_RETURN_VOID(jenv != NULL);
+	JY_ASSERT_RETURN_VOID(t != NULL);
+
+	if (t->jcls != NULL)
+		(*jenv)->DeleteWeakGlobalRef(jenv, t->jcls);
+	if (t->pc != NULL)
+		jyc_release(jenv, t->pc);
+	free(t);
+}
+
+/**
+ * Gets the error state ocurred with the "st_jyo" struct.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int
+jyo_error(struct st_jyo *p)
+{
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+
+	return p->error;
+}
+
+/**
+ * Creates the Java String of the string property "pp", taking it from the
+ * String cache of "c" if it has one.
+ *
+ * @return A local reference to the String or NULL.
+ */
+static jstring
+jyo_new_jstring(JNIEnv *jenv, const struct st_jyc *c, const struct st_jyo_property *pp)
+{
+	jstring jstr;
+	int ret;
+
+	if (pp->value.ref.data == NULL)
+		return NULL;
+
+	if (c->strings != NULL)
+		ret = jystr_get(jenv, c->strings, (const char *)pp->value.ref.data, &jstr);
+	else
+		ret = jyutf_new_string(jenv, (const char *)pp->value.ref.data, pp->value.ref.size - 1, &jstr);
+	if (ret != JY_ESUCCESS)
+		return NULL;
+
+	return jstr;
+}
+
+/**
+ * Creates a Java array with the elements of the array property "pp".
+ *
+ * @param ja Where the array will be returned: NULL if "pp" is a null array.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+static int
+jyo_new_jarray(JNIEnv *jenv, const struct st_jyo_property *pp, jarray *ja)
+{
+	void *elems;
+	jsize len;
+
+	*ja = NULL;
+	if (pp->value.ref.data == NULL)
+		return JY_ESUCCESS;
+
+	len = (jsize)(pp->value.ref.size / jyo_get_array_elem_size(pp->data_type));
+
+	switch (pp->data_type) {
+		case JYO_TBYTEARRAY:
+			*ja = (*jenv)->NewByteArray(jenv, len);
+			break;
+		case JYO_TSHORTARRAY:
+			*ja = (*jenv)->NewShortArray(jenv, len);
+			break;
+		case JYO_TINTARRAY:
+			*ja = (*jenv)->NewIntArray(jenv, len);
+			break;
+		case JYO_TLONGARRAY:
+			*ja = (*jenv)->NewLongArray(jenv, len);
+			break;
+		case JYO_TFLOATARRAY:
+			*ja = (*jenv)->NewFloatArray(jenv, len);
+			break;
+		case JYO_TDOUBLEARRAY:
+			*ja = (*jenv)->NewDoubleArray(jenv, len);
+			break;
+		default:
+			return JY_EEINVAL;
+	}
+	if (*ja == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		return JY_EENOMEM;
+	}
+	if (len == 0)
+		return JY_ESUCCESS;
+
+	/* Large arrays are copied straight into the pinned Java array. */
+	if (pp->value.ref.size >= JYO_ARRAY_CRITICAL_MIN) {
+		elems = (*jenv)->GetPrimitiveArrayCritical(jenv, *ja, NULL);
+		if (elems != NULL) {
+			memcpy(elems, pp->value.ref.data, pp->value.ref.size);
+			(*jenv)->ReleasePrimitiveArrayCritical(jenv, *ja, elems, 0);
+			return JY_ESUCCESS;
+		}
+		(*jenv)->ExceptionClear(jenv);
+	}
+
+	switch (pp->data_type) {
+		case JYO_TBYTEARRAY:
+			(*jenv)->SetByteArrayRegion(jenv, *ja, 0, len, pp->value.ref.data);
+			break;
+		case JYO_TSHORTARRAY:
+			(*jenv)->SetShortArrayRegion(jenv, *ja, 0, len, pp->value.ref.data);
+			break;
+		case JYO_TINTARRAY:
+			(*jenv)->SetIntArrayRegion(jenv, *ja, 0, len, pp->value.ref.data);
+			break;
+		case JYO_TLONGARRAY:
+			(*jenv)->SetLongArrayRegion(jenv, *ja, 0, len, pp->value.ref.data);
+			break;
+		case JYO_TFLOATARRAY:
+			(*jenv)->SetFloatArrayRegion(jenv, *ja, 0, len, pp->value.ref.data);
+			break;
+		case JYO_TDOUBLEARRAY:
+			(*jenv)->SetDoubleArrayRegion(jenv, *ja, 0, len, pp->value.ref.data);
+			break;
+		default:
+			break;
+	}
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Writes the property "pp" directly into the field "s" of the object "j".
+ */
+static int
+jyo_fill_jobject_field(JNIEnv *jenv, jobject j, struct st_jyo *p, const struct st_jyc *c, const struct st_jyc_setter *s, struct st_jyo_property *pp)
+{
+	jfieldID jfid;
+	jobject new_jobj;
+	int ret;
+
+	jfid = s->jfid;
+
+	if ((pp->data_type != JYO_TJYO) && (pp->data_type != JYO_TBLOB) &&
+	    (jyo_get_array_elem_size(pp->data_type) == 0))
+		JY_ASSERT_RETURN(jyo_property_data(pp) != NULL, JY_EEINVAL);
+
+	switch (pp->data_type) {
+		case JYO_TBOOLEAN:
+			(*jenv)->SetBooleanField(jenv, j, jfid, (jboolean) pp->value.b);
+			break;
+		case JYO_TBYTE:
+			(*jenv)->SetByteField(jenv, j, jfid, (jbyte) pp->value.c);
+			break;
+		case JYO_TCHAR:
+			(*jenv)->SetCharField(jenv, j, jfid, (jchar) pp->value.c);
+			break;
+		case JYO_TSHORT:
+			(*jenv)->SetShortField(jenv, j, jfid, (jshort) pp->value.s);
+			break;
+		case JYO_TINT:
+		case JYO_TUINT:
+			(*jenv)->SetIntField(jenv, j, jfid, (jint) pp->value.i);
+			break;
+		case JYO_TLONG:
+		case JYO_TULONG:
+			(*jenv)->SetLongField(jenv, j, jfid, (jlong) pp->value.l);
+			break;
+		case JYO_TFLOAT:
+			(*jenv)->SetFloatField(jenv, j, jfid, (jfloat) pp->value.f);
+			break;
+		case JYO_TDOUBLE:
+			(*jenv)->SetDoubleField(jenv, j, jfid, (jdouble) pp->value.d);
+			break;
+		case JYO_TJYO:
+			new_jobj = NULL;
+			if (pp->value.ref.data != NULL) {
+				ret = jyo_p2j(jenv, (struct st_jyo *)pp->value.ref.data, &new_jobj);
+				if (ret != JY_ESUCCESS)
+					return ret;
+			}
+			(*jenv)->SetObjectField(jenv, j, jfid, new_jobj);
+			if (new_jobj != NULL)
+				(*jenv)->DeleteLocalRef(jenv, new_jobj);
+			break;
+		case JYO_TSTRING:
+			new_jobj = jyo_new_jstring(jenv, c, pp);
+			if (new_jobj == NULL) {
+#ifdef JY_DEBUG_ERROR
+				fprintf(stderr, "Error converting a C string to Java String at \"%s:%d\".\n", __FILE__, __LINE__);
+#endif
+				break;
+			}
+			(*jenv)->SetObjectField(jenv, j, jfid, new_jobj);
+			(*jenv)->DeleteLocalRef(jenv, new_jobj);
+			break;
+		case JYO_TBYTEARRAY:
+		case JYO_TSHORTARRAY:
+		case JYO_TINTARRAY:
+		case JYO_TLONGARRAY:
+		case JYO_TFLOATARRAY:
+		case JYO_TDOUBLEARRAY:
+			ret = jyo_new_jarray(jenv, pp, &new_jobj);
+			if (ret != JY_ESUCCESS)
+				return ret;
+			(*jenv)->SetObjectField(jenv, j, jfid, new_jobj);
+			if (new_jobj != NULL)
+				(*jenv)->DeleteLocalRef(jenv, new_jobj);
+			break;
+		case JYO_TBLOB:
+			new_jobj = NULL;
+			if (pp->value.ref.data != NULL) {
+				ret = jyo_lease_lend(jenv, pp->value.ref.data, &new_jobj);
+				if (ret != JY_ESUCCESS)
+					return ret;
+			}
+			(*jenv)->SetObjectField(jenv, j, jfid, new_jobj);
+			if (new_jobj != NULL)
+				(*jenv)->DeleteLocalRef(jenv, new_jobj);
+			break;
+		default:
+			JY_WARN_ENOSYS();
+			break;
+	}
+
+	if ((*jenv)->ExceptionCheck(jenv)) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Exception ocurred while setting field \"%s\" of an object of class \"%s\".\n", pp->sym->name, p->clazz);
+#endif
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+		return JY_EEXCEPTION;
+	}
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Calls the setter of the property "pp" on the object "j", or writes its field.
+ *
+ * @param c The descriptor of the class of "j".
+ */
+static int
+jyo_fill_jobject_property(JNIEnv *jenv, jobject j, struct st_jyo *p, const struct st_jyc *c, struct st_jyo_property *pp)
+{
+	const struct st_jyc_setter *s;
+	jmethodID jmid;
+	jobject new_jobj;
+	jstring new_jstr;
+	int ret, rettype;
+
+	ret = jyc_get_setter(c, pp->sym, pp->data_type,
+	    ((pp->data_type == JYO_TJYO) && (pp->value.ref.data != NULL)) ?
+	    ((struct st_jyo *)pp->value.ref.data)->clazz : NULL, &s);
+	if (ret != JY_ESUCCESS) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Could not find method \"%s\" accepting %s of an object of class \"%s\" at \"%s:%d\".\n", pp->sym->name, jyo_get_type_name(pp->data_type), p->clazz, __FILE__, __LINE__);
+		fflush(stderr);
+#endif
+		return JY_ENOTFOUND;
+	}
+
+	/* Field properties are written without calling any method. */
+	if (s->jfid != NULL)
+		return jyo_fill_jobject_field(jenv, j, p, c, s, pp);
+
+	jmid = s->jmid;
+	rettype = s->rettype;
+
+	if ((pp->data_type != JYO_TVOID) && (pp->data_type != JYO_TBLOB) &&
+	    (jyo_get_array_elem_size(pp->data_type) == 0))
+		JY_ASSERT_RETURN(jyo_property_data(pp) != NULL, JY_EEINVAL);
+
+	switch (pp->data_type) {
+		case JYO_TBOOLEAN:
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, (jboolean) pp->value.b);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jboolean) pp->value.b);
+			break;
+		case JYO_TBYTE:
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, (jbyte) pp->value.c);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jbyte) pp->value.c);
+			break;
+		case JYO_TCHAR:
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, (jchar) pp->value.c);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jchar) pp->value.c);
+			break;
+		case JYO_TSHORT:
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, (jshort) pp->value.s);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jshort) pp->value.s);
+			break;
+		case JYO_TINT:
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, (jint) pp->value.i);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jint) pp->value.i);
+			break;
+		case JYO_TLONG:
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, (jlong) pp->value.l);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jlong) pp->value.l);
+			break;
+		case JYO_TFLOAT:
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, (jfloat) pp->value.f);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jfloat) pp->value.f);
+			break;
+		case JYO_TDOUBLE:
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, (jdouble) pp->value.d);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jdouble) pp->value.d);
+			break;
+		case JYO_TVOID:
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid);
+			break;
+		case JYO_TJYO:
+			ret = jyo_p2j(jenv, (struct st_jyo *)pp->value.ref.data, &new_jobj);
+			if (ret != JY_ESUCCESS) {
+#ifdef JY_DEBUG_ERROR
+				fprintf(stderr, "%s while converting an \"st_jyo\" structure to \"jobject\" at \"%s:%d\".\n", jy_strerror(ret), __FILE__, __LINE__);
+				fflush(stderr);
+#endif
+				return ret;
+			}
+
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, new_jobj);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, new_jobj);
+			(*jenv)->DeleteLocalRef(jenv, new_jobj);
+
+			break;
+		case JYO_TSTRING:
+			new_jstr = jyo_new_jstring(jenv, c, pp);
+			if (new_jstr != NULL) {
+				if (rettype == JYO_TVOID)
+					(*jenv)->CallVoidMethod(jenv, j, jmid, new_jstr);
+				else if (rettype == JYO_TBOOLEAN)
+					(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, new_jstr);
+				(*jenv)->DeleteLocalRef(jenv, new_jstr);
+				fflush(stderr);
+#ifdef JY_DEBUG_ERROR
+			} else {
+				fprintf(stderr, "Error converting a C string to Java String at \"%s:%d\".\n", __FILE__, __LINE__);
+#endif
+			}
+
+			break;
+
+		case JYO_TBYTEARRAY:
+		case JYO_TSHORTARRAY:
+		case JYO_TINTARRAY:
+		case JYO_TLONGARRAY:
+		case JYO_TFLOATARRAY:
+		case JYO_TDOUBLEARRAY:
+			ret = jyo_new_jarray(jenv, pp, &new_jobj);
+			if (ret != JY_ESUCCESS)
+				return ret;
+
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, new_jobj);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, new_jobj);
+			if (new_jobj != NULL)
+				(*jenv)->DeleteLocalRef(jenv, new_jobj);
+
+			break;
+
+		case JYO_TBLOB:
+			new_jobj = NULL;
+			if (pp->value.ref.data != NULL) {
+				ret = jyo_lease_lend(jenv, pp->value.ref.data, &new_jobj);
+				if (ret != JY_ESUCCESS)
+					return ret;
+			}
+
+			if (rettype == JYO_TVOID)
+				(*jenv)->CallVoidMethod(jenv, j, jmid, new_jobj);
+			else if (rettype == JYO_TBOOLEAN)
+				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, new_jobj);
+			if (new_jobj != NULL)
+				(*jenv)->DeleteLocalRef(jenv, new_jobj);
 
-	strcat(s, "(");
+			break;
 
-	SWITCH_TYPE_CAT_s(type_param, type_param_detail);
-	strcat(s, ")");
-	SWITCH_TYPE_CAT_s(type_ret, type_ret_detail);
+		case JYO_TJCLASS:
+		default:
+			JY_WARN_ENOSYS();
+			/*(*jenv)->DeleteLocalRef(jenv, jcls);
+			return JY_EENOSYS;*/
+			break;
+	}
 
-	return s;
+	if ((*jenv)->ExceptionCheck(jenv)) {
+#ifdef JY_DEBUG_ERROR
+		fprintf(stderr, "Exception ocurred while calling method \"%s\" of an object of class \"%s\".\n", pp->sym->name, p->clazz);
+#endif
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+		return JY_EEXCEPTION;
+	}
 
-#undef SWITCH_TYPE_CAT_s
+	return JY_ESUCCESS;
 }
 
 /**
- * Converts the "st_jyo" struct to a Java object (jobject) and send it to a
- * Java static method of a defined class.
- *
- * @param o Pointer to the "st_jyo" struct.
- * @param clazz Name of the receiving class.
- * @param method Name of the receiving method.
+ * Calls the setters of every property of "p" on the object "j".
  *
- * @return -1 in case of error and 0 for success.
+ * @param c The descriptor of the class of "j".
  */
-int
-jyo_send(JNIEnv *jenv, struct st_jyo *p, const char *clazz, const char *method)
+static int
+jyo_fill_jobject(JNIEnv *jenv, jobject j, struct st_jyo *p, const struct st_jyc *c)
 {
+	struct st_jyo_property_ll *p_ll;
+	struct st_jyo_property view;
+	unsigned int i;
 	int ret;
-	jobject jobj;
-	jclass jcls;
-	jmethodID jmid;
-	char *sig;
-	jboolean jret;
 
 	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(clazz != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(method != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(p->clazz != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(p->error == JY_ESUCCESS, p->error);
+	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(c != NULL, JY_EEINVAL);
+
+	/* The slots were set before any property of the list, and their
+	 * values are laid out in the same order. */
+	if (p->shape != NULL) {
+		for (i = 0; i < p->shape->nslots; i++) {
+			jyo_slot_view(p, &p->shape->slots[i], &view);
+			ret = jyo_fill_jobject_property(jenv, j, p, c, &view);
+			if (ret != JY_ESUCCESS)
+				return ret;
+		}
+	}
 
-	sig = jyo_get_method_signature(JYO_TBOOLEAN, NULL, JYO_TJCLASS, p->clazz);
-	if (sig == NULL)
-		return JY_EENOMEM;
+	for (p_ll = (struct st_jyo_property_ll *)p->properties.first; p_ll != NULL;
+	    p_ll = (struct st_jyo_property_ll *)p_ll->ll.next) {
+#ifdef JY_DEBUG_VERBOSE
+		printf("DEBUG: configurando propriedade \"%s\" do objeto de classe \"%s\".\n", p_ll->st.sym->name, p->clazz);
+		fflush(stdout);
+#endif
 
-	ret = jyo_get_static_mid(jenv, clazz, method, sig, &jcls, &jmid);
+		ret = jyo_fill_jobject_property(jenv, j, p, c, &p_ll->st);
+		if (ret != JY_ESUCCESS)
+			return ret;
+	}
 
-	free(sig);
+	return JY_ESUCCESS;
+}
+
+/**
+ * Converts "p" into a new object of the class of "c", in the local frame of
+ * the caller.
+ */
+static int
+jyo_p2j_class(JNIEnv *jenv, struct st_jyo *p, const struct st_jyc *c, jobject *j)
+{
+	int ret;
+
+	ret = jyc_new_object(jenv, c, j);
 	if (ret != JY_ESUCCESS)
 		return ret;
 
-	ret = jyo_p2j(jenv, p, &jobj);
+	return jyo_fill_jobject(jenv, *j, p, c);
+}
+
+/**
+ * Converts "p" into a new object of the class of "c", in a local frame of its
+ * own which only lets the new object out: the references its properties leave
+ * behind are released with it, so each nesting level is converted in its own
+ * frame.
+ */
+static int
+jyo_p2j_frame(JNIEnv *jenv, struct st_jyo *p, const struct st_jyc *c, jobject *j)
+{
+	jobject jnew;
+	int ret;
+
+	*j = NULL;
+
+	if ((*jenv)->PushLocalFrame(jenv, JYO_LOCAL_FRAME) != 0) {
+		(*jenv)->ExceptionClear(jenv);
+		return JY_EENOMEM;
+	}
+
+	ret = jyo_p2j_class(jenv, p, c, &jnew);
 	if (ret != JY_ESUCCESS) {
-		(*jenv)->DeleteLocalRef(jenv, jcls);
+		(void)(*jenv)->PopLocalFrame(jenv, NULL);
 		return ret;
 	}
 
-	jret = (*jenv)->CallStaticBooleanMethod(jenv, jcls, jmid, jobj);
-	(*jenv)->DeleteLocalRef(jenv, jcls);
-	(*jenv)->DeleteLocalRef(jenv, jobj);
-	if ((*jenv)->ExceptionCheck(jenv)) {
-		(*jenv)->ExceptionDescribe(jenv);
-		(*jenv)->ExceptionClear(jenv);
-		fflush(stderr);
-		return JY_EEXCEPTION;
-	}
+	*j = (*jenv)->PopLocalFrame(jenv, jnew);
 
-	return jret == JNI_FALSE ? JY_EEXCEPTION : JY_ESUCCESS;
+	return JY_ESUCCESS;
 }
 
 /**
- * Gets the error state ocurred with the "st_jyo" struct.
+ * Converts an "st_jyo" struct into a "jobject".
  *
  * @return The "e_jy_err" error enumerator.
  */
 int
-jyo_error(struct st_jyo *p)
+jyo_p2j(JNIEnv *jenv, struct st_jyo *p, jobject *j)
 {
+	struct st_jyc *c;
+	int ret;
+
+	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
+	memset(j, 0, sizeof(jobject));
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p->clazz != NULL, JY_EEINVAL);
 
-	return p->error;
+	if (jyo_error(p) != JY_ESUCCESS)
+		return JY_EEINVAL;
+
+	/* The class, its constructor and its setters are cached by name. */
+	ret = jyc_get_by_name(jenv, p->clazz, &c);
+	if (ret != JY_ESUCCESS)
+		return ret;
+
+	ret = jyo_p2j_frame(jenv, p, c, j);
+	jyc_release(jenv, c);
+
+	return ret;
 }
 
-/** XXX TODO COMMENT */
-static jobject
-jyo_new_jobject(JNIEnv *jenv, const char *clazz)
-{
-	jclass jcls;
-	jmethodID jmid;
-	jobject jobj;
+/*
+ * The wire format of jyo_p2j_wire(), read by com.googlecode.jnyikes.Wire.
+ */
 
-	JY_ASSERT_RETURN(jenv != NULL, NULL);
-	JY_ASSERT_RETURN(clazz != NULL, NULL);
+/** Initial size of a wire buffer. */
+#define JYO_WIRE_MIN_SIZE 256
 
-	jcls = (*jenv)->FindClass(jenv, clazz);
-	if ((jcls == NULL) || ((*jenv)->ExceptionCheck(jenv))) {
-		if ((*jenv)->ExceptionCheck(jenv)) {
-			(*jenv)->ExceptionDescribe(jenv);
-			(*jenv)->ExceptionClear(jenv);
-			fflush(stderr);
-		}
+/** Largest wire buffer a thread keeps between two messages. */
+#define JYO_WIRE_KEEP_SIZE (1024 * 1024)
 
-		if (jcls != NULL)
-			(*jenv)->DeleteLocalRef(jenv, jcls);
+/** Number of names a wire buffer remembers, a power of 2. */
+#define JYO_WIRE_NAMES_SIZE 64
 
-		return NULL;
-	}
+#define JYO_WIRE_CLASS "com/googlecode/jnyikes/Wire"
+#define JYO_WIRE_SIGNATURE "(Ljava/nio/ByteBuffer;)Ljava/lang/Object;"
 
-	jmid = (*jenv)->GetMethodID(jenv, jcls, "<init>", "()V");
-	if ((*jenv)->ExceptionCheck(jenv)) {
-		(*jenv)->ExceptionDescribe(jenv);
-		(*jenv)->ExceptionClear(jenv);
-		fflush(stderr);
-		(*jenv)->DeleteLocalRef(jenv, jcls);
-		return NULL;
-	}
+/**
+ * A message being encoded and the names it already defined.
+ */
+struct st_jyo_wire {
+	unsigned char *data;
+	size_t len;
+	size_t size;
+	/**
+	 * The interned class and property names already defined and their
+	 * references, by address. Names that do not fit are defined again.
+	 */
+	const char *names[JYO_WIRE_NAMES_SIZE];
+	unsigned int refs[JYO_WIRE_NAMES_SIZE];
+	/** The number of names defined so far. */
+	unsigned int nnames;
+	/** The first error, which stops the encoding. */
+	int error;
+};
 
-	jobj = (*jenv)->NewObject(jenv, jcls, jmid);
-	(*jenv)->DeleteLocalRef(jenv, jcls);
-	if ((*jenv)->ExceptionCheck(jenv)) {
-		(*jenv)->ExceptionDescribe(jenv);
-		(*jenv)->ExceptionClear(jenv);
-		fflush(stderr);
-		return NULL;
-	}
+static pthread_key_t g_jyo_wire_key;
+static pthread_once_t g_jyo_wire_once = PTHREAD_ONCE_INIT;
+
+/** The decoder class and method, resolved once by jyo_wire_jinit(). */
+static jclass g_jyo_wire_jcls = NULL;
+static jmethodID g_jyo_wire_mid = NULL;
+static pthread_mutex_t g_jyo_wire_jinit_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+jyo_wire_destroy(void *w_v)
+{
+	struct st_jyo_wire *w;
 
-	return jobj;
+	w = w_v;
+	free(w->data);
+	free(w);
 }
 
-/** XXX TODO COMMENT */
-static int
-jyo_fill_jobject_property(JNIEnv *jenv, jobject j, struct st_jyo *p, struct st_jyo_property *pp)
+static void
+jyo_wire_init(void)
 {
-	jclass jcls;
-	jmethodID jmid;
-	jobject new_jobj;
-	jstring new_jstr;
-	char *sig;
-	int ret, rettype;
+	(void)pthread_key_create(&g_jyo_wire_key, jyo_wire_destroy);
+}
 
-	jcls = (*jenv)->GetObjectClass(jenv, j);
-	if ((jcls == NULL) || (*jenv)->ExceptionCheck(jenv)) {
-#ifdef JY_DEBUG_ERROR
-		fprintf(stderr, "Could not get object class at \"%s:%d\".\n", __FILE__, __LINE__);
-#endif
-		if ((*jenv)->ExceptionCheck(jenv)) {
-			(*jenv)->ExceptionDescribe(jenv);
-			(*jenv)->ExceptionClear(jenv);
-		}
-		fflush(stderr);
+/**
+ * Gets the empty wire buffer of the calling thread.
+ */
+static struct st_jyo_wire *
+jyo_wire_get(void)
+{
+	struct st_jyo_wire *w;
 
-		if (jcls != NULL)
-			(*jenv)->DeleteLocalRef(jenv, jcls);
+	(void)pthread_once(&g_jyo_wire_once, jyo_wire_init);
 
-		return JY_EEINVAL;
+	w = pthread_getspecific(g_jyo_wire_key);
+	if (w == NULL) {
+		w = calloc(1, sizeof(struct st_jyo_wire));
+		if (w == NULL)
+			return NULL;
+		if (pthread_setspecific(g_jyo_wire_key, w) != 0) {
+			free(w);
+			return NULL;
+		}
 	}
 
-#define JY_GET_METHOD(jenv, jcls, jmid, set, sig, tret, dret, tpar, dpar) \
-do {									\
-	if ((*jenv)->ExceptionCheck(jenv))				\
-		(*jenv)->ExceptionClear(jenv);				\
-	if (sig != NULL)						\
-		free(sig);						\
-									\
-	sig = jyo_get_method_signature(tret, dret, tpar, dpar);	\
-	JY_ASSERT_RETURN(sig != NULL, JY_EEINVAL);		\
-									\
-	jmid = (*jenv)->GetMethodID(jenv, jcls, set, sig);		\
-} while (0)
+	w->len = 0;
+	w->nnames = 0;
+	w->error = JY_ESUCCESS;
+	memset(w->names, 0, sizeof(w->names));
 
-	sig = NULL;
-	jmid = 0;
+	return w;
+}
 
-	/* Try to find the method with "void" return type. */
-	if (jmid == 0) {
-		JY_GET_METHOD(jenv, jcls, jmid, pp->method_name, sig, JYO_TVOID, NULL, pp->data_type, pp->data);
-		rettype = JYO_TVOID;
-	}
+/**
+ * Makes room for "n" more bytes in "w".
+ */
+static jy_bool
+jyo_wire_reserve(struct st_jyo_wire *w, size_t n)
+{
+	unsigned char *data;
+	size_t size;
 
-	/* Try to find the method with "boolean" return type. */
-	if (jmid == 0) {
-		JY_GET_METHOD(jenv, jcls, jmid, pp->method_name, sig, JYO_TBOOLEAN, NULL, pp->data_type, pp->data);
-		rettype = JYO_TBOOLEAN;
+	if (w->len + n <= w->size)
+		return JY_TRUE;
+	if (w->error != JY_ESUCCESS)
+		return JY_FALSE;
+
+	size = w->size != 0 ? w->size : JYO_WIRE_MIN_SIZE;
+	while (size < w->len + n)
+		size *= 2;
+	data = realloc(w->data, size);
+	if (data == NULL) {
+		w->error = JY_EENOMEM;
+		return JY_FALSE;
 	}
+	w->data = data;
+	w->size = size;
 
-	if ((jmid == 0) && (pp->data_type == JYO_TJYO)) {
-		/* Try to find the method with "java/lang/Object" parameter and "void" return type. */
-		if (jmid == 0) {
-			JY_GET_METHOD(jenv, jcls, jmid, pp->method_name, sig, JYO_TVOID, NULL, JYO_TJCLASS, g_str_clazz_object);
-			rettype = JYO_TVOID;
-		}
+	return JY_TRUE;
+}
 
-		/* Try to find the method with "java/lang/Object" parameter and "boolean" return type. */
-		if (jmid == 0) {
-			JY_GET_METHOD(jenv, jcls, jmid, pp->method_name, sig, JYO_TBOOLEAN, NULL, JYO_TJCLASS, g_str_clazz_object);
-			rettype = JYO_TBOOLEAN;
-		}
-	}
+static void
+jyo_wire_put_byte(struct st_jyo_wire *w, unsigned char b)
+{
+	if (jyo_wire_reserve(w, 1))
+		w->data[w->len++] = b;
+}
 
-#if 0
-	sig = jyo_get_method_signature(JYO_TVOID, NULL, pp->data_type, pp->data);
-	JY_ASSERT_RETURN(sig != NULL, JY_EEINVAL);
+/**
+ * Writes "v" 7 bits at a time, the least significant first, with the high
+ * bit set on every byte but the last.
+ */
+static void
+jyo_wire_put_varint(struct st_jyo_wire *w, uint64_t v)
+{
+	if (!jyo_wire_reserve(w, 10))
+		return;
 
-	jmid = (*jenv)->GetMethodID(jenv, jcls, pp->method_name, sig);
-	if ((jmid == 0) && (pp->data_type == JYO_TJYO)) {
-		if ((*jenv)->ExceptionCheck(jenv))
-			(*jenv)->ExceptionClear(jenv);
+	while (v >= 0x80) {
+		w->data[w->len++] = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	w->data[w->len++] = (unsigned char)v;
+}
 
-		free(sig);
-		sig = jyo_get_method_signature(JYO_TVOID, NULL, JYO_TJCLASS, g_str_clazz_object);
-		JY_ASSERT_RETURN(sig != NULL, JY_EEINVAL);
+/**
+ * Writes a signed integer as a varint, its sign moved to the lowest bit so
+ * that small negative numbers stay short.
+ */
+static void
+jyo_wire_put_zigzag(struct st_jyo_wire *w, int64_t v)
+{
+	jyo_wire_put_varint(w, ((uint64_t)v << 1) ^ -((uint64_t)v >> 63));
+}
 
-		jmid = (*jenv)->GetMethodID(jenv, jcls, pp->method_name, sig);
-	}
+/**
+ * Writes "n" elements of "size" bytes in little endian order.
+ */
+static void
+jyo_wire_put_le(struct st_jyo_wire *w, const void *data, size_t n, size_t size)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	const unsigned char *s;
+	size_t i, k;
 #endif
 
-	if ((jmid == 0) || (*jenv)->ExceptionCheck(jenv)) {
-#ifdef JY_DEBUG_ERROR
-		fprintf(stderr, "Could not find method \"%s\" with signature \"%s\" of an object of class \"%s\" at \"%s:%d\".\n", pp->method_name, sig, p->clazz, __FILE__, __LINE__);
-#endif
+	if ((n == 0) || !jyo_wire_reserve(w, n * size))
+		return;
 
-		free(sig);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	for (s = data, i = 0; i < n; i++, s += size) {
+		for (k = 0; k < size; k++)
+			w->data[w->len++] = s[size - 1 - k];
+	}
+#else
+	memcpy(w->data + w->len, data, n * size);
+	w->len += n * size;
+#endif
+}
 
-		if ((*jenv)->ExceptionCheck(jenv)) {
-			(*jenv)->ExceptionDescribe(jenv);
-			(*jenv)->ExceptionClear(jenv);
+/**
+ * Writes a reference to the interned name "name": the number of a name
+ * already defined plus 1, or 0 followed by its length and bytes to define it
+ * with the next number.
+ */
+static void
+jyo_wire_put_name(struct st_jyo_wire *w, const char *name)
+{
+	unsigned int h, i;
+	size_t len;
+
+	h = (unsigned int)((uintptr_t)name >> 3) & (JYO_WIRE_NAMES_SIZE - 1);
+	for (i = 0; i < JYO_WIRE_NAMES_SIZE; i++) {
+		if (w->names[h] == name) {
+			jyo_wire_put_varint(w, w->refs[h] + 1);
+			return;
 		}
-		fflush(stderr);
-		(*jenv)->DeleteLocalRef(jenv, jcls);
-		return JY_ENOTFOUND;
+		if (w->names[h] == NULL)
+			break;
+		h = (h + 1) & (JYO_WIRE_NAMES_SIZE - 1);
+	}
+
+	/* Keep a quarter of the table empty so that lookups stay short. */
+	if ((w->names[h] == NULL) &&
+	    (w->nnames < JYO_WIRE_NAMES_SIZE - JYO_WIRE_NAMES_SIZE / 4)) {
+		w->names[h] = name;
+		w->refs[h] = w->nnames;
 	}
+	w->nnames++;
+
+	len = strlen(name);
+	jyo_wire_put_varint(w, 0);
+	jyo_wire_put_varint(w, len);
+	jyo_wire_put_le(w, name, len, 1);
+}
+
+static void jyo_wire_put_object(struct st_jyo_wire *w, const struct st_jyo *p);
 
-	if (pp->data_type != JYO_TVOID)
-		JY_ASSERT_RETURN(pp->data != NULL, JY_EEINVAL);
+/**
+ * Writes a property: its name, its type and its value.
+ */
+static void
+jyo_wire_put_property(struct st_jyo_wire *w, const struct st_jyo_property *pp)
+{
+	size_t esize;
+
+	jyo_wire_put_name(w, pp->sym->name);
 
 	switch (pp->data_type) {
 		case JYO_TBOOLEAN:
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid, (jboolean) *((jboolean *)pp->data));
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jboolean) *((jboolean *)pp->data));
+			jyo_wire_put_byte(w, JYO_TBOOLEAN);
+			jyo_wire_put_byte(w, pp->value.b != JY_FALSE);
 			break;
 		case JYO_TBYTE:
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid, (jbyte) *((char *)pp->data));
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jbyte) *((char *)pp->data));
+			jyo_wire_put_byte(w, JYO_TBYTE);
+			jyo_wire_put_byte(w, (unsigned char)pp->value.c);
 			break;
 		case JYO_TCHAR:
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid, (jchar) *((char *)pp->data));
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jchar) *((char *)pp->data));
+			jyo_wire_put_byte(w, JYO_TCHAR);
+			jyo_wire_put_varint(w, (jchar)pp->value.c);
 			break;
 		case JYO_TSHORT:
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid, (jshort) *((short *)pp->data));
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jshort) *((short *)pp->data));
+			jyo_wire_put_byte(w, JYO_TSHORT);
+			jyo_wire_put_zigzag(w, pp->value.s);
 			break;
-		case JYO_TINT:
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid, (jint) *((int *)pp->data));
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jint) *((int *)pp->data));
+		case JYO_TINT:
+		case JYO_TUINT:
+			jyo_wire_put_byte(w, JYO_TINT);
+			jyo_wire_put_zigzag(w, (jint)pp->value.i);
 			break;
 		case JYO_TLONG:
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid, (jlong) *((long *)pp->data));
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jlong) *((long *)pp->data));
+		case JYO_TULONG:
+			jyo_wire_put_byte(w, JYO_TLONG);
+			jyo_wire_put_zigzag(w, (jlong)pp->value.l);
 			break;
 		case JYO_TFLOAT:
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid, (jfloat) *((float *)pp->data));
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jfloat) *((float *)pp->data));
+			jyo_wire_put_byte(w, JYO_TFLOAT);
+			jyo_wire_put_le(w, &pp->value.f, 1, sizeof(float));
 			break;
 		case JYO_TDOUBLE:
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid, (jdouble) *((double *)pp->data));
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, (jdouble) *((double *)pp->data));
+			jyo_wire_put_byte(w, JYO_TDOUBLE);
+			jyo_wire_put_le(w, &pp->value.d, 1, sizeof(double));
 			break;
 		case JYO_TVOID:
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid);
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid);
+			jyo_wire_put_byte(w, JYO_TVOID);
 			break;
-		case JYO_TJYO:
-			ret = jyo_p2j(jenv, (struct st_jyo *)pp->data, &new_jobj);
-			if (ret != JY_ESUCCESS) {
-#ifdef JY_DEBUG_ERROR
-				fprintf(stderr, "%s while converting an \"st_jyo\" structure to \"jobject\" at \"%s:%d\".\n", jy_strerror(ret), __FILE__, __LINE__);
-				fflush(stderr);
-#endif
-				free(sig);
-				(*jenv)->DeleteLocalRef(jenv, jcls);
-				return ret;
+		case JYO_TSTRING:
+			jyo_wire_put_byte(w, JYO_TSTRING);
+			if (pp->value.ref.data == NULL) {
+				jyo_wire_put_varint(w, 0);
+				break;
 			}
-
-			if (rettype == JYO_TVOID)
-				(*jenv)->CallVoidMethod(jenv, j, jmid, new_jobj);
-			else if (rettype == JYO_TBOOLEAN)
-				(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, new_jobj);
-			(*jenv)->DeleteLocalRef(jenv, new_jobj);
-
+			jyo_wire_put_varint(w, pp->value.ref.size);
+			jyo_wire_put_le(w, pp->value.ref.data, pp->value.ref.size - 1, 1);
 			break;
-		case JYO_TSTRING:
-			new_jstr = (*jenv)->NewStringUTF(jenv, (char *)pp->data);
-			if (new_jstr != NULL) {
-				if (rettype == JYO_TVOID)
-					(*jenv)->CallVoidMethod(jenv, j, jmid, new_jstr);
-				else if (rettype == JYO_TBOOLEAN)
-					(void)(*jenv)->CallBooleanMethod(jenv, j, jmid, new_jstr);
-				(*jenv)->DeleteLocalRef(jenv, new_jstr);
-				fflush(stderr);
-#ifdef JY_DEBUG_ERROR
-			} else {
-				fprintf(stderr, "Error converting a C string to Java String at \"%s:%d\".\n", __FILE__, __LINE__);
-#endif
+		case JYO_TJYO:
+			jyo_wire_put_byte(w, JYO_TJYO);
+			jyo_wire_put_byte(w, pp->value.ref.data != NULL);
+			if (pp->value.ref.data != NULL)
+				jyo_wire_put_object(w, pp->value.ref.data);
+			break;
+		case JYO_TBYTEARRAY:
+		case JYO_TSHORTARRAY:
+		case JYO_TINTARRAY:
+		case JYO_TLONGARRAY:
+		case JYO_TFLOATARRAY:
+		case JYO_TDOUBLEARRAY:
+			jyo_wire_put_byte(w, pp->data_type);
+			if (pp->value.ref.data == NULL) {
+				jyo_wire_put_varint(w, 0);
+				break;
 			}
-
+			esize = jyo_get_array_elem_size(pp->data_type);
+			jyo_wire_put_varint(w, pp->value.ref.size / esize + 1);
+			jyo_wire_put_le(w, pp->value.ref.data, pp->value.ref.size / esize, esize);
 			break;
-
-		case JYO_TJCLASS:
 		default:
-			JY_WARN_ENOSYS();
-			/*(*jenv)->DeleteLocalRef(jenv, jcls);
-			return JY_EENOSYS;*/
+			/* Blobs are native memory that a message cannot carry. */
+			if (w->error == JY_ESUCCESS)
+				w->error = JY_EENOSYS;
 			break;
 	}
+}
 
-	if ((*jenv)->ExceptionCheck(jenv)) {
-#ifdef JY_DEBUG_ERROR
-		fprintf(stderr, "Exception ocurred while calling method \"%s\" with signature \"%s\" of an object of class \"%s\".\n", pp->method_name, sig, p->clazz);
-#endif
-		free(sig);
-		(*jenv)->ExceptionDescribe(jenv);
-		(*jenv)->ExceptionClear(jenv);
-		fflush(stderr);
-		(*jenv)->DeleteLocalRef(jenv, jcls);
-		return JY_EEXCEPTION;
+/**
+ * Writes an object: its class name, its number of properties and the
+ * properties, in the order jyo_p2j() would set them.
+ */
+static void
+jyo_wire_put_object(struct st_jyo_wire *w, const struct st_jyo *p)
+{
+	const struct st_jyo_property_ll *p_ll;
+	struct st_jyo_property view;
+	unsigned int i, n;
+
+	if ((p->clazz == NULL) || (p->error != JY_ESUCCESS)) {
+		if (w->error == JY_ESUCCESS)
+			w->error = JY_EEINVAL;
+		return;
 	}
 
-	free(sig);
+	n = p->shape != NULL ? p->shape->nslots : 0;
+	for (p_ll = (const struct st_jyo_property_ll *)p->properties.first; p_ll != NULL;
+	    p_ll = (const struct st_jyo_property_ll *)p_ll->ll.next)
+		n++;
 
-	return JY_ESUCCESS;
+	jyo_wire_put_name(w, p->clazz);
+	jyo_wire_put_varint(w, n);
+
+	if (p->shape != NULL) {
+		for (i = 0; i < p->shape->nslots; i++) {
+			jyo_slot_view(p, &p->shape->slots[i], &view);
+			jyo_wire_put_property(w, &view);
+		}
+	}
+
+	for (p_ll = (const struct st_jyo_property_ll *)p->properties.first;
+	    (p_ll != NULL) && (w->error == JY_ESUCCESS);
+	    p_ll = (const struct st_jyo_property_ll *)p_ll->ll.next)
+		jyo_wire_put_property(w, &p_ll->st);
 }
 
-/** XXX TODO COMMENT */
+/**
+ * Encodes "p" into the empty buffer "w".
+ */
 static int
-jyo_fill_jobject(JNIEnv *jenv, jobject j, struct st_jyo *p)
+jyo_wire_encode_in(struct st_jyo_wire *w, const struct st_jyo *p)
 {
-	struct st_jyo_property_ll *p_ll;
-	jclass jcls;
+	jyo_wire_put_object(w, p);
+
+	return w->error;
+}
+
+/**
+ * Encodes an "st_jyo" struct in the wire format read by the Java class
+ * "com.googlecode.jnyikes.Wire".
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int
+jyo_wire_encode(const struct st_jyo *p, void **buf, size_t *size)
+{
+	struct st_jyo_wire *w;
 	int ret;
 
-	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(buf != NULL, JY_EEINVAL);
+	*buf = NULL;
+	JY_ASSERT_RETURN(size != NULL, JY_EEINVAL);
+	*size = 0;
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
-
-	jcls = (*jenv)->GetObjectClass(jenv, j);
-	if ((jcls == NULL) || (*jenv)->ExceptionCheck(jenv)) {
-#ifdef JY_DEBUG_ERROR
-		fprintf(stderr, "Could not get object class at \"%s:%d\".\n", __FILE__, __LINE__);
-#endif
-		if ((*jenv)->ExceptionCheck(jenv)) {
-			(*jenv)->ExceptionDescribe(jenv);
-			(*jenv)->ExceptionClear(jenv);
-		}
-		fflush(stderr);
 
-		if (jcls != NULL)
-			(*jenv)->DeleteLocalRef(jenv, jcls);
+	w = calloc(1, sizeof(struct st_jyo_wire));
+	if (w == NULL)
+		return JY_EENOMEM;
 
-		return JY_EEINVAL;
+	ret = jyo_wire_encode_in(w, p);
+	if (ret != JY_ESUCCESS) {
+		jyo_wire_destroy(w);
+		return ret;
 	}
 
-	for (p_ll = p->properties; p_ll != NULL;
-	    p_ll = (struct st_jyo_property_ll *)p_ll->ll.next) {
-#ifdef JY_DEBUG_VERBOSE
-		printf("DEBUG: configurando propriedade \"%s\" do objeto de classe \"%s\".\n", p_ll->st.method_name, p->clazz);
-		fflush(stdout);
-#endif
+	*buf = w->data;
+	*size = w->len;
+	free(w);
 
-		ret = jyo_fill_jobject_property(jenv, j, p, &p_ll->st);
-		if (ret != JY_ESUCCESS) {
-			(*jenv)->DeleteLocalRef(jenv, jcls);
-			return ret;
+	return JY_ESUCCESS;
+}
+
+/**
+ * Resolves the decoder class and method.
+ */
+static int
+jyo_wire_jinit(JNIEnv *jenv)
+{
+	jclass jcls;
+	int ret;
+
+	(void)pthread_mutex_lock(&g_jyo_wire_jinit_mutex);
+
+	if (g_jyo_wire_mid != NULL) {
+		(void)pthread_mutex_unlock(&g_jyo_wire_jinit_mutex);
+		return JY_ESUCCESS;
+	}
+
+	ret = JY_ESUCCESS;
+	jcls = (*jenv)->FindClass(jenv, JYO_WIRE_CLASS);
+	if (jcls == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		ret = JY_ENOJCLASS;
+	} else {
+		g_jyo_wire_mid = (*jenv)->GetStaticMethodID(jenv, jcls, "decode", JYO_WIRE_SIGNATURE);
+		if (g_jyo_wire_mid == NULL) {
+			(*jenv)->ExceptionClear(jenv);
+			ret = JY_ENOTFOUND;
+		} else {
+			g_jyo_wire_jcls = (*jenv)->NewGlobalRef(jenv, jcls);
+			if (g_jyo_wire_jcls == NULL) {
+				g_jyo_wire_mid = NULL;
+				ret = JY_EENOMEM;
+			}
 		}
+		(*jenv)->DeleteLocalRef(jenv, jcls);
 	}
 
-	(*jenv)->DeleteLocalRef(jenv, jcls);
+	(void)pthread_mutex_unlock(&g_jyo_wire_jinit_mutex);
 
-	return JY_ESUCCESS;
+	return ret;
 }
 
 /**
- * Converts an "st_jyo" struct into a "jobject".
+ * Converts an "st_jyo" struct into a "jobject" in a single call to Java.
  *
  * @return The "e_jy_err" error enumerator.
  */
 int
-jyo_p2j(JNIEnv *jenv, struct st_jyo *p, jobject *j)
+jyo_p2j_wire(JNIEnv *jenv, struct st_jyo *p, jobject *j)
 {
+	struct st_jyo_wire *w;
+	jobject jbuf;
 	int ret;
 
 	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
@@ -890,448 +3433,462 @@ jyo_p2j(JNIEnv *jenv, struct st_jyo *p, jobject *j)
 	if (jyo_error(p) != JY_ESUCCESS)
 		return JY_EEINVAL;
 
-	*j = jyo_new_jobject(jenv, p->clazz);
-	if (*j == NULL)
-		return JY_ENOJCLASS;
-
-	ret = jyo_fill_jobject(jenv, *j, p);
-	if (ret != JY_ESUCCESS) {
-		(*jenv)->DeleteLocalRef(jenv, *j);
-		*j = NULL;
+	ret = jyo_wire_jinit(jenv);
+	if (ret != JY_ESUCCESS)
 		return ret;
-	}
-
-	return JY_ESUCCESS;
-}
-
-static char *
-jyo_get_jclass_name(JNIEnv *jenv, jclass jcls, jobject strObj)
-{
-	jmethodID midGetClass;
-	jobject clsObj;
-	jclass jCls;
-	jmethodID midGetFields;
-	jstring _name;
-
-	const char *str;
-	char *ret;
 
-	JY_ASSERT_RETURN(jenv != NULL, NULL);
-	JY_ASSERT_RETURN(jcls != NULL, NULL);
-
-/*	strObj = (*jenv)->AllocObject(jenv, jcls);
-	JY_ASSERT_RETURN(strObj != NULL, NULL);*/
+	w = jyo_wire_get();
+	if (w == NULL)
+		return JY_EENOMEM;
 
-	midGetClass = (*jenv)->GetMethodID(jenv, jcls, "getClass", "()Ljava/lang/Class;");
-	JY_ASSERT_RETURN(midGetClass != NULL, NULL);
+	ret = jyo_wire_encode_in(w, p);
+	/* Objects holding blobs are converted one call at a time. */
+	if (ret == JY_EENOSYS)
+		return jyo_p2j(jenv, p, j);
+	if (ret != JY_ESUCCESS)
+		return ret;
 
-	clsObj = (*jenv)->CallObjectMethod(jenv, strObj, midGetClass);
-/*	(*jenv)->DeleteLocalRef(jenv, strObj);*/
-	JY_ASSERT_RETURN(clsObj != NULL, NULL);
+	jbuf = (*jenv)->NewDirectByteBuffer(jenv, w->data, (jlong)w->len);
+	if (jbuf == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		return JY_EENOMEM;
+	}
 
-	jCls = (*jenv)->GetObjectClass(jenv, clsObj);
-	JY_ASSERT_RETURN(jCls != NULL, NULL);
+	/* The buffer is only read during the call: it is reused afterwards. */
+	*j = (*jenv)->CallStaticObjectMethod(jenv, g_jyo_wire_jcls, g_jyo_wire_mid, jbuf);
+	(*jenv)->DeleteLocalRef(jenv, jbuf);
 
-	midGetFields = (*jenv)->GetMethodID(jenv, jCls, "getName", "()Ljava/lang/String;");
-	(*jenv)->DeleteLocalRef(jenv, jCls);
-	JY_ASSERT_RETURN(midGetFields != NULL, NULL);
+	if (w->size > JYO_WIRE_KEEP_SIZE) {
+		free(w->data);
+		w->data = NULL;
+		w->size = 0;
+	}
 
-	_name = (jstring)(*jenv)->CallObjectMethod(jenv, clsObj, midGetFields);
-	(*jenv)->DeleteLocalRef(jenv, clsObj);
-	JY_ASSERT_RETURN(_name != NULL, NULL);
+	if ((*jenv)->ExceptionCheck(jenv)) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+		*j = NULL;
+		return JY_EEXCEPTION;
+	}
 
-	str = (*jenv)->GetStringUTFChars(jenv, _name, 0);
-	JY_ASSERT_RETURN(str != NULL, NULL);
+	return *j != NULL ? JY_ESUCCESS : JY_EINTERNAL;
+}
 
-	ret = strdup(str);
+/** Deepest nesting of objects a message may have. */
+#define JYO_WIRE_MAX_DEPTH 256
 
-	(*jenv)->ReleaseStringUTFChars(jenv, _name, str);
+/** Initial number of names of a message being decoded. */
+#define JYO_WIRE_MIN_NAMES 16
 
-	(*jenv)->DeleteLocalRef(jenv, _name);
+/**
+ * A message being decoded and the names it defined.
+ */
+struct st_jyo_wire_reader {
+	const unsigned char *p;
+	const unsigned char *end;
+	/** The size of the whole message, for the arena size. */
+	size_t size;
+	/** The names defined so far, by number. */
+	const struct st_jys **names;
+	unsigned int nnames;
+	unsigned int maxnames;
+	/** Buffer of the '\0' terminated names and strings. */
+	char *scratch;
+	size_t scratch_size;
+	/** The nesting level of the object being decoded. */
+	unsigned int depth;
+	/** The first error, which stops the decoding. */
+	int error;
+};
 
-	return ret;
+static void
+jyo_wire_fail(struct st_jyo_wire_reader *r, int error)
+{
+	if (r->error == JY_ESUCCESS)
+		r->error = error;
 }
 
-static const char *
-jyo_method_str_get_param(const char *str)
+/**
+ * Reads "n" bytes, or returns NULL if the message is shorter.
+ */
+static const unsigned char *
+jyo_wire_get_bytes(struct st_jyo_wire_reader *r, size_t n)
 {
-	const char *p;
+	const unsigned char *s;
 
-	JY_ASSERT_RETURN(str != NULL, NULL);
+	if ((r->error != JY_ESUCCESS) || (n > (size_t)(r->end - r->p))) {
+		jyo_wire_fail(r, JY_EEINVAL);
+		return NULL;
+	}
 
-	p = strchr(str, (int) '(');
-	JY_ASSERT_RETURN(p != NULL, NULL);
-	JY_ASSERT_RETURN(p != str, NULL);
-	p++;
+	s = r->p;
+	r->p += n;
 
-	return p;
+	return s;
 }
 
-static const char *
-jyo_method_str_get_name(const char *str)
+static unsigned char
+jyo_wire_get_byte(struct st_jyo_wire_reader *r)
 {
-	const char *pparam, *pname, *p;
-
-	JY_ASSERT_RETURN(str != NULL, NULL);
+	const unsigned char *s;
 
-	pparam = jyo_method_str_get_param(str);
-	JY_ASSERT_RETURN(pparam != NULL, NULL);
+	s = jyo_wire_get_bytes(r, 1);
 
-	pname = str;
-	for (;;) {
-		p = strchr(pname, (int) ' ');
-		if ((p == NULL) || (++p >= pparam))
-			return pname;
-		pname = p;
-	}
-
-	return pname;
+	return s != NULL ? *s : 0;
 }
 
-static const char *
-jyo_method_str_get_type(const char *str)
+static uint64_t
+jyo_wire_get_varint(struct st_jyo_wire_reader *r)
 {
-	JY_ASSERT_RETURN(str != NULL, NULL);
+	uint64_t v;
+	unsigned int shift;
+	unsigned char b;
+
+	v = 0;
+	for (shift = 0; shift < 64; shift += 7) {
+		b = jyo_wire_get_byte(r);
+		v |= (uint64_t)(b & 0x7f) << shift;
+		if ((b & 0x80) == 0)
+			return v;
+	}
 
-	if (strlen(str) > 7)
-		if (strncmp(str, "public ", 7) == 0)
-			return str + 7;
-	return NULL;
+	jyo_wire_fail(r, JY_EEINVAL);
+
+	return 0;
 }
 
-static int
-jyo_str_get_type(const char *str)
+static int64_t
+jyo_wire_get_zigzag(struct st_jyo_wire_reader *r)
 {
-	int len;
+	uint64_t v;
 
-	JY_ASSERT_RETURN(str != NULL, JY_EEINVAL);
+	v = jyo_wire_get_varint(r);
 
-	if (strchr(str, ' ') != NULL)
-		len = (int) (strchr(str, ' ') - str);
-	else
-		len = strlen(str);
-
-#define JY_STRING_TYPE_BOOLEAN "boolean"
-#define JY_STRING_TYPE_BOOLEAN_LENGTH 7
-#define JY_STRING_TYPE_BYTE "byte"
-#define JY_STRING_TYPE_BYTE_LENGTH 4
-#define JY_STRING_TYPE_CHAR "char"
-#define JY_STRING_TYPE_CHAR_LENGTH 4
-#define JY_STRING_TYPE_SHORT "short"
-#define JY_STRING_TYPE_SHORT_LENGTH 5
-#define JY_STRING_TYPE_INT "int"
-#define JY_STRING_TYPE_INT_LENGTH 3
-#define JY_STRING_TYPE_LONG "long"
-#define JY_STRING_TYPE_LONG_LENGTH 4
-#define JY_STRING_TYPE_FLOAT "float"
-#define JY_STRING_TYPE_FLOAT_LENGTH 5
-#define JY_STRING_TYPE_DOUBLE "double"
-#define JY_STRING_TYPE_DOUBLE_LENGTH 6
-#define JY_STRING_TYPE_VOID "void"
-#define JY_STRING_TYPE_VOID_LENGTH 4
-#define JY_STRING_TYPE_STRING "java.lang.String"
-#define JY_STRING_TYPE_STRING_LENGTH 16
-
-#define ISTYPE(x) (strncmp(str, JY_STRING_TYPE_##x, len < JY_STRING_TYPE_##x##_LENGTH ? len : JY_STRING_TYPE_##x##_LENGTH) == 0)
-
-	if (ISTYPE(BOOLEAN))
-		return JYO_TBOOLEAN;
-	else if (ISTYPE(BYTE))
-		return JYO_TBYTE;
-	else if (ISTYPE(CHAR))
-		return JYO_TCHAR;
-	else if (ISTYPE(SHORT))
-		return JYO_TSHORT;
-	else if (ISTYPE(INT))
-		return JYO_TINT;
-	else if (ISTYPE(LONG))
-		return JYO_TLONG;
-	else if (ISTYPE(FLOAT))
-		return JYO_TFLOAT;
-	else if (ISTYPE(DOUBLE))
-		return JYO_TDOUBLE;
-	else if (ISTYPE(VOID))
-		return JYO_TVOID;
-	else if (ISTYPE(STRING))
-		return JYO_TSTRING;
-
-	return JY_EEINVAL;
+	return (int64_t)((v >> 1) ^ -(v & 1));
 }
 
-static const char *
-jyo_java_basename(const char *str)
+/**
+ * Reads "n" little endian elements of "size" bytes into "data".
+ */
+static void
+jyo_wire_get_le(struct st_jyo_wire_reader *r, void *data, size_t n, size_t size)
 {
-	const char *pend, *p0, *p1, *p2;
-
-	if (strchr(str, '.') == NULL)
-		return str;
+	const unsigned char *s;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	unsigned char *d;
+	size_t i, k;
+#endif
 
-	p0 = strchr(str, '(');
-	p1 = strchr(str, ',');
-	p2 = strchr(str, ' ');
+	s = jyo_wire_get_bytes(r, n * size);
+	if (s == NULL)
+		return;
 
-	pend = p0;
-	if (p1 > pend)
-		pend = p1;
-	if (p2 > pend)
-		pend = p2;
-	if (pend == NULL)
-		pend = str + strlen(str);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	for (d = data, i = 0; i < n; i++, d += size, s += size) {
+		for (k = 0; k < size; k++)
+			d[k] = s[size - 1 - k];
+	}
+#else
+	memcpy(data, s, n * size);
+#endif
+}
 
-	p0 = str;
-	for (;;) {
-		p1 = strchr(p0, (int) '.');
-		if ((p1 == NULL) || (++p1 >= pend))
-			return p0;
-		p0 = p1;
+/**
+ * Gets a scratch buffer of at least "n" bytes.
+ */
+static char *
+jyo_wire_scratch(struct st_jyo_wire_reader *r, size_t n)
+{
+	char *scratch;
+	size_t size;
+
+	if (n <= r->scratch_size)
+		return r->scratch;
+
+	size = r->scratch_size != 0 ? r->scratch_size : JYO_WIRE_MIN_SIZE;
+	while (size < n)
+		size *= 2;
+	scratch = realloc(r->scratch, size);
+	if (scratch == NULL) {
+		jyo_wire_fail(r, JY_EENOMEM);
+		return NULL;
 	}
+	r->scratch = scratch;
+	r->scratch_size = size;
 
-	return p0;
+	return scratch;
 }
 
-static void
-jyo_java_convert_str(char *str, char o, char d)
+/**
+ * Reads a varint length plus 1 and that many bytes as a '\0' terminated
+ * string in the scratch buffer, or returns NULL for a null string.
+ */
+static const char *
+jyo_wire_get_string(struct st_jyo_wire_reader *r, uint64_t n)
 {
-	char *p;
+	const unsigned char *s;
+	char *str;
+
+	if ((n == 0) || (n - 1 > (uint64_t)(r->end - r->p))) {
+		jyo_wire_fail(r, JY_EEINVAL);
+		return NULL;
+	}
 
-	JY_ASSERT_RETURN_VOID(str != NULL);
+	s = jyo_wire_get_bytes(r, n - 1);
+	str = jyo_wire_scratch(r, n);
+	if ((s == NULL) || (str == NULL))
+		return NULL;
+	memcpy(str, s, n - 1);
+	str[n - 1] = '\000';
 
-	for (p = strchr(str, (int)o); p != NULL; p = strchr(p, (int)o))
-		*p = d;
+	return str;
 }
 
-static struct st_method_ll *
-jyo_method_str_to_m(const char *str)
+/**
+ * Reads a name reference, interning the names defined by the message.
+ */
+static const struct st_jys *
+jyo_wire_get_name(struct st_jyo_wire_reader *r)
 {
-	const char *pparam, *pname, *ptype;
-	char *temp;
-	struct st_method_ll *m;
+	const struct st_jys **names, *sym;
+	const char *name;
+	uint64_t i;
 
-	JY_ASSERT_RETURN(str != NULL, NULL);
-
-	pparam = jyo_method_str_get_param(str);
-	JY_ASSERT_RETURN(pparam != NULL, NULL);
-
-	if (pparam[0] != ')') {
-		JY_WARN_ENOSYS();
+	i = jyo_wire_get_varint(r);
+	if (r->error != JY_ESUCCESS)
 		return NULL;
+	if (i > 0) {
+		if (i > r->nnames) {
+			jyo_wire_fail(r, JY_EEINVAL);
+			return NULL;
+		}
+		return r->names[i - 1];
 	}
 
-	m = malloc(sizeof(struct st_method_ll));
-	JY_ASSERT_RETURN(m != NULL, NULL);
-	memset(m, 0, sizeof(struct st_method_ll));
-
-	pname = jyo_method_str_get_name(str);
-	JY_ASSERT_RETURN(pname != NULL, NULL);
-
-	pname = jyo_java_basename(pname);
+	name = jyo_wire_get_string(r, jyo_wire_get_varint(r) + 1);
+	if (name == NULL)
+		return NULL;
+	sym = jys_intern(name);
+	if (sym == NULL) {
+		jyo_wire_fail(r, JY_EENOMEM);
+		return NULL;
+	}
 
-	ptype = jyo_method_str_get_type(str);
-	JY_ASSERT_RETURN(ptype != NULL, NULL);
+	if (r->nnames == r->maxnames) {
+		names = realloc(r->names, (r->maxnames != 0 ? r->maxnames * 2 :
+		    JYO_WIRE_MIN_NAMES) * sizeof(struct st_jys *));
+		if (names == NULL) {
+			jyo_wire_fail(r, JY_EENOMEM);
+			return NULL;
+		}
+		r->names = names;
+		r->maxnames = r->maxnames != 0 ? r->maxnames * 2 : JYO_WIRE_MIN_NAMES;
+	}
+	r->names[r->nnames++] = sym;
 
-	m->sign = malloc(strlen(str) + 1); /* FIXME */
-	JY_ASSERT_RETURN(m->sign != NULL, NULL);
-	*m->sign = '\000';
+	return sym;
+}
 
-	strcat(m->sign, "(");
-	strcat(m->sign, ")");
+static void jyo_wire_get_object(struct st_jyo_wire_reader *r, struct st_jyo *parent, struct st_jyo *p);
 
-#define CATTYPE(t, m, cat) case JYO_T##t: strcat(m->sign, cat); m->rettype = JYO_T##t; break
-	switch (jyo_str_get_type(ptype)) {
-		CATTYPE(BOOLEAN, m, "Z");
-		CATTYPE(BYTE, m, "B");
-		CATTYPE(CHAR, m, "C");
-		CATTYPE(SHORT, m, "S");
-		CATTYPE(INT, m, "I");
-		CATTYPE(LONG, m, "J");
-		CATTYPE(FLOAT, m, "F");
-		CATTYPE(DOUBLE, m, "D");
-		/* CATTYPE(VOID, m, "V"); */
-		CATTYPE(STRING, m, "Ljava/lang/String;");
+/**
+ * Reads a property and sets it in "p".
+ */
+static void
+jyo_wire_get_property(struct st_jyo_wire_reader *r, struct st_jyo *p)
+{
+	const struct st_jys *sym;
+	struct st_jyo_array a;
+	struct st_jyo child;
+	enum e_jyo_type type;
+	const void *data;
+	size_t esize;
+	uint64_t n;
+	int ret;
+	union {
+		jy_bool b;
+		char c;
+		short s;
+		int i;
+		long l;
+		float f;
+		double d;
+	} v;
+
+	sym = jyo_wire_get_name(r);
+	type = jyo_wire_get_byte(r);
+	if (r->error != JY_ESUCCESS)
+		return;
 
+	data = &v;
+	switch (type) {
+		case JYO_TBOOLEAN:
+			v.b = jyo_wire_get_byte(r) != 0 ? JY_TRUE : JY_FALSE;
+			break;
+		case JYO_TBYTE:
+			v.c = (char)jyo_wire_get_byte(r);
+			break;
+		case JYO_TCHAR:
+			v.c = (char)jyo_wire_get_varint(r);
+			break;
+		case JYO_TSHORT:
+			v.s = (short)jyo_wire_get_zigzag(r);
+			break;
+		case JYO_TINT:
+			v.i = (int)jyo_wire_get_zigzag(r);
+			break;
+		case JYO_TLONG:
+			v.l = (long)jyo_wire_get_zigzag(r);
+			break;
+		case JYO_TFLOAT:
+			jyo_wire_get_le(r, &v.f, 1, sizeof(float));
+			break;
+		case JYO_TDOUBLE:
+			jyo_wire_get_le(r, &v.d, 1, sizeof(double));
+			break;
+		case JYO_TVOID:
+			data = NULL;
+			break;
+		case JYO_TSTRING:
+			n = jyo_wire_get_varint(r);
+			data = n != 0 ? jyo_wire_get_string(r, n) : NULL;
+			break;
+		case JYO_TJYO:
+			data = NULL;
+			if (jyo_wire_get_byte(r) != 0) {
+				jyo_wire_get_object(r, p, &child);
+				data = &child;
+			}
+			break;
+		case JYO_TBYTEARRAY:
+		case JYO_TSHORTARRAY:
+		case JYO_TINTARRAY:
+		case JYO_TLONGARRAY:
+		case JYO_TFLOATARRAY:
+		case JYO_TDOUBLEARRAY:
+			n = jyo_wire_get_varint(r);
+			if (n == 0) {
+				data = NULL;
+				break;
+			}
+			esize = jyo_get_array_elem_size(type);
+			if (n - 1 > (uint64_t)(r->end - r->p) / esize) {
+				jyo_wire_fail(r, JY_EEINVAL);
+				break;
+			}
+			a.length = (size_t)(n - 1);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+			a.data = jyo_wire_scratch(r, a.length * esize);
+			if (a.data != NULL)
+				jyo_wire_get_le(r, (void *)a.data, a.length, esize);
+#else
+			/* The elements are copied as they are, unaligned. */
+			a.data = jyo_wire_get_bytes(r, a.length * esize);
+#endif
+			data = &a;
+			break;
 		default:
-			strcat(m->sign, "L");
-			strncat(m->sign, ptype, strchr(ptype, ' ') - ptype);
-			strcat(m->sign, ";");
-			m->rettype = JYO_TJCLASS;
+			jyo_wire_fail(r, JY_EEINVAL);
 			break;
 	}
+	if (r->error != JY_ESUCCESS)
+		return;
 
-	/* FIXME */
-	temp = strdup(m->sign);
-	if (temp != NULL) {
-		free(m->sign);
-		m->sign = temp;
-	}
-
-	m->name = malloc(pparam - 1 - pname + 1); /* FIXME */
-	JY_ASSERT_RETURN(m->name != NULL, NULL);
-	*m->name = '\000';
-	strncat(m->name, pname, pparam - 1 - pname);
-
-	return m;
+	/* Children are moved into "p", even if it fails: they share its
+	 * arena. */
+	ret = jyo_set_property_sym(p, sym, type, data);
+	if (ret != JY_ESUCCESS)
+		jyo_wire_fail(r, ret);
 }
 
-static jy_bool
-jyo_method_str_is_from_java(const char *str)
+/**
+ * Reads an object into "p", a child of "parent" or the root of the message
+ * if "parent" is NULL. "p" is freed if it fails.
+ */
+static void
+jyo_wire_get_object(struct st_jyo_wire_reader *r, struct st_jyo *parent, struct st_jyo *p)
 {
-	const char *pname;
-
-	JY_ASSERT_RETURN(str != NULL, JY_FALSE);
-
-	pname = jyo_method_str_get_name(str);
-	JY_ASSERT_RETURN(pname != NULL, JY_FALSE);
+	const struct st_jys *clazz;
+	uint64_t i, n;
+	int ret;
 
-	if ((strncmp(pname, "java.", 5) == 0) || (strncmp(pname, "javax.", 6) == 0))
-		return JY_TRUE;
+	memset(p, 0, sizeof(struct st_jyo));
 
-	return JY_FALSE;
-}
+	clazz = jyo_wire_get_name(r);
+	if (r->error != JY_ESUCCESS)
+		return;
+	if (r->depth >= JYO_WIRE_MAX_DEPTH) {
+		jyo_wire_fail(r, JY_EEINVAL);
+		return;
+	}
 
-static jy_bool
-jyo_method_str_void_param(const char *str)
-{
-	const char *pparam;
+	if (parent == NULL)
+		ret = jyo_init_arena(p, (char *)clazz->name, r->size * 2);
+	else
+		ret = jyo_init_child(parent, p, (char *)clazz->name);
+	if (ret != JY_ESUCCESS) {
+		jyo_wire_fail(r, ret);
+		return;
+	}
 
-	JY_ASSERT_RETURN(str != NULL, JY_FALSE);
+	n = jyo_wire_get_varint(r);
 
-	pparam = jyo_method_str_get_param(str);
-	JY_ASSERT_RETURN(pparam != NULL, JY_FALSE);
+	r->depth++;
+	for (i = 0; (i < n) && (r->error == JY_ESUCCESS); i++)
+		jyo_wire_get_property(r, p);
+	r->depth--;
 
-	if (pparam[0] == ')')
-		return JY_TRUE;
-	return JY_FALSE;
+	if (r->error != JY_ESUCCESS)
+		jyo_free(p);
 }
 
-static jy_bool
-jyo_method_str_void_return(const char *str)
+/**
+ * Decodes a message of the wire format of jyo_wire_encode() into an "st_jyo"
+ * struct backed by an arena.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int
+jyo_wire_decode(const void *buf, size_t size, struct st_jyo *p)
 {
-	const char *ptype;
-
-	JY_ASSERT_RETURN(str != NULL, JY_FALSE);
-
-	ptype = jyo_method_str_get_type(str);
-	JY_ASSERT_RETURN(ptype != NULL, JY_FALSE);
-
-	if (strncmp(ptype, "void ", 5) == 0)
-		return JY_TRUE;
-	return JY_FALSE;
-}
-
-static int
-jyo_get_method_sign_list(JNIEnv *jenv, jclass cls, struct st_method_ll **mll)
-{
-	jobject strObj;
-	jmethodID midGetClass;
-	jobject clsObj;
-	jclass jCls;
-	jmethodID midGetFields;
-	jobjectArray jobjArray;
-	jsize len;
-	jsize i;
-
-	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(cls != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(mll != NULL, JY_EEINVAL);
-
-	*mll = NULL;
-
-#define LAME_ASSERT(x) do {						\
-	if (!(x)) {							\
-		fprintf(stderr, "%s:%d: LAME_ASSERT\n",			\
-		    __FILE__, __LINE__);				\
-		return JY_EEINVAL;				\
-	}								\
-} while (0)
-
-	LAME_ASSERT(cls != NULL);
-
-	strObj = (*jenv)->AllocObject(jenv, cls);
-	LAME_ASSERT(strObj != NULL);
-
-	midGetClass = (*jenv)->GetMethodID(jenv, cls, "getClass", "()Ljava/lang/Class;");
-	LAME_ASSERT(midGetClass != NULL);
-
-	clsObj = (*jenv)->CallObjectMethod(jenv, strObj, midGetClass);
-	LAME_ASSERT(clsObj != NULL);
-
-	(*jenv)->DeleteLocalRef(jenv, strObj);
-
-	jCls = (*jenv)->GetObjectClass(jenv, clsObj);
-	LAME_ASSERT(jCls != NULL);
-
-	midGetFields = (*jenv)->GetMethodID(jenv, jCls, "getMethods", "()[Ljava/lang/reflect/Method;");
-	LAME_ASSERT(midGetFields != NULL);
-
-	(*jenv)->DeleteLocalRef(jenv, jCls);
-
-	jobjArray = (jobjectArray)(*jenv)->CallObjectMethod(jenv, clsObj, midGetFields);
-	LAME_ASSERT(jobjArray != NULL);
-
-	(*jenv)->DeleteLocalRef(jenv, clsObj);
-
-	len = (*jenv)->GetArrayLength(jenv, jobjArray);
-
-	for (i = 0 ; i < len ; i++) {
-		jclass _methodClazz;
-		jmethodID mid;
-		jstring _name;
-		const char *str;
-		struct st_method_ll *m;
-
-		jobject _strMethod = (*jenv)->GetObjectArrayElement(jenv, jobjArray , i) ;
-		LAME_ASSERT(_strMethod != NULL);
-
-		_methodClazz = (*jenv)->GetObjectClass(jenv, _strMethod) ;
-		LAME_ASSERT(_methodClazz != NULL);
-
-		mid = (*jenv)->GetMethodID(jenv, _methodClazz , "toString" , "()Ljava/lang/String;") ;
-		LAME_ASSERT(mid != NULL);
+	struct st_jyo_wire_reader r;
 
-		(*jenv)->DeleteLocalRef(jenv, _methodClazz);
-
-		_name = (jstring)(*jenv)->CallObjectMethod(jenv, _strMethod , mid ) ;
-		LAME_ASSERT(_name != NULL);
-
-		(*jenv)->DeleteLocalRef(jenv, _strMethod);
-
-		str = (*jenv)->GetStringUTFChars(jenv, _name, 0);
-		LAME_ASSERT(str != NULL);
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	memset(p, 0, sizeof(struct st_jyo));
+	JY_ASSERT_RETURN(buf != NULL, JY_EEINVAL);
 
-		if (!jyo_method_str_is_from_java(str) &&
-		    !jyo_method_str_void_return(str) &&
-		    jyo_method_str_void_param(str)) {
-			m = jyo_method_str_to_m(str);
-			if (m != NULL) {
-				jyo_java_convert_str(m->sign, '.', '/');
-				m->jmid = (*jenv)->GetMethodID(jenv, cls, m->name, m->sign);
-				/* printf("%s: %s%s (%#010x) (%s)\n", __FUNCTION__, m->name, m->sign, (unsigned int)m->jmid, str); */
-				if ((m->jmid == NULL) || (*jenv)->ExceptionCheck(jenv)) {
-#ifdef JY_DEBUG_ERROR
-					fprintf(stderr, "Could not get method id at \"%s:%d\".\n", __FILE__, __LINE__);
-#endif
-					if ((*jenv)->ExceptionCheck(jenv)) {
-						(*jenv)->ExceptionDescribe(jenv);
-						(*jenv)->ExceptionClear(jenv);
-					}
-					fflush(stderr);
+	memset(&r, 0, sizeof(struct st_jyo_wire_reader));
+	r.p = buf;
+	r.end = r.p + size;
+	r.size = size;
+	r.error = JY_ESUCCESS;
 
-					return JY_EEINVAL;
-				}
+	jyo_wire_get_object(&r, NULL, p);
+	if ((r.error == JY_ESUCCESS) && (r.p != r.end)) {
+		r.error = JY_EEINVAL;
+		jyo_free(p);
+	}
 
-				llappend((void **)mll, (void *)m);
-			}
-		}
+	free(r.names);
+	free(r.scratch);
 
-		fflush(stdout);
-		(*jenv)->ReleaseStringUTFChars(jenv, _name, str);
+	if (r.error != JY_ESUCCESS)
+		memset(p, 0, sizeof(struct st_jyo));
 
-		(*jenv)->DeleteLocalRef(jenv, _name);
-	}
+	return r.error;
+}
 
-	(*jenv)->DeleteLocalRef(jenv, jobjArray);
+/**
+ * Stores a fetched property in its slot if "p" has a shape, or appends it.
+ */
+static int
+jyo_fetch_store(struct st_jyo *p, const struct st_method_ll *m, enum e_jyo_type data_type, const void *data)
+{
+	if (p->shape != NULL)
+		return jyo_put_property_sym(p, m->sym, data_type, data);
 
-	return JY_ESUCCESS;
+	return jyo_set_property_sym(p, m->sym, data_type, data);
 }
 
 static int
@@ -1346,7 +3903,10 @@ jyo_fetch_property_boolean(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
 
-	val = (jy_bool) (*jenv)->CallBooleanMethod(jenv, j, m->jmid);
+	if (m->jfid != NULL)
+		val = (jy_bool) (*jenv)->GetBooleanField(jenv, j, m->jfid);
+	else
+		val = (jy_bool) (*jenv)->CallBooleanMethod(jenv, j, m->jmid);
 	if ((*jenv)->ExceptionCheck(jenv)) {
 		(*jenv)->ExceptionDescribe(jenv);
 		(*jenv)->ExceptionClear(jenv);
@@ -1354,7 +3914,7 @@ jyo_fetch_property_boolean(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *
 		return JY_EEXCEPTION;
 	}
 
-	ret = jyo_set_property(p, m->name, m->rettype, (void *) &val);
+	ret = jyo_fetch_store(p, m, m->rettype, (void *) &val);
 	DEBUG_BOOL(val);
 
 	return ret;
@@ -1372,7 +3932,10 @@ jyo_fetch_property_byte(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
 
-	val = (char) (*jenv)->CallByteMethod(jenv, j, m->jmid);
+	if (m->jfid != NULL)
+		val = (char) (*jenv)->GetByteField(jenv, j, m->jfid);
+	else
+		val = (char) (*jenv)->CallByteMethod(jenv, j, m->jmid);
 	if ((*jenv)->ExceptionCheck(jenv)) {
 		(*jenv)->ExceptionDescribe(jenv);
 		(*jenv)->ExceptionClear(jenv);
@@ -1380,7 +3943,7 @@ jyo_fetch_property_byte(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 		return JY_EEXCEPTION;
 	}
 
-	ret = jyo_set_property(p, m->name, m->rettype, (void *) &val);
+	ret = jyo_fetch_store(p, m, m->rettype, (void *) &val);
 	DEBUG_BYTE(val);
 
 	return ret;
@@ -1398,7 +3961,10 @@ jyo_fetch_property_char(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
 
-	val = (char) (*jenv)->CallCharMethod(jenv, j, m->jmid);
+	if (m->jfid != NULL)
+		val = (char) (*jenv)->GetCharField(jenv, j, m->jfid);
+	else
+		val = (char) (*jenv)->CallCharMethod(jenv, j, m->jmid);
 	if ((*jenv)->ExceptionCheck(jenv)) {
 		(*jenv)->ExceptionDescribe(jenv);
 		(*jenv)->ExceptionClear(jenv);
@@ -1406,7 +3972,7 @@ jyo_fetch_property_char(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 		return JY_EEXCEPTION;
 	}
 
-	ret = jyo_set_property(p, m->name, m->rettype, (void *) &val);
+	ret = jyo_fetch_store(p, m, m->rettype, (void *) &val);
 	DEBUG_CHAR(val);
 
 	return ret;
@@ -1424,7 +3990,10 @@ jyo_fetch_property_short(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
 
-	val = (short) (*jenv)->CallShortMethod(jenv, j, m->jmid);
+	if (m->jfid != NULL)
+		val = (short) (*jenv)->GetShortField(jenv, j, m->jfid);
+	else
+		val = (short) (*jenv)->CallShortMethod(jenv, j, m->jmid);
 	if ((*jenv)->ExceptionCheck(jenv)) {
 		(*jenv)->ExceptionDescribe(jenv);
 		(*jenv)->ExceptionClear(jenv);
@@ -1432,7 +4001,7 @@ jyo_fetch_property_short(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 		return JY_EEXCEPTION;
 	}
 
-	ret = jyo_set_property(p, m->name, m->rettype, (void *) &val);
+	ret = jyo_fetch_store(p, m, m->rettype, (void *) &val);
 	DEBUG_SHORT(val);
 
 	return ret;
@@ -1450,7 +4019,10 @@ jyo_fetch_property_int(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, c
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
 
-	val = (int) (*jenv)->CallIntMethod(jenv, j, m->jmid);
+	if (m->jfid != NULL)
+		val = (int) (*jenv)->GetIntField(jenv, j, m->jfid);
+	else
+		val = (int) (*jenv)->CallIntMethod(jenv, j, m->jmid);
 	if ((*jenv)->ExceptionCheck(jenv)) {
 		(*jenv)->ExceptionDescribe(jenv);
 		(*jenv)->ExceptionClear(jenv);
@@ -1458,7 +4030,7 @@ jyo_fetch_property_int(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, c
 		return JY_EEXCEPTION;
 	}
 
-	ret = jyo_set_property(p, m->name, m->rettype, (void *) &val);
+	ret = jyo_fetch_store(p, m, m->rettype, (void *) &val);
 
 	DEBUG_STR(m->name);
 	DEBUG_INT(val);
@@ -1478,7 +4050,10 @@ jyo_fetch_property_long(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
 
-	val = (long) (*jenv)->CallLongMethod(jenv, j, m->jmid);
+	if (m->jfid != NULL)
+		val = (long) (*jenv)->GetLongField(jenv, j, m->jfid);
+	else
+		val = (long) (*jenv)->CallLongMethod(jenv, j, m->jmid);
 	if ((*jenv)->ExceptionCheck(jenv)) {
 		(*jenv)->ExceptionDescribe(jenv);
 		(*jenv)->ExceptionClear(jenv);
@@ -1486,7 +4061,7 @@ jyo_fetch_property_long(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 		return JY_EEXCEPTION;
 	}
 
-	ret = jyo_set_property(p, m->name, m->rettype, (void *) &val);
+	ret = jyo_fetch_store(p, m, m->rettype, (void *) &val);
 	DEBUG_LONG(val);
 
 	return ret;
@@ -1504,7 +4079,10 @@ jyo_fetch_property_float(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
 
-	val = (float) (*jenv)->CallFloatMethod(jenv, j, m->jmid);
+	if (m->jfid != NULL)
+		val = (float) (*jenv)->GetFloatField(jenv, j, m->jfid);
+	else
+		val = (float) (*jenv)->CallFloatMethod(jenv, j, m->jmid);
 	if ((*jenv)->ExceptionCheck(jenv)) {
 		(*jenv)->ExceptionDescribe(jenv);
 		(*jenv)->ExceptionClear(jenv);
@@ -1512,7 +4090,7 @@ jyo_fetch_property_float(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 		return JY_EEXCEPTION;
 	}
 
-	ret = jyo_set_property(p, m->name, m->rettype, (void *) &val);
+	ret = jyo_fetch_store(p, m, m->rettype, (void *) &val);
 	DEBUG_DOUBLE(val);
 
 	return ret;
@@ -1530,7 +4108,10 @@ jyo_fetch_property_double(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
 
-	val = (double) (*jenv)->CallDoubleMethod(jenv, j, m->jmid);
+	if (m->jfid != NULL)
+		val = (double) (*jenv)->GetDoubleField(jenv, j, m->jfid);
+	else
+		val = (double) (*jenv)->CallDoubleMethod(jenv, j, m->jmid);
 	if ((*jenv)->ExceptionCheck(jenv)) {
 		(*jenv)->ExceptionDescribe(jenv);
 		(*jenv)->ExceptionClear(jenv);
@@ -1538,71 +4119,374 @@ jyo_fetch_property_double(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p
 		return JY_EEXCEPTION;
 	}
 
-	ret = jyo_set_property(p, m->name, m->rettype, (void *) &val);
+	ret = jyo_fetch_store(p, m, m->rettype, (void *) &val);
 	DEBUG_DOUBLE(val);
 
 	return ret;
 }
 
+/**
+ * Stores the UTF-16 string "s" of "len" code units as the string property "m"
+ * of "p", converting it straight into the memory of the property.
+ */
+static int
+jyo_fetch_store_string(struct st_jyo *p, const struct st_method_ll *m, const jchar *s, size_t len)
+{
+	const struct st_jyo_slot *slot;
+	struct st_jyo_property_ll *p_ll;
+	char *str, **v;
+	size_t size;
+	int ret;
+
+	size = jyutf_16to8_len(s, len) + 1;
+	if (p->arena != NULL)
+		str = arena_alloc(p->arena, size);
+	else
+		str = malloc(size);
+	if (str == NULL) {
+		p->error = JY_EENOMEM;
+		return JY_EENOMEM;
+	}
+	(void)jyutf_16to8(s, len, str);
+	str[size - 1] = '\000';
+
+	/* The string of a slot or of a new property is not copied again. */
+	slot = p->shape != NULL ? jyo_shape_find(p->shape, m->sym) : NULL;
+	if ((slot != NULL) && (slot->data_type == JYO_TSTRING)) {
+		v = (char **)((char *)p->values + slot->offset);
+		if ((*v != NULL) && (p->arena == NULL))
+			free(*v);
+		*v = str;
+
+		return JY_ESUCCESS;
+	}
+
+	if (p->shape == NULL) {
+		ret = jyo_set_property_in(p, m->sym, JYO_TSTRING, NULL);
+		if (ret == JY_ESUCCESS) {
+			p_ll = (struct st_jyo_property_ll *)p->properties.last;
+			p_ll->st.value.ref.data = str;
+			p_ll->st.value.ref.size = size;
+			return JY_ESUCCESS;
+		}
+	} else
+		ret = jyo_fetch_store(p, m, JYO_TSTRING, str);
+
+	if (p->arena == NULL)
+		free(str);
+
+	return ret;
+}
+
+static int
+jyo_fetch_property_string(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const struct st_method_ll *m)
+{
+	jchar buf[JYO_STRING_REGION_MAX];
+	const jchar *s;
+	jstring jstr;
+	jsize len;
+	int ret;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(jcls != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
+
+	if (m->jfid != NULL)
+		jstr = (jstring)(*jenv)->GetObjectField(jenv, j, m->jfid);
+	else
+		jstr = (jstring)(*jenv)->CallObjectMethod(jenv, j, m->jmid);
+	if ((*jenv)->ExceptionCheck(jenv)) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+
+		if (jstr != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jstr);
+
+		return JY_EEXCEPTION;
+	}
+
+	DEBUG_STR(m->name);
+
+	if (jstr == NULL)
+		return jyo_fetch_store(p, m, m->rettype, NULL);
+
+	len = (*jenv)->GetStringLength(jenv, jstr);
+
+	if (len <= JYO_STRING_REGION_MAX) {
+		(*jenv)->GetStringRegion(jenv, jstr, 0, len, buf);
+		ret = jyo_fetch_store_string(p, m, buf, (size_t)len);
+	} else {
+		/* Long strings are converted straight from the pinned String.
+		 * Storing them makes no JNI call. */
+		s = (*jenv)->GetStringCritical(jenv, jstr, NULL);
+		if (s == NULL) {
+			(*jenv)->ExceptionClear(jenv);
+			(*jenv)->DeleteLocalRef(jenv, jstr);
+			return JY_EENOMEM;
+		}
+		ret = jyo_fetch_store_string(p, m, s, (size_t)len);
+		(*jenv)->ReleaseStringCritical(jenv, jstr, s);
+	}
+
+	(*jenv)->DeleteLocalRef(jenv, jstr);
+
+	return ret;
+}
+
+static int
+jyo_fetch_property_jyo(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const struct st_method_ll *m)
+{
+	int ret;
+	struct st_jyo pnew;
+	jobject jnew;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(jcls != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
+
+	if (m->jfid != NULL)
+		jnew = (*jenv)->GetObjectField(jenv, j, m->jfid);
+	else
+		jnew = (*jenv)->CallObjectMethod(jenv, j, m->jmid);
+	if ((*jenv)->ExceptionCheck(jenv)) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+
+		if (jnew != NULL);
+			(*jenv)->DeleteLocalRef(jenv, jnew);
+
+		return JY_EEXCEPTION;
+	}
+
+	if (jnew == NULL) {
+		DEBUG_STR("Deu JY = NULL");
+		ret = jyo_fetch_store(p, m, JYO_TJYO, NULL);
+		return ret;
+	}
+
+	/* The child shares the arena of "p", if it has one. */
+	ret = jyo_j2p_in(jenv, jnew, &pnew, p->arena);
+	(*jenv)->DeleteLocalRef(jenv, jnew);
+	if (ret == JY_ESUCCESS) {
+		/* The struct is copied: its contents now belong to "p",
+		 * which frees them with its own. */
+		ret = jyo_fetch_store(p, m, JYO_TJYO, (void *)&pnew);
+		if (ret != JY_ESUCCESS)
+			jyo_free(&pnew);
+	}
+
+	return ret;
+}
+
+static int
+jyo_fetch_property_array(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const struct st_method_ll *m)
+{
+	struct st_jyo_array a;
+	jlong buf[JYO_ARRAY_CRITICAL_MIN / sizeof(jlong)];
+	size_t size;
+	jarray ja;
+	void *elems;
+	int ret;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(jcls != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
+
+	if (m->jfid != NULL)
+		ja = (jarray)(*jenv)->GetObjectField(jenv, j, m->jfid);
+	else
+		ja = (jarray)(*jenv)->CallObjectMethod(jenv, j, m->jmid);
+	if ((*jenv)->ExceptionCheck(jenv)) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+
+		if (ja != NULL)
+			(*jenv)->DeleteLocalRef(jenv, ja);
+
+		return JY_EEXCEPTION;
+	}
+
+	if (ja == NULL)
+		return jyo_fetch_store(p, m, m->rettype, NULL);
+
+	a.length = (size_t)(*jenv)->GetArrayLength(jenv, ja);
+	size = a.length * jyo_get_array_elem_size(m->rettype);
+
+	if (size >= sizeof(buf)) {
+		/* Large arrays are copied straight from the pinned Java
+		 * array. Storing them makes no JNI call. */
+		elems = (*jenv)->GetPrimitiveArrayCritical(jenv, ja, NULL);
+		if (elems == NULL) {
+			(*jenv)->ExceptionClear(jenv);
+			(*jenv)->DeleteLocalRef(jenv, ja);
+			return JY_EENOMEM;
+		}
+		a.data = elems;
+		ret = jyo_fetch_store(p, m, m->rettype, &a);
+		(*jenv)->ReleasePrimitiveArrayCritical(jenv, ja, elems, JNI_ABORT);
+		(*jenv)->DeleteLocalRef(jenv, ja);
+
+		return ret;
+	}
+
+	switch (m->rettype) {
+		case JYO_TBYTEARRAY:
+			(*jenv)->GetByteArrayRegion(jenv, ja, 0, (jsize)a.length, (jbyte *)buf);
+			break;
+		case JYO_TSHORTARRAY:
+			(*jenv)->GetShortArrayRegion(jenv, ja, 0, (jsize)a.length, (jshort *)buf);
+			break;
+		case JYO_TINTARRAY:
+			(*jenv)->GetIntArrayRegion(jenv, ja, 0, (jsize)a.length, (jint *)buf);
+			break;
+		case JYO_TLONGARRAY:
+			(*jenv)->GetLongArrayRegion(jenv, ja, 0, (jsize)a.length, (jlong *)buf);
+			break;
+		case JYO_TFLOATARRAY:
+			(*jenv)->GetFloatArrayRegion(jenv, ja, 0, (jsize)a.length, (jfloat *)buf);
+			break;
+		case JYO_TDOUBLEARRAY:
+			(*jenv)->GetDoubleArrayRegion(jenv, ja, 0, (jsize)a.length, (jdouble *)buf);
+			break;
+		default:
+			(*jenv)->DeleteLocalRef(jenv, ja);
+			return JY_EEINVAL;
+	}
+	(*jenv)->DeleteLocalRef(jenv, ja);
+
+	a.data = buf;
+
+	return jyo_fetch_store(p, m, m->rettype, &a);
+}
+
+/** The ByteBuffer methods copying heap buffers, resolved once. */
+static jmethodID g_jyo_mid_duplicate = NULL;
+static jmethodID g_jyo_mid_clear = NULL;
+static jmethodID g_jyo_mid_get = NULL;
+static jmethodID g_jyo_mid_capacity = NULL;
+static pthread_mutex_t g_jyo_bytebuffer_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Resolves the ByteBuffer methods used by jyo_blob_copy_heap().
+ */
+static int
+jyo_bytebuffer_jinit(JNIEnv *jenv)
+{
+	jclass jcls;
+	int ret;
+
+	(void)pthread_mutex_lock(&g_jyo_bytebuffer_mutex);
+
+	if (g_jyo_mid_capacity != NULL) {
+		(void)pthread_mutex_unlock(&g_jyo_bytebuffer_mutex);
+		return JY_ESUCCESS;
+	}
+
+	jcls = (*jenv)->FindClass(jenv, "java/nio/ByteBuffer");
+	if (jcls == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		(void)pthread_mutex_unlock(&g_jyo_bytebuffer_mutex);
+		return JY_ENOJCLASS;
+	}
+
+	/* Method IDs stay valid while the class is loaded, which a system
+	 * class always is. */
+	ret = JY_ESUCCESS;
+	g_jyo_mid_duplicate = (*jenv)->GetMethodID(jenv, jcls, "duplicate", "()Ljava/nio/ByteBuffer;");
+	g_jyo_mid_clear = (*jenv)->GetMethodID(jenv, jcls, "clear", "()Ljava/nio/Buffer;");
+	g_jyo_mid_get = (*jenv)->GetMethodID(jenv, jcls, "get", "([B)Ljava/nio/ByteBuffer;");
+	if ((g_jyo_mid_duplicate != NULL) && (g_jyo_mid_clear != NULL) &&
+	    (g_jyo_mid_get != NULL))
+		g_jyo_mid_capacity = (*jenv)->GetMethodID(jenv, jcls, "capacity", "()I");
+	if (g_jyo_mid_capacity == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		ret = JY_ENOTFOUND;
+	}
+	(*jenv)->DeleteLocalRef(jenv, jcls);
+
+	(void)pthread_mutex_unlock(&g_jyo_bytebuffer_mutex);
+
+	return ret;
+}
+
+/**
+ * Copies the whole content of a heap ByteBuffer, whose memory can't be
+ * borrowed, into a blob owning the copy. The position and limit of "jbuf"
+ * are left untouched.
+ */
 static int
-jyo_fetch_property_string(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const struct st_method_ll *m)
+jyo_blob_copy_heap(JNIEnv *jenv, jobject jbuf, struct st_jyo_blob *blob)
 {
+	jobject jdup, jret;
+	jbyteArray ja;
+	jint cap;
 	int ret;
-	jstring jstr;
-	const char *str;
 
-	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(jcls != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
+	ret = jyo_bytebuffer_jinit(jenv);
+	if (ret != JY_ESUCCESS)
+		return ret;
 
-	jstr = (jstring)(*jenv)->CallObjectMethod(jenv, j, m->jmid);
-	if ((*jenv)->ExceptionCheck(jenv)) {
-		(*jenv)->ExceptionDescribe(jenv);
+	cap = (*jenv)->CallIntMethod(jenv, jbuf, g_jyo_mid_capacity);
+	if ((*jenv)->ExceptionCheck(jenv) || (cap < 0)) {
 		(*jenv)->ExceptionClear(jenv);
-		fflush(stderr);
-
-		if (jstr != NULL)
-			(*jenv)->DeleteLocalRef(jenv, jstr);
-
 		return JY_EEXCEPTION;
 	}
 
-	DEBUG_STR(m->name);
-
-	if (jstr == NULL) {
-		DEBUG_STR("Deu STR = NULL");
-		str = NULL;
-	} else {
-		str = (*jenv)->GetStringUTFChars(jenv, jstr, 0);
-		if (str == NULL) {
-			(*jenv)->DeleteLocalRef(jenv, jstr);
-			JY_ASSERT_RETURN(str != NULL, JY_EEINVAL);
-		}
+	ja = (*jenv)->NewByteArray(jenv, cap);
+	if (ja == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		return JY_EENOMEM;
 	}
 
-	ret = jyo_set_property(p, m->name, m->rettype, (void *)str);
-	DEBUG_STR(str);
+	/* A duplicate reads from its start to its capacity once cleared. */
+	jdup = (*jenv)->CallObjectMethod(jenv, jbuf, g_jyo_mid_duplicate);
+	if (jdup != NULL) {
+		jret = (*jenv)->CallObjectMethod(jenv, jdup, g_jyo_mid_clear);
+		if (jret != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jret);
+		jret = (*jenv)->CallObjectMethod(jenv, jdup, g_jyo_mid_get, ja);
+		if (jret != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jret);
+		(*jenv)->DeleteLocalRef(jenv, jdup);
+	}
+	if ((jdup == NULL) || (*jenv)->ExceptionCheck(jenv)) {
+		(*jenv)->ExceptionDescribe(jenv);
+		(*jenv)->ExceptionClear(jenv);
+		fflush(stderr);
+		(*jenv)->DeleteLocalRef(jenv, ja);
+		return JY_EEXCEPTION;
+	}
 
-	if (jstr != NULL) {
-		(*jenv)->ReleaseStringUTFChars(jenv, jstr, str);
-		/*free(str);*/
+	blob->data = malloc(cap > 0 ? (size_t)cap : 1);
+	if (blob->data == NULL) {
+		(*jenv)->DeleteLocalRef(jenv, ja);
+		return JY_EENOMEM;
 	}
+	(*jenv)->GetByteArrayRegion(jenv, ja, 0, cap, blob->data);
+	(*jenv)->DeleteLocalRef(jenv, ja);
 
-	/* We MUST call DeleteLocalRef() with a NULL pointer or else a JNI LEAK
-	 * WILL occur. */
-	(*jenv)->DeleteLocalRef(jenv, jstr);
+	blob->size = (size_t)cap;
+	blob->release = jyo_heap_release;
+	blob->arg = NULL;
 
-	return ret;
+	return JY_ESUCCESS;
 }
 
 static int
-jyo_fetch_property_jyo(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const struct st_method_ll *m)
+jyo_fetch_property_blob(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const struct st_method_ll *m)
 {
+	struct st_jyo_blob blob;
+	jobject jbuf;
 	int ret;
-	struct st_jyo *pnew;
-		jobject jnew;
 
 	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(jcls != NULL, JY_EEINVAL);
@@ -1610,40 +4494,50 @@ jyo_fetch_property_jyo(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, c
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(m != NULL, JY_EEINVAL);
 
-	jnew = (*jenv)->CallObjectMethod(jenv, j, m->jmid);
+	if (m->jfid != NULL)
+		jbuf = (*jenv)->GetObjectField(jenv, j, m->jfid);
+	else
+		jbuf = (*jenv)->CallObjectMethod(jenv, j, m->jmid);
 	if ((*jenv)->ExceptionCheck(jenv)) {
 		(*jenv)->ExceptionDescribe(jenv);
 		(*jenv)->ExceptionClear(jenv);
 		fflush(stderr);
 
-		if (jnew != NULL);
-			(*jenv)->DeleteLocalRef(jenv, jnew);
+		if (jbuf != NULL)
+			(*jenv)->DeleteLocalRef(jenv, jbuf);
 
 		return JY_EEXCEPTION;
 	}
 
-	if (jnew == NULL) {
-		DEBUG_STR("Deu JY = NULL");
-		pnew = NULL;
-		ret = jyo_set_property(p, m->name, JYO_TJYO, (void *)pnew);
-		return ret;
+	if (jbuf == NULL)
+		return jyo_fetch_store(p, m, JYO_TBLOB, NULL);
+
+	/* Only the memory of direct buffers can be borrowed: heap buffers
+	 * are copied. */
+	blob.data = (*jenv)->GetDirectBufferAddress(jenv, jbuf);
+	if (blob.data == NULL) {
+		ret = jyo_blob_copy_heap(jenv, jbuf, &blob);
+		(*jenv)->DeleteLocalRef(jenv, jbuf);
+		if (ret != JY_ESUCCESS)
+			return ret;
+		return jyo_fetch_store(p, m, JYO_TBLOB, &blob);
 	}
+	blob.size = (size_t)(*jenv)->GetDirectBufferCapacity(jenv, jbuf);
 
-	pnew = malloc(sizeof(struct st_jyo));
-	if (pnew == NULL) {
-		(*jenv)->DeleteLocalRef(jenv, jnew);
-		JY_ASSERT_RETURN(pnew != NULL, JY_EENOMEM);
+	if ((g_jyo_jvm == NULL) &&
+	    ((*jenv)->GetJavaVM(jenv, &g_jyo_jvm) != JNI_OK)) {
+		(*jenv)->DeleteLocalRef(jenv, jbuf);
+		return JY_EEINVAL;
 	}
 
-	ret = jyo_j2p(jenv, jnew, pnew);
-	(*jenv)->DeleteLocalRef(jenv, jnew);
-	if (ret == JY_ESUCCESS)
-		ret = jyo_set_property(p, m->name, JYO_TJYO, (void *)pnew);
-	else
-		jyo_free(pnew);
-	free(pnew); /* This pointer has already been used. Free it. */
+	/* The buffer is kept alive while the blob holds its memory. */
+	blob.release = jyo_jbuf_release;
+	blob.arg = (*jenv)->NewGlobalRef(jenv, jbuf);
+	(*jenv)->DeleteLocalRef(jenv, jbuf);
+	if (blob.arg == NULL)
+		return JY_EENOMEM;
 
-	return ret;
+	return jyo_fetch_store(p, m, JYO_TBLOB, &blob);
 }
 
 static int
@@ -1686,6 +4580,17 @@ jyo_fetch_property(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const
 		case JYO_TJCLASS:
 			return jyo_fetch_property_jyo(jenv, jcls, j, p, m);
 			break;
+		case JYO_TBYTEARRAY:
+		case JYO_TSHORTARRAY:
+		case JYO_TINTARRAY:
+		case JYO_TLONGARRAY:
+		case JYO_TFLOATARRAY:
+		case JYO_TDOUBLEARRAY:
+			return jyo_fetch_property_array(jenv, jcls, j, p, m);
+			break;
+		case JYO_TBLOB:
+			return jyo_fetch_property_blob(jenv, jcls, j, p, m);
+			break;
 		default:
 			break;
 	}
@@ -1695,20 +4600,22 @@ jyo_fetch_property(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const
 }
 
 /**
- * Fill up the "p" struct, using "j" as source based on the "mll" list.
+ * Fill up the "p" struct, using "j" as source based on the "getters" list.
  */
 static int
-jyo_fetch_property_list(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const struct st_method_ll *mll)
+jyo_fetch_property_list(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p, const struct st_llhead *getters)
 {
+	const struct st_method_ll *mll;
 	int ret;
 
 	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(jcls != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
-	JY_ASSERT_RETURN(mll != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(getters != NULL, JY_EEINVAL);
 
-	for (; mll != NULL; mll = (struct st_method_ll *)mll->ll.next) {
+	for (mll = (const struct st_method_ll *)getters->first; mll != NULL;
+	    mll = (const struct st_method_ll *)mll->ll.next) {
 		ret = jyo_fetch_property(jenv, jcls, j, p, mll);
 		if (ret != JY_ESUCCESS) {
 			return ret;
@@ -1719,18 +4626,15 @@ jyo_fetch_property_list(JNIEnv *jenv, jclass jcls, jobject j, struct st_jyo *p,
 }
 
 /**
- * Converts a "jobject" into an "st_jyo" struct.
- *
- * @return The "e_jy_err" error enumerator.
+ * Converts a "jobject" into an "st_jyo" struct, making local references in
+ * the current frame.
  */
-int
-jyo_j2p(JNIEnv *jenv, jobject j, struct st_jyo *p)
+static int
+jyo_j2p_level(JNIEnv *jenv, jobject j, struct st_jyo *p, struct st_arena *arena)
 {
 	jclass jcls;
-	char *str;
 	int ret;
-	struct st_method_ll *mll;
-
+	struct st_jyc *c;
 
 	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(j != NULL, JY_EEINVAL);
@@ -1756,74 +4660,64 @@ jyo_j2p(JNIEnv *jenv, jobject j, struct st_jyo *p)
 		return JY_EEINVAL;
 	}
 
-	/* Extract the Java class signature. */
-	str = jyo_get_jclass_name(jenv, jcls, j);
-	if (str == NULL) {
+	/* Get the class descriptor: its name and getter methods. */
+	ret = jyc_get(jenv, jcls, &c);
+	if (ret != JY_ESUCCESS) {
 #ifdef JY_DEBUG_ERROR
-		fprintf(stderr, "Could not get class name at \"%s:%d\".\n", __FILE__, __LINE__);
-#endif
-		if ((*jenv)->ExceptionCheck(jenv)) {
-			(*jenv)->ExceptionDescribe(jenv);
-			(*jenv)->ExceptionClear(jenv);
-		}
+		fprintf(stderr, "Error %s while getting class descriptor at \"%s:%d\".\n", jy_strerror(ret), __FILE__, __LINE__);
 		fflush(stderr);
-
+#endif
 		(*jenv)->DeleteLocalRef(jenv, jcls);
 
-		return JY_EEINVAL;
+		return ret;
 	}
 
 	/* Initialize the struct with the class signature. */
-	ret = jyo_init(p, str);
-	free(str);
-
+	ret = jyo_init_in(p, c->name, arena);
 	if (ret != JY_ESUCCESS) {
 #ifdef JY_DEBUG_ERROR
 		fprintf(stderr, "Error %s while initializing jyo structure at \"%s:%d\".\n", jy_strerror(ret), __FILE__, __LINE__);
-#endif
-		if ((*jenv)->ExceptionCheck(jenv)) {
-			(*jenv)->ExceptionDescribe(jenv);
-			(*jenv)->ExceptionClear(jenv);
-		}
 		fflush(stderr);
-
+#endif
 		(*jenv)->DeleteLocalRef(jenv, jcls);
+		jyc_release(jenv, c);
 
 		jyo_free(p);
 		return ret;
 	}
 
-	/* Fills "mll" with the methods without parameters that doesn't return
-	 * void from the "jcls" class. */
-	ret = jyo_get_method_sign_list(jenv, jcls, &mll);
-	if ((ret != JY_ESUCCESS) || (mll == NULL)) {
+	if (c->getters.first == NULL) {
 #ifdef JY_DEBUG_ERROR
-		if (mll == NULL)
-			fprintf(stderr, "Found no methods from jobject at \"%s:%d\".\n", __FILE__, __LINE__);
-		else
-			fprintf(stderr, "Error %s while getting method list from jobject at \"%s:%d\".\n", jy_strerror(ret), __FILE__, __LINE__);
-#endif
-		if ((*jenv)->ExceptionCheck(jenv)) {
-			(*jenv)->ExceptionDescribe(jenv);
-			(*jenv)->ExceptionClear(jenv);
-		}
+		fprintf(stderr, "Found no methods from jobject at \"%s:%d\".\n", __FILE__, __LINE__);
 		fflush(stderr);
-
+#endif
 		(*jenv)->DeleteLocalRef(jenv, jcls);
+		jyc_release(jenv, c);
 		jyo_free(p);
-		jyo_free_method_ll(&mll);
 
-		return ret;
+		return JY_ESUCCESS;
+	}
+
+	/* The properties are stored in the slots of the class shape. */
+	if (c->shape != NULL) {
+		ret = jyo_shape_apply(p, c->shape);
+		if (ret != JY_ESUCCESS) {
+			(*jenv)->DeleteLocalRef(jenv, jcls);
+			jyc_release(jenv, c);
+			jyo_free(p);
+
+			return ret;
+		}
 	}
 
-	/* Fill up the "p" struct, using "j" as source based on the "mll" list. */
-	ret = jyo_fetch_property_list(jenv, jcls, j, p, mll);
-/*	jyo_free_method_ll(&mll);*/
+	/* Fill up the "p" struct, using "j" as source based on the getters. */
+	ret = jyo_fetch_property_list(jenv, jcls, j, p, &c->getters);
 	(*jenv)->DeleteLocalRef(jenv, jcls);
+	jyc_release(jenv, c);
 
-	if ((ret != JY_ESUCCESS) || (mll == NULL)) {
+	if (ret != JY_ESUCCESS) {
 #ifdef JY_DEBUG_ERROR
-		fprintf(stderr, "Error %s while getting method list from jobject at \"%s:%d\".\n", jy_strerror(ret), __FILE__, __LINE__);
+		fprintf(stderr, "Error %s while fetching properties from jobject at \"%s:%d\".\n", jy_strerror(ret), __FILE__, __LINE__);
 #endif
 		if ((*jenv)->ExceptionCheck(jenv)) {
 			(*jenv)->ExceptionDescribe(jenv);
@@ -1831,36 +4725,264 @@ jyo_j2p(JNIEnv *jenv, jobject j, struct st_jyo *p)
 		}
 		fflush(stderr);
 
-	jyo_free_method_ll(&mll);
 		jyo_free(p);
 
 		return ret;
 	}
 
-jyo_free_method_ll(&mll);
-
 	return JY_ESUCCESS;
 }
 
 /**
- * Gets the pointer of the data of a "st_jyo" struct returned by "getter".
+ * Converts a "jobject" into an "st_jyo" struct allocating from "arena", which
+ * is not owned by it, or with malloc(3) if it is NULL.
+ */
+static int
+jyo_j2p_in(JNIEnv *jenv, jobject j, struct st_jyo *p, struct st_arena *arena)
+{
+	int ret;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+
+	/* Each nesting level converts in its own local frame, so the
+	 * references made by a level are released when it is done. */
+	if ((*jenv)->PushLocalFrame(jenv, JYO_LOCAL_FRAME) != 0) {
+		(*jenv)->ExceptionClear(jenv);
+		memset(p, 0, sizeof(struct st_jyo));
+		return JY_EENOMEM;
+	}
+
+	ret = jyo_j2p_level(jenv, j, p, arena);
+
+	(void)(*jenv)->PopLocalFrame(jenv, NULL);
+
+	return ret;
+}
+
+/**
+ * Converts a "jobject" into an "st_jyo" struct.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int
+jyo_j2p(JNIEnv *jenv, jobject j, struct st_jyo *p)
+{
+	return jyo_j2p_in(jenv, j, p, NULL);
+}
+
+/**
+ * Converts a "jobject" into an "st_jyo" struct backed by an arena, see
+ * jyo_init_arena(). Nested objects share the same arena.
+ *
+ * @param hint The expected memory use, in bytes, or 0 for a default.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int
+jyo_j2p_arena(JNIEnv *jenv, jobject j, struct st_jyo *p, size_t hint)
+{
+	struct st_arena *arena;
+	int ret;
+
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+
+	arena = arena_new(hint);
+	if (arena == NULL) {
+		memset(p, 0, sizeof(struct st_jyo));
+		return JY_EENOMEM;
+	}
+
+	ret = jyo_j2p_in(jenv, j, p, arena);
+	if ((ret == JY_ESUCCESS) && (p->arena == arena))
+		p->freearena = JNI_TRUE;
+	else
+		arena_destroy(arena);
+
+	return ret;
+}
+
+/**
+ * Gets the pointer of the data of a "st_jyo" struct returned by "getter",
+ * without copying it. The data is borrowed: it stays valid until the property
+ * is replaced or the struct is freed, and must not be modified.
  *
  * @param o The pointer to the "st_jyo" struct.
  * @param getter Name of the property to be fetched.
  * @param data_type The data type enum of the data.
- * @param data The variable where the pointer will be returned.
+ * @param data The variable where the pointer will be returned. NULL for null
+ * strings and objects.
  *
- * @return -1 in case of error and 0 for success.
+ * @return A "e_jy_err" error code: JY_ENOTFOUND if there is no such property
+ * and JY_EEINVAL if it is not of type "data_type".
  */
 int
 jyo_get_property(struct st_jyo *p, char *getter, enum e_jyo_type data_type, void **data)
 {
+	const struct st_jys *sym;
+	size_t size;
+
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(getter != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(data != NULL, JY_EEINVAL);
 
-	JY_WARN_ENOSYS();
-	return JY_EENOSYS;
+	*data = NULL;
+
+	/* A name never interned can't be the name of any property. */
+	sym = jys_lookup(getter);
+	if (sym == NULL)
+		return JY_ENOTFOUND;
+
+	return jyo_get_property_ref(p, sym, data_type, (const void **)data, &size);
+}
+
+/**
+ * Borrows the data of a property, like jyo_get_property(), along with its
+ * size.
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param getter The interned name of the property to be fetched.
+ * @param data_type The data type enum of the data.
+ * @param data The variable where the pointer will be returned.
+ * @param size The variable where the size of the data will be returned: the
+ * string length, without the terminating '\0', for strings.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyo_get_property_ref(const struct st_jyo *p, const struct st_jys *sym, enum e_jyo_type data_type, const void **data, size_t *size)
+{
+	const struct st_jyo_property *pp;
+	struct st_jyo_property view;
+
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(sym != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(data != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(size != NULL, JY_EEINVAL);
+
+	*data = NULL;
+	*size = 0;
+
+	pp = jyo_property_lookup(p, sym, &view);
+	if (pp == NULL)
+		return JY_ENOTFOUND;
+	if (pp->data_type != data_type)
+		return JY_EEINVAL;
+
+	*data = jyo_property_data(pp);
+	*size = jyo_property_size(pp);
+	/* Scalars of slots are borrowed from the object, not from the view. */
+	if ((pp == &view) && jyo_type_is_inline(data_type))
+		*data = (char *)p->values + jyo_shape_find(p->shape, sym)->offset;
+	if ((data_type == JYO_TSTRING) && (*size > 0))
+		(*size)--;
+	if ((data_type == JYO_TBLOB) && (*data != NULL))
+		*data = ((const struct st_jyo_lease *)*data)->blob.data;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Borrows the memory of a blob property, like jyo_get_property_ref(). The
+ * memory of blobs made by jyo_j2p() is the one of the direct ByteBuffer, or a
+ * copy of the content of a heap ByteBuffer, whose memory can't be borrowed.
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param getter The interned name of the property to be fetched.
+ * @param data The variable where the memory will be returned, or NULL for a
+ * null buffer.
+ * @param size The variable where the size of the memory will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyo_get_blob(const struct st_jyo *p, const struct st_jys *sym, void **data, size_t *size)
+{
+	const void *ref;
+	int ret;
+
+	JY_ASSERT_RETURN(data != NULL, JY_EEINVAL);
+
+	*data = NULL;
+
+	ret = jyo_get_property_ref(p, sym, JYO_TBLOB, &ref, size);
+	if (ret != JY_ESUCCESS)
+		return ret;
+
+	*data = (void *)ref;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Defines a typed accessor of scalar properties, reading the inline value.
+ */
+#define JYO_GET_SCALAR(name, ctype, type, member)			\
+int									\
+jyo_get_##name(const struct st_jyo *p, const struct st_jys *sym, ctype *val) \
+{									\
+	const struct st_jyo_property *pp;				\
+	struct st_jyo_property view;					\
+									\
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);			\
+	JY_ASSERT_RETURN(sym != NULL, JY_EEINVAL);			\
+	JY_ASSERT_RETURN(val != NULL, JY_EEINVAL);			\
+									\
+	pp = jyo_property_lookup(p, sym, &view);			\
+	if (pp == NULL)							\
+		return JY_ENOTFOUND;					\
+	if ((pp->data_type != (type)) || pp->isnull)			\
+		return JY_EEINVAL;					\
+									\
+	*val = pp->value.member;					\
+									\
+	return JY_ESUCCESS;						\
+}
+
+JYO_GET_SCALAR(boolean, jy_bool, JYO_TBOOLEAN, b)
+JYO_GET_SCALAR(byte, char, JYO_TBYTE, c)
+JYO_GET_SCALAR(char, char, JYO_TCHAR, c)
+JYO_GET_SCALAR(short, short, JYO_TSHORT, s)
+JYO_GET_SCALAR(int, int, JYO_TINT, i)
+JYO_GET_SCALAR(long, long, JYO_TLONG, l)
+JYO_GET_SCALAR(float, float, JYO_TFLOAT, f)
+JYO_GET_SCALAR(double, double, JYO_TDOUBLE, d)
+
+#undef JYO_GET_SCALAR
+
+/**
+ * Borrows the elements of an array property, like jyo_get_property_ref().
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param getter The interned name of the property to be fetched.
+ * @param data_type The JYO_T*ARRAY type of the property.
+ * @param data The variable where the elements will be returned, or NULL for
+ * a null array.
+ * @param length The variable where the number of elements will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyo_get_array(const struct st_jyo *p, const struct st_jys *sym, enum e_jyo_type data_type, const void **data, size_t *length)
+{
+	size_t elem_size;
+	size_t size;
+	int ret;
+
+	JY_ASSERT_RETURN(length != NULL, JY_EEINVAL);
+
+	*length = 0;
+
+	elem_size = jyo_get_array_elem_size(data_type);
+	JY_ASSERT_RETURN(elem_size > 0, JY_EEINVAL);
+
+	ret = jyo_get_property_ref(p, sym, data_type, data, &size);
+	if (ret != JY_ESUCCESS)
+		return ret;
+
+	*length = size / elem_size;
+
+	return JY_ESUCCESS;
 }
 
 /**
@@ -1876,38 +4998,67 @@ jyo_get_property(struct st_jyo *p, char *getter, enum e_jyo_type data_type, void
 int
 jyo_get_property_copy(struct st_jyo *p, char *getter, enum e_jyo_type data_type, void **buf)
 {
-	struct st_jyo_property_ll *reg_atual;
-	size_t data_size;
+	const struct st_jys *sym;
 
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(getter != NULL, JY_EEINVAL);
+
+	/* A name never interned can't be the name of any property. */
+	sym = jys_lookup(getter);
+	if (sym == NULL)
+		return JY_ENOTFOUND;
+
+	return jyo_get_property_copy_sym(p, sym, data_type, buf);
+}
+
+/**
+ * jyo_get_property_copy() taking the property name interned by jys_intern(),
+ * which saves hashing it.
+ */
+int
+jyo_get_property_copy_sym(struct st_jyo *p, const struct st_jys *sym, enum e_jyo_type data_type, void **buf)
+{
+	const struct st_jyo_property *reg_atual;
+	struct st_jyo_property view;
+	const void *data;
+	size_t data_size;
+
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(sym != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(buf != NULL, JY_EEINVAL);
 
 DEBUG_STR("copy");
-DEBUG_STR(getter);
+DEBUG_STR(sym->name);
 DEBUG_STR(p->clazz);
 
-	/* Iterate through the list comparing with "getter". */
-	for (reg_atual = p->properties;
-	    reg_atual != NULL;
-	    reg_atual = (struct st_jyo_property_ll *)reg_atual->ll.next) {
-		if (strncmp(reg_atual->st.method_name, getter, 255) == 0)
-			break;
-	}
+	reg_atual = jyo_property_lookup(p, sym, &view);
 
 	if (reg_atual == NULL)
 		return JY_ENOTFOUND;
+	data = jyo_property_data(reg_atual);
 
-	/* In case the data type is a string or is a null object... */
-	if (data_type == JYO_TSTRING || data_type == JYO_TJYO) {
-		if (reg_atual->st.data == NULL) {
+	/* In case the data type is a string or is a null object or array... */
+	if (data_type == JYO_TSTRING || data_type == JYO_TJYO ||
+	    jyo_get_array_elem_size(data_type) > 0) {
+		if (data == NULL) {
 			*buf = NULL;
 			return JY_ESUCCESS;
 		}
 	}
 
 	if (data_type == JYO_TSTRING) {
-		data_size = strlen((char *)reg_atual->st.data) + 1;
+		data_size = strlen((const char *)data) + 1;
+	} else if (jyo_get_array_elem_size(data_type) > 0) {
+		JY_ASSERT_RETURN(reg_atual->data_type == data_type, JY_EEINVAL);
+		/* Empty arrays still get a buffer of their own. */
+		data_size = jyo_property_size(reg_atual);
+		*buf = malloc(data_size > 0 ? data_size : 1);
+		if (*buf == NULL) {
+			p->error = JY_EENOMEM;
+			return JY_EENOMEM;
+		}
+		memcpy(*buf, data, data_size);
+		return JY_ESUCCESS;
 	} else {
 		data_size = jyo_get_type_size(data_type);
 		JY_ASSERT_RETURN(data_size != JY_EEINVAL, JY_EEINVAL);
@@ -1920,7 +5071,7 @@ DEBUG_STR(p->clazz);
 		return JY_EENOMEM;
 	}
 
-	memcpy(*buf, reg_atual->st.data, data_size);
+	memcpy(*buf, data, data_size);
 
 	if (data_type == JYO_TSTRING) {
 		((char *)*buf)[data_size-1] = '\000';
@@ -1945,50 +5096,80 @@ DEBUG_PTR(*buf);
 int
 jyo_get_property_buf(struct st_jyo *p, char *getter, enum e_jyo_type data_type, void *buf, size_t buf_size)
 {
-	struct st_jyo_property_ll *reg_atual;
+	const struct st_jys *sym;
 
 	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(getter != NULL, JY_EEINVAL);
+
+	/* A name never interned can't be the name of any property. */
+	sym = jys_lookup(getter);
+	if (sym == NULL)
+		return JY_ENOTFOUND;
+
+	return jyo_get_property_buf_sym(p, sym, data_type, buf, buf_size);
+}
+
+/**
+ * jyo_get_property_buf() taking the property name interned by jys_intern(),
+ * which saves hashing it.
+ */
+int
+jyo_get_property_buf_sym(struct st_jyo *p, const struct st_jys *sym, enum e_jyo_type data_type, void *buf, size_t buf_size)
+{
+	const struct st_jyo_property *reg_atual;
+	struct st_jyo_property view;
+	const void *data;
+
+	JY_ASSERT_RETURN(p != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(sym != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(buf != NULL, JY_EEINVAL);
 	JY_ASSERT_RETURN(buf_size > 0, JY_EEINVAL);
 
 DEBUG_STR("buf");
-DEBUG_STR(getter);
+DEBUG_STR(sym->name);
 DEBUG_STR(p->clazz);
 
-	if (data_type != JYO_TSTRING) {
+	if ((data_type != JYO_TSTRING) &&
+	    (jyo_get_array_elem_size(data_type) == 0)) {
 		JY_ASSERT_RETURN(jyo_get_type_size(data_type) != JY_EEINVAL, JY_EEINVAL);
 		JY_ASSERT_RETURN(jyo_get_type_size(data_type) <= buf_size, JY_EEINVAL);
 		buf_size = jyo_get_type_size(data_type);
 	}
 
-	/* Iterate through the list comparing with "getter". */
-	for (reg_atual = p->properties;
-	    reg_atual != NULL;
-	    reg_atual = (struct st_jyo_property_ll *)reg_atual->ll.next) {
-		if (strncmp(reg_atual->st.method_name, getter, 255) == 0)
-			break;
-	}
+	reg_atual = jyo_property_lookup(p, sym, &view);
 
 	if (reg_atual == NULL)
 		return JY_ENOTFOUND;
+	data = jyo_property_data(reg_atual);
 
-	/* In case the data type is a string or is a null object... */
-	if (data_type == JYO_TSTRING || data_type == JYO_TJYO) {
-		if (reg_atual->st.data == NULL) {
+	/* In case the data type is a string or is a null object or array... */
+	if (data_type == JYO_TSTRING || data_type == JYO_TJYO ||
+	    jyo_get_array_elem_size(data_type) > 0) {
+		if (data == NULL) {
 			/* buf = NULL;*/
 			memset (buf, 0, buf_size);
 			return JY_ESUCCESS;
 		}
 	}
 
+	if (jyo_get_array_elem_size(data_type) > 0) {
+		/* Copies as many elements as fit in "buf". */
+		JY_ASSERT_RETURN(reg_atual->data_type == data_type, JY_EEINVAL);
+		if (jyo_property_size(reg_atual) < buf_size)
+			buf_size = jyo_property_size(reg_atual);
+		buf_size -= buf_size % jyo_get_array_elem_size(data_type);
+		if (buf_size > 0)
+			memcpy(buf, data, buf_size);
+		return JY_ESUCCESS;
+	}
+
 	if (data_type == JYO_TSTRING) {
 		/* Ajust "buf". */
-		if ((strlen((char *)reg_atual->st.data) + 1) < buf_size)
-			buf_size = strlen((char *)reg_atual->st.data) + 1;
+		if ((strlen((const char *)data) + 1) < buf_size)
+			buf_size = strlen((const char *)data) + 1;
 	}
 
-	memcpy(buf, reg_atual->st.data, buf_size);
+	memcpy(buf, data, buf_size);
 	if (data_type == JYO_TSTRING) {
 		((char *)buf)[buf_size-1] = '\000';
 DEBUG_STR((char *)buf);
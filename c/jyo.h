@@ -35,6 +35,8 @@
 
 #include "jnyikes.h"
 #include "llist.h"
+#include "arena.h"
+#include "jys.h"
 
 enum e_jyo_type {
 	JYO_TSTRING	=  1,
@@ -51,6 +53,48 @@ enum e_jyo_type {
 	JYO_TVOID	= 12,
 	JYO_TJYO	= 13,
 	JYO_TJCLASS	= 14,
+	JYO_TBYTEARRAY	= 15,
+	JYO_TSHORTARRAY	= 16,
+	JYO_TINTARRAY	= 17,
+	JYO_TLONGARRAY	= 18,
+	JYO_TFLOATARRAY	= 19,
+	JYO_TDOUBLEARRAY	= 20,
+	JYO_TBLOB	= 21,
+};
+
+/**
+ * Primitive array, the data of the JYO_T*ARRAY types: "byte[]", "short[]",
+ * "int[]", "long[]", "float[]" and "double[]". Its elements are of the
+ * matching JNI type: jbyte, jshort, jint, jlong, jfloat or jdouble.
+ *
+ * jyo_set_property() takes a pointer to this struct, or NULL for a null
+ * array, and copies the elements.
+ */
+struct st_jyo_array {
+	/** The elements. May be NULL if "length" is 0. */
+	const void *data;
+	/** The number of elements. */
+	size_t length;
+};
+
+/**
+ * Block of memory, the data of the JYO_TBLOB type: a "java.nio.ByteBuffer"
+ * wrapping the memory itself, which is never copied.
+ *
+ * jyo_set_property() takes a pointer to this struct, or NULL for a null
+ * buffer, and the ownership of the memory, even if it fails. The memory must
+ * stay valid until "release" is called: once the "st_jyo" struct holding it
+ * is freed and every ByteBuffer made of it by jyo_p2j() was given back by a
+ * JNyIkes.release() call from Java.
+ */
+struct st_jyo_blob {
+	/** The memory. */
+	void *data;
+	/** The size of "data" in bytes. */
+	size_t size;
+	/** Called with "data" and "arg" when the memory is released, or NULL. */
+	void (*release)(void *data, void *arg);
+	void *arg;
 };
 
 /**
@@ -60,11 +104,41 @@ enum e_jyo_type {
  * jyo_send()) and not directly.
  */
 struct st_jyo {
-	/** The Java class. */
+	/**
+	 * The Java class, slash separated ("com/example/Foo"). Interned with
+	 * jys_intern_class(): it must not be freed.
+	 */
 	char *clazz;
 
-	/** The object properties contained in a linked list. */
-	struct st_jyo_property_ll *properties;
+	/**
+	 * The object properties contained in a linked list of
+	 * "st_jyo_property_ll", in the order they were set.
+	 */
+	struct st_llhead properties;
+
+	/**
+	 * Index of "properties" by name, built as properties are set.
+	 * "index_size" is a power of 2 or 0 while the index is not allocated.
+	 */
+	struct st_jyo_property_ll **index;
+	unsigned int index_size;
+
+	/**
+	 * The shape of the object, shared by the objects of its class made by
+	 * jyo_j2p(), or NULL. The properties it describes are stored in
+	 * "values" and "properties" only holds the ones set afterwards.
+	 */
+	const struct st_jyo_shape *shape;
+	/** The values of the slots of "shape", at their offsets. */
+	void *values;
+
+	/**
+	 * The arena everything of this struct is allocated from, or NULL if
+	 * it is allocated with malloc(3). See jyo_init_arena().
+	 */
+	struct st_arena *arena;
+	/** If jyo_free() must release "arena": false for children. */
+	jboolean freearena;
 
 	/**
 	 * Error indicator. If this variable is different than "JY_ESUCCESS",
@@ -81,25 +155,54 @@ struct st_jyo_property {
 	 * jyo_free() function will free(3) this structure.
 	 */
 	jboolean freeme;
-
-	/** The setter method name of the Java object to be called. */
-	char *method_name;
-#if 0
-	/** The Java object field to be configured. */
-	char *field; /* XXX TODO: implement. */
-#endif
+	/** If the scalar in "value" is null: it was set without data. */
+	jboolean isnull;
 
 	/** The type of the data contained in this node. */
 	enum e_jyo_type data_type;
-	/** The data of this node. */
-	void *data;
+
+	/** The interned setter method name of the Java object to be called. */
+	const struct st_jys *sym;
+
+	/** The data of this node, tagged by "data_type". */
+	union {
+		jy_bool b;
+		char c;
+		short s;
+		int i;
+		long l;
+		float f;
+		double d;
+		/** Strings, objects, arrays and blobs, allocated apart. */
+		struct {
+			/** The data, or NULL. */
+			void *data;
+			/**
+			 * The size of "data" in bytes, the terminating '\0'
+			 * included for strings, or 0 if it is NULL.
+			 */
+			size_t size;
+		} ref;
+	} value;
 };
 
 struct st_jyo_property_ll {
 	struct st_llist ll;
 	struct st_jyo_property st;
+	/** Next property of the same "st_jyo" index bucket. */
+	struct st_jyo_property_ll *hnext;
 };
 
+/**
+ * Shape of the objects of a class: the names and types of their properties
+ * and the offsets of their values, shared by all of them. An object with a
+ * shape keeps its values in one buffer instead of a list of properties.
+ *
+ * Shapes are built with jyo_shape_new() and jyo_shape_add() and made
+ * immutable by jyo_shape_intern(). Interned shapes are never freed.
+ */
+struct st_jyo_shape;
+
 /**
  * Initialize the jnyikes library.
  * @param version The version which the application expects.
@@ -129,30 +232,199 @@ const char *jyo_get_type_name(enum e_jyo_type t);
  */
 int jyo_init(struct st_jyo *o, char *clazz);
 
+/**
+ * Initializes a "st_jyo" struct backed by an arena: its properties and their
+ * data are carved from a few large blocks instead of being allocated one by
+ * one, and jyo_free() releases them all at once.
+ *
+ * The other jyo APIs work unchanged on such a struct.
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param clazz The name of the class to be created.
+ * @param hint The expected memory use, in bytes, or 0 for a default.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyo_init_arena(struct st_jyo *o, char *clazz, size_t hint);
+
+/**
+ * Initializes a "st_jyo" struct to be set as a JYO_TJYO property of "parent",
+ * sharing its arena if it has one. Such a child is released with its parent
+ * and must not be used after it.
+ *
+ * @param parent The "st_jyo" struct the child will belong to.
+ * @param o The pointer to the child "st_jyo" struct.
+ * @param clazz The name of the class to be created.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyo_init_child(struct st_jyo *parent, struct st_jyo *o, char *clazz);
+
+/**
+ * Clears the properties of the "st_jyo" struct, keeping its class and the
+ * memory it has allocated so it can be filled again without allocating.
+ *
+ * Arena backed structs rewind their arena. The properties of other structs
+ * are freed, but their nodes are recycled by llfree() and their index is
+ * kept.
+ *
+ * @param o Pointer to the "st_jyo" struct. It must not be a child sharing
+ * the arena of its parent.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyo_reset(struct st_jyo *o);
+
+/**
+ * Gets an empty arena backed "st_jyo" struct of the class "clazz", reusing
+ * one released by the calling thread if there is one. A thread that keeps
+ * acquiring and releasing structs of the same classes ends up allocating no
+ * memory at all.
+ *
+ * @param clazz The name of the class to be created.
+ * @param o Where the struct will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyo_acquire(char *clazz, struct st_jyo **o);
+
+/**
+ * Gives back a struct returned by jyo_acquire(). It is reset with
+ * jyo_reset() and kept in the pool of the calling thread, or freed if the
+ * pool is full.
+ *
+ * @param o The struct. It must not be used afterwards.
+ */
+void jyo_release(struct st_jyo *o);
+
+/**
+ * Sets the number of structs of each class kept by the pool of each thread.
+ * 0 disables the pool.
+ */
+void jyo_pool_limit(unsigned int n);
+
 /**
  * Sets up the property of an "st_jyo" struct.
  *
  * @param o The pointer to the "st_jyo" struct.
  * @param setter The name of the property to be set.
  * @param data_type The data type enum of the data to be set.
- * @param data The pointer to the data to be set.
+ * @param data The pointer to the data to be set. A JYO_TJYO struct is copied
+ * and its contents belong to "o" afterwards, so it must not be used nor freed.
  *
  * @return -1 in case of error and 0 for success.
  */
 int jyo_set_property(struct st_jyo *p, const char *setter, enum e_jyo_type data_type, const void *orig_data);
 
 /**
- * Gets the pointer of the data of a "st_jyo" struct returned by "getter".
+ * jyo_set_property() taking the property name interned by jys_intern(), which
+ * saves hashing it.
+ */
+int jyo_set_property_sym(struct st_jyo *p, const struct st_jys *setter, enum e_jyo_type data_type, const void *orig_data);
+
+/**
+ * Sets up the property of an "st_jyo" struct, replacing its value in place if
+ * the property is already set.
+ *
+ * Unlike jyo_set_property(), setting the same property repeatedly does not
+ * make the "st_jyo" struct grow nor the setter be called more than once by
+ * jyo_p2j().
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param setter The name of the property to be set.
+ * @param data_type The data type enum of the data to be set.
+ * @param data The pointer to the data to be set, like jyo_set_property().
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyo_put_property(struct st_jyo *p, const char *setter, enum e_jyo_type data_type, const void *orig_data);
+
+/**
+ * jyo_put_property() taking the property name interned by jys_intern(), which
+ * saves hashing it.
+ */
+int jyo_put_property_sym(struct st_jyo *p, const struct st_jys *setter, enum e_jyo_type data_type, const void *orig_data);
+
+/**
+ * Gets the pointer of the data of a "st_jyo" struct returned by "getter",
+ * without copying it. The data is borrowed: it stays valid until the property
+ * is replaced or the struct is freed, and must not be modified.
  *
  * @param o The pointer to the "st_jyo" struct.
  * @param getter Name of the property to be fetched.
  * @param data_type The data type enum of the data.
- * @param data The variable where the pointer will be returned.
+ * @param data The variable where the pointer will be returned. NULL for null
+ * strings and objects.
  *
- * @return -1 in case of error and 0 for success.
+ * @return A "e_jy_err" error code: JY_ENOTFOUND if there is no such property
+ * and JY_EEINVAL if it is not of type "data_type".
  */
 int jyo_get_property(struct st_jyo *o, char *getter, enum e_jyo_type data_type, void **data);
 
+/**
+ * Borrows the data of a property, like jyo_get_property(), along with its
+ * size.
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param getter The interned name of the property to be fetched.
+ * @param data_type The data type enum of the data.
+ * @param data The variable where the pointer will be returned.
+ * @param size The variable where the size of the data will be returned: the
+ * string length, without the terminating '\0', for strings and the size in
+ * bytes of the elements for arrays.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyo_get_property_ref(const struct st_jyo *o, const struct st_jys *getter, enum e_jyo_type data_type, const void **data, size_t *size);
+
+/**
+ * Borrows the memory of a blob property, like jyo_get_property_ref(). The
+ * memory of blobs made by jyo_j2p() is the one of the direct ByteBuffer, or a
+ * copy of the content of a heap ByteBuffer, whose memory can't be borrowed.
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param getter The interned name of the property to be fetched.
+ * @param data The variable where the memory will be returned, or NULL for a
+ * null buffer.
+ * @param size The variable where the size of the memory will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyo_get_blob(const struct st_jyo *o, const struct st_jys *getter, void **data, size_t *size);
+
+/**
+ * Reads a scalar property straight from the "st_jyo" struct.
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param getter The interned name of the property to be fetched.
+ * @param val Where the value will be stored.
+ *
+ * @return A "e_jy_err" error code: JY_ENOTFOUND if there is no such property
+ * and JY_EEINVAL if it is not of the accessor type or is null.
+ */
+int jyo_get_boolean(const struct st_jyo *o, const struct st_jys *getter, jy_bool *val);
+int jyo_get_byte(const struct st_jyo *o, const struct st_jys *getter, char *val);
+int jyo_get_char(const struct st_jyo *o, const struct st_jys *getter, char *val);
+int jyo_get_short(const struct st_jyo *o, const struct st_jys *getter, short *val);
+int jyo_get_int(const struct st_jyo *o, const struct st_jys *getter, int *val);
+int jyo_get_long(const struct st_jyo *o, const struct st_jys *getter, long *val);
+int jyo_get_float(const struct st_jyo *o, const struct st_jys *getter, float *val);
+int jyo_get_double(const struct st_jyo *o, const struct st_jys *getter, double *val);
+
+/**
+ * Borrows the elements of an array property, like jyo_get_property_ref().
+ *
+ * @param o The pointer to the "st_jyo" struct.
+ * @param getter The interned name of the property to be fetched.
+ * @param data_type The JYO_T*ARRAY type of the property.
+ * @param data The variable where the elements will be returned, or NULL for
+ * a null array.
+ * @param length The variable where the number of elements will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyo_get_array(const struct st_jyo *o, const struct st_jys *getter, enum e_jyo_type data_type, const void **data, size_t *length);
+
 /**
  * Duplicates the data of a "st_jyo" struct returned by "getter".
  *
@@ -165,6 +437,12 @@ int jyo_get_property(struct st_jyo *o, char *getter, enum e_jyo_type data_type,
  */
 int jyo_get_property_copy(struct st_jyo *o, char *getter, enum e_jyo_type data_type, void **buf);
 
+/**
+ * jyo_get_property_copy() taking the property name interned by jys_intern(),
+ * which saves hashing it.
+ */
+int jyo_get_property_copy_sym(struct st_jyo *o, const struct st_jys *getter, enum e_jyo_type data_type, void **buf);
+
 /**
  * Reads the data of a "st_jyo" struct returned by "getter" into a passed buffer.
  *
@@ -178,6 +456,12 @@ int jyo_get_property_copy(struct st_jyo *o, char *getter, enum e_jyo_type data_t
  */
 int jyo_get_property_buf(struct st_jyo *o, char *getter, enum e_jyo_type data_type, void *data, size_t data_size);
 
+/**
+ * jyo_get_property_buf() taking the property name interned by jys_intern(),
+ * which saves hashing it.
+ */
+int jyo_get_property_buf_sym(struct st_jyo *o, const struct st_jys *getter, enum e_jyo_type data_type, void *data, size_t data_size);
+
 /**
  * Converts the "st_jyo" struct to a Java object (jobject) and send it to a
  * Java static method of a defined class.
@@ -190,6 +474,100 @@ int jyo_get_property_buf(struct st_jyo *o, char *getter, enum e_jyo_type data_ty
  */
 int jyo_send(JNIEnv *jenv, struct st_jyo *p, const char *clazz, const char *method);
 
+/**
+ * Converts the "st_jyo" structs "objs" to Java objects and sends them all at
+ * once to a Java static method of a defined class, in a single call.
+ *
+ * The receiving method takes an "Object[]" with the objects in order and
+ * returns a "boolean[]" telling, for each one, if it was accepted. The objects
+ * that could not be converted are null in the array.
+ *
+ * @param objs The "st_jyo" structs.
+ * @param n The number of "st_jyo" structs.
+ * @param clazz Name of the receiving class.
+ * @param method Name of the receiving method.
+ * @param status Where the "e_jy_err" error code of each object will be
+ * returned, or NULL: JY_EEXCEPTION for the objects not accepted.
+ *
+ * @return The "e_jy_err" error enumerator: JY_ESUCCESS if every object was
+ * sent and accepted, or else the error of the first that was not.
+ */
+int jyo_send_batch(JNIEnv *jenv, struct st_jyo **objs, size_t n, const char *clazz, const char *method, int *status);
+
+/**
+ * Pre-resolved jyo_send() target: the receiving class and static method.
+ */
+struct st_jyo_target;
+
+/**
+ * Resolves a jyo_send() target once, so it can be used by jyo_send_to()
+ * without any class or method lookup.
+ *
+ * @param clazz Name of the receiving class.
+ * @param method Name of the receiving static method.
+ * @param pclazz Name of the class of the objects to be sent, dotted or slash
+ * separated.
+ * @param t Where the target will be returned.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int jyo_target_new(JNIEnv *jenv, const char *clazz, const char *method, const char *pclazz, struct st_jyo_target **t);
+
+/**
+ * Converts the "st_jyo" struct to a Java object (jobject) and send it to a
+ * target resolved by jyo_target_new().
+ *
+ * @param t The target.
+ * @param p Pointer to the "st_jyo" struct. Its class must be the one the
+ * target was resolved for.
+ *
+ * @return The "e_jy_err" error enumerator. JY_ENOJCLASS if the receiving
+ * class has been unloaded.
+ */
+int jyo_send_to(JNIEnv *jenv, struct st_jyo_target *t, struct st_jyo *p);
+
+/**
+ * Frees a target returned by jyo_target_new().
+ */
+void jyo_target_free(JNIEnv *jenv, struct st_jyo_target *t);
+
+/**
+ * Starts building the shape of the objects of a class.
+ *
+ * @param clazz The class name.
+ * @param nslots The number of properties the shape will have.
+ * @param shape Where the shape will be returned.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int jyo_shape_new(const char *clazz, unsigned int nslots, struct st_jyo_shape **shape);
+
+/**
+ * Adds a property to a shape being built. Properties keep the order they are
+ * added in, which is the order jyo_p2j() sets them.
+ *
+ * @param sym The interned property name.
+ * @param data_type The type of the property: a scalar, JYO_TSTRING, JYO_TJYO
+ * or one of the JYO_T*ARRAY types. Blobs can't be stored in a shape.
+ *
+ * @return The "e_jy_err" error enumerator: JY_EEINVAL if the type can't be
+ * stored in a shape or the shape already has such a property.
+ */
+int jyo_shape_add(struct st_jyo_shape *shape, const struct st_jys *sym, enum e_jyo_type data_type);
+
+/**
+ * Interns a shape built by jyo_shape_new(), so identical shapes are shared.
+ * "shape" must not be used afterwards.
+ *
+ * @return The interned shape or NULL if there is no memory.
+ */
+const struct st_jyo_shape *jyo_shape_intern(struct st_jyo_shape *shape);
+
+/**
+ * Frees a shape built by jyo_shape_new() that was not interned.
+ */
+void jyo_shape_free(struct st_jyo_shape *shape);
+
 /**
  * Free the "st_jyo" struct.
  *
@@ -211,6 +589,78 @@ int jyo_error(struct st_jyo *o);
  */
 int jyo_p2j(JNIEnv *jenv, struct st_jyo *p, jobject *j);
 
+/**
+ * Encodes an "st_jyo" struct in the wire format read by the Java class
+ * "com.googlecode.jnyikes.Wire":
+ *
+ *	object   = name count property{count}
+ *	property = name type value
+ *
+ * A "name" is a varint, the number of a name already defined in the message
+ * plus 1, or 0 followed by the varint length and the UTF-8 bytes of a name
+ * which gets the next number: class and property names share the numbers.
+ * The "count" is a varint and the "type" a byte, the "e_jyo_type" of the
+ * value, which is written as:
+ *
+ *	JYO_TBOOLEAN, JYO_TBYTE		one byte
+ *	JYO_TCHAR			varint of the UTF-16 code unit
+ *	JYO_TSHORT, JYO_TINT, JYO_TLONG	zigzag varint
+ *	JYO_TFLOAT, JYO_TDOUBLE		little endian IEEE 754
+ *	JYO_TSTRING			varint length plus 1 and the UTF-8
+ *					bytes, or 0 for null
+ *	JYO_TJYO			byte 1 and an object, or 0 for null
+ *	JYO_TVOID			nothing
+ *	JYO_T*ARRAY			varint length plus 1 and the little
+ *					endian elements, or 0 for null
+ *
+ * JYO_TUINT and JYO_TULONG are written as JYO_TINT and JYO_TLONG. Varints
+ * hold 7 bits per byte, least significant first, and have the high bit set
+ * on every byte but the last.
+ *
+ * @param buf Where the malloc(3)ed message will be returned.
+ * @param size Where the size of the message will be returned.
+ *
+ * @return The "e_jy_err" error enumerator: JY_EENOSYS if "p" holds a blob.
+ */
+int jyo_wire_encode(const struct st_jyo *p, void **buf, size_t *size);
+
+/**
+ * Decodes a message of the wire format of jyo_wire_encode() into an "st_jyo"
+ * struct backed by an arena, see jyo_init_arena(). Malformed or truncated
+ * messages are rejected.
+ *
+ * @param buf The message. It is not kept.
+ * @param size The size of the message.
+ * @param o Where the "st_jyo" struct will be returned.
+ *
+ * @return The "e_jy_err" error enumerator: JY_EEINVAL if the message is not
+ * valid.
+ */
+int jyo_wire_decode(const void *buf, size_t size, struct st_jyo *o);
+
+/**
+ * Converts an "st_jyo" struct into a "jobject" in a single call to Java: the
+ * whole tree is encoded with jyo_wire_encode() and rebuilt by the Java side,
+ * instead of calling each setter through JNI. Trees holding blobs are
+ * converted with jyo_p2j().
+ *
+ * The Java side calls the public no argument constructor of each class and
+ * the public setters, or else sets the public fields, like jyo_p2j() does
+ * for classes without flags.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int jyo_p2j_wire(JNIEnv *jenv, struct st_jyo *p, jobject *j);
+
+/**
+ * Gives back a ByteBuffer made of a blob by jyo_p2j(): its memory is released
+ * once no one else holds it. Java must not use the ByteBuffer afterwards.
+ *
+ * @return The "e_jy_err" error enumerator: JY_ENOTFOUND if "jbuf" was not
+ * made by jyo_p2j() or was already given back.
+ */
+int jyo_blob_release(JNIEnv *jenv, jobject jbuf);
+
 /**
  * Converts a "jobject" into an "st_jyo" struct.
  *
@@ -218,4 +668,14 @@ int jyo_p2j(JNIEnv *jenv, struct st_jyo *p, jobject *j);
  */
 int jyo_j2p(JNIEnv *jenv, jobject j, struct st_jyo *p);
 
+/**
+ * Converts a "jobject" into an "st_jyo" struct backed by an arena, see
+ * jyo_init_arena(). Nested objects share the same arena.
+ *
+ * @param hint The expected memory use, in bytes, or 0 for a default.
+ *
+ * @return The "e_jy_err" error enumerator.
+ */
+int jyo_j2p_arena(JNIEnv *jenv, jobject j, struct st_jyo *p, size_t hint);
+
 #endif /* !defined(_JYO_H_) */
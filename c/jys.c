@@ -0,0 +1,202 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "jnyikes.h"
+#include "jys.h"
+
+/** Initial number of buckets of the symbol table. Must be a power of 2. */
+#define JYS_HASH_MIN_SIZE 256
+
+/** The symbol table, guarded by "g_jys_lock". */
+static struct st_jys **g_jys_table = NULL;
+static unsigned int g_jys_table_size = 0;
+static unsigned int g_jys_count = 0;
+static pthread_rwlock_t g_jys_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/**
+ * Finds the symbol of "name". The lock must be held.
+ */
+static struct st_jys *
+jys_find_locked(const char *name, unsigned int hash)
+{
+	struct st_jys *s;
+
+	if (g_jys_table == NULL)
+		return NULL;
+
+	for (s = g_jys_table[hash & (g_jys_table_size - 1)]; s != NULL;
+	    s = s->next) {
+		if ((s->hash == hash) && (strcmp(s->name, name) == 0))
+			return s;
+	}
+
+	return NULL;
+}
+
+/**
+ * Doubles the symbol table. The lock must be held for writing.
+ */
+static int
+jys_grow_locked(void)
+{
+	struct st_jys **table, *s;
+	unsigned int i, size;
+
+	size = g_jys_table_size == 0 ? JYS_HASH_MIN_SIZE : g_jys_table_size * 2;
+	table = malloc(size * sizeof(struct st_jys *));
+	if (table == NULL)
+		return JY_EENOMEM;
+	memset(table, 0, size * sizeof(struct st_jys *));
+
+	for (i = 0; i < g_jys_table_size; i++) {
+		while (g_jys_table[i] != NULL) {
+			s = g_jys_table[i];
+			g_jys_table[i] = s->next;
+			s->next = table[s->hash & (size - 1)];
+			table[s->hash & (size - 1)] = s;
+		}
+	}
+
+	free(g_jys_table);
+	g_jys_table = table;
+	g_jys_table_size = size;
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Gets the symbol of a name, interning it if needed.
+ *
+ * @return The symbol or NULL if there is no memory.
+ */
+const struct st_jys *
+jys_intern(const char *name)
+{
+	struct st_jys *s;
+	unsigned int hash;
+	size_t len;
+
+	JY_ASSERT_RETURN(name != NULL, NULL);
+
+	hash = jy_strhash(name);
+
+	(void)pthread_rwlock_rdlock(&g_jys_lock);
+	s = jys_find_locked(name, hash);
+	(void)pthread_rwlock_unlock(&g_jys_lock);
+	if (s != NULL)
+		return s;
+
+	(void)pthread_rwlock_wrlock(&g_jys_lock);
+	/* Someone else may have interned it meanwhile. */
+	s = jys_find_locked(name, hash);
+	if (s != NULL) {
+		(void)pthread_rwlock_unlock(&g_jys_lock);
+		return s;
+	}
+
+	if ((g_jys_count + 1 > g_jys_table_size) &&
+	    (jys_grow_locked() != JY_ESUCCESS) && (g_jys_table == NULL)) {
+		(void)pthread_rwlock_unlock(&g_jys_lock);
+		return NULL;
+	}
+
+	len = strlen(name);
+	s = malloc(sizeof(struct st_jys) + len + 1);
+	if (s == NULL) {
+		(void)pthread_rwlock_unlock(&g_jys_lock);
+		return NULL;
+	}
+	s->hash = hash;
+	memcpy(s->name, name, len + 1);
+
+	s->next = g_jys_table[hash & (g_jys_table_size - 1)];
+	g_jys_table[hash & (g_jys_table_size - 1)] = s;
+	g_jys_count++;
+
+	(void)pthread_rwlock_unlock(&g_jys_lock);
+
+	return s;
+}
+
+/**
+ * Gets the symbol of a name without interning it.
+ *
+ * @return The symbol or NULL if the name has never been interned.
+ */
+const struct st_jys *
+jys_lookup(const char *name)
+{
+	struct st_jys *s;
+
+	JY_ASSERT_RETURN(name != NULL, NULL);
+
+	(void)pthread_rwlock_rdlock(&g_jys_lock);
+	s = jys_find_locked(name, jy_strhash(name));
+	(void)pthread_rwlock_unlock(&g_jys_lock);
+
+	return s;
+}
+
+/**
+ * Gets the symbol of a class name in the "FindClass()" form
+ * ("com/example/Foo"), interning it if needed.
+ *
+ * @param name The class name, either dotted, as returned by "Class.getName()",
+ * or slash separated.
+ *
+ * @return The symbol or NULL if there is no memory.
+ */
+const struct st_jys *
+jys_intern_class(const char *name)
+{
+	const struct st_jys *s;
+	char *temp, *p;
+
+	JY_ASSERT_RETURN(name != NULL, NULL);
+
+	if (strchr(name, '.') == NULL)
+		return jys_intern(name);
+
+	temp = strdup(name);
+	if (temp == NULL)
+		return NULL;
+	for (p = strchr(temp, '.'); p != NULL; p = strchr(p, '.'))
+		*p = '/';
+
+	s = jys_intern(temp);
+	free(temp);
+
+	return s;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_JYS_H_)
+#define _JYS_H_
+
+/**
+ * Interned symbol: a process wide unique copy of a property or class name.
+ *
+ * Symbols are never freed, so they can be compared by address and kept
+ * anywhere without copying their names.
+ */
+struct st_jys {
+	/** Next symbol of the same hash bucket. */
+	struct st_jys *next;
+	/** The jy_strhash() of the name. */
+	unsigned int hash;
+	/** The name. */
+	char name[];
+};
+
+/**
+ * Gets the symbol of a name, interning it if needed.
+ *
+ * @return The symbol or NULL if there is no memory.
+ */
+const struct st_jys *jys_intern(const char *name);
+
+/**
+ * Gets the symbol of a name without interning it.
+ *
+ * @return The symbol or NULL if the name has never been interned.
+ */
+const struct st_jys *jys_lookup(const char *name);
+
+/**
+ * Gets the symbol of a class name in the "FindClass()" form
+ * ("com/example/Foo"), interning it if needed.
+ *
+ * @param name The class name, either dotted, as returned by "Class.getName()",
+ * or slash separated.
+ *
+ * @return The symbol or NULL if there is no memory.
+ */
+const struct st_jys *jys_intern_class(const char *name);
+
+#endif /* !defined(_JYS_H_) */
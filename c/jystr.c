@@ -0,0 +1,269 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include <jni.h>
+
+#include "jnyikes.h"
+#include "jyutf.h"
+#include "jystr.h"
+
+/**
+ * A cached String, in a hash bucket and in the LRU list.
+ */
+struct st_jystr_entry {
+	/** Next entry of the same hash bucket. */
+	struct st_jystr_entry *next;
+	/** The LRU list neighbours: "prev" was used more recently. */
+	struct st_jystr_entry *prev_lru;
+	struct st_jystr_entry *next_lru;
+	/** The jy_strhash() of "str". */
+	unsigned int hash;
+	/** Global reference to the String. */
+	jstring jstr;
+	char str[];
+};
+
+struct st_jystr {
+	pthread_mutex_t lock;
+	/** The hash buckets: a power of 2 not smaller than "size". */
+	struct st_jystr_entry **table;
+	unsigned int table_size;
+	/** The most and the least recently used entries. */
+	struct st_jystr_entry *head;
+	struct st_jystr_entry *tail;
+	unsigned int count;
+	unsigned int size;
+};
+
+/**
+ * Creates a cache.
+ *
+ * @param size The number of Strings it holds at most.
+ * @param sc Where the cache will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jystr_new(unsigned int size, struct st_jystr **sc)
+{
+	struct st_jystr *c;
+
+	JY_ASSERT_RETURN(size > 0, JY_EEINVAL);
+	JY_ASSERT_RETURN(sc != NULL, JY_EEINVAL);
+
+	c = malloc(sizeof(struct st_jystr));
+	if (c == NULL)
+		return JY_EENOMEM;
+	memset(c, 0, sizeof(struct st_jystr));
+
+	for (c->table_size = 1; c->table_size < size; c->table_size *= 2);
+	c->table = malloc(c->table_size * sizeof(struct st_jystr_entry *));
+	if (c->table == NULL) {
+		free(c);
+		return JY_EENOMEM;
+	}
+	memset(c->table, 0, c->table_size * sizeof(struct st_jystr_entry *));
+
+	c->size = size;
+	pthread_mutex_init(&c->lock, NULL);
+
+	*sc = c;
+
+	return JY_ESUCCESS;
+}
+
+static void
+jystr_lru_unlink(struct st_jystr *c, struct st_jystr_entry *e)
+{
+	if (e->prev_lru != NULL)
+		e->prev_lru->next_lru = e->next_lru;
+	else
+		c->head = e->next_lru;
+	if (e->next_lru != NULL)
+		e->next_lru->prev_lru = e->prev_lru;
+	else
+		c->tail = e->prev_lru;
+}
+
+static void
+jystr_lru_push(struct st_jystr *c, struct st_jystr_entry *e)
+{
+	e->prev_lru = NULL;
+	e->next_lru = c->head;
+	if (c->head != NULL)
+		c->head->prev_lru = e;
+	else
+		c->tail = e;
+	c->head = e;
+}
+
+/**
+ * Finds the entry of "str" and makes it the most recently used one. The lock
+ * must be held.
+ */
+static struct st_jystr_entry *
+jystr_find_locked(struct st_jystr *c, const char *str, unsigned int hash)
+{
+	struct st_jystr_entry *e;
+
+	for (e = c->table[hash & (c->table_size - 1)]; e != NULL; e = e->next) {
+		if ((e->hash == hash) && (strcmp(e->str, str) == 0))
+			break;
+	}
+
+	if ((e != NULL) && (e != c->head)) {
+		jystr_lru_unlink(c, e);
+		jystr_lru_push(c, e);
+	}
+
+	return e;
+}
+
+/**
+ * Removes the least recently used entry. The lock must be held.
+ */
+static struct st_jystr_entry *
+jystr_evict_locked(struct st_jystr *c)
+{
+	struct st_jystr_entry **ep, *e;
+
+	e = c->tail;
+	jystr_lru_unlink(c, e);
+
+	for (ep = &c->table[e->hash & (c->table_size - 1)]; *ep != e;
+	    ep = &(*ep)->next);
+	*ep = e->next;
+	c->count--;
+
+	return e;
+}
+
+/**
+ * Gets the Java String of a C string from a cache, creating it if needed.
+ *
+ * @param str The string, in UTF-8 as taken by jyutf_new_string().
+ * @param jstr Where a new local reference to the String will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jystr_get(JNIEnv *jenv, struct st_jystr *c, const char *str, jstring *jstr)
+{
+	struct st_jystr_entry *e, *old;
+	unsigned int hash;
+	size_t len;
+	int ret;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(c != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(str != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(jstr != NULL, JY_EEINVAL);
+
+	len = strlen(str);
+	hash = jy_strhash(str);
+
+	if (len <= JYSTR_MAX_LEN) {
+		/* The local reference is made while the lock keeps the entry
+		 * from being evicted. */
+		pthread_mutex_lock(&c->lock);
+		e = jystr_find_locked(c, str, hash);
+		*jstr = e != NULL ? (*jenv)->NewLocalRef(jenv, e->jstr) : NULL;
+		pthread_mutex_unlock(&c->lock);
+		if (*jstr != NULL)
+			return JY_ESUCCESS;
+	}
+
+	ret = jyutf_new_string(jenv, str, len, jstr);
+	if (ret != JY_ESUCCESS)
+		return ret;
+	if (len > JYSTR_MAX_LEN)
+		return JY_ESUCCESS;
+
+	/* Failing to cache it is not an error. */
+	e = malloc(sizeof(struct st_jystr_entry) + len + 1);
+	if (e == NULL)
+		return JY_ESUCCESS;
+	e->jstr = (*jenv)->NewGlobalRef(jenv, *jstr);
+	if (e->jstr == NULL) {
+		free(e);
+		return JY_ESUCCESS;
+	}
+	e->hash = hash;
+	memcpy(e->str, str, len + 1);
+
+	old = NULL;
+	pthread_mutex_lock(&c->lock);
+	/* Someone else may have cached it meanwhile. */
+	if (jystr_find_locked(c, str, hash) != NULL) {
+		old = e;
+	} else {
+		if (c->count == c->size)
+			old = jystr_evict_locked(c);
+		e->next = c->table[hash & (c->table_size - 1)];
+		c->table[hash & (c->table_size - 1)] = e;
+		jystr_lru_push(c, e);
+		c->count++;
+	}
+	pthread_mutex_unlock(&c->lock);
+
+	if (old != NULL) {
+		(*jenv)->DeleteGlobalRef(jenv, old->jstr);
+		free(old);
+	}
+
+	return JY_ESUCCESS;
+}
+
+/**
+ * Frees a cache, deleting the references to its Strings.
+ */
+void
+jystr_free(JNIEnv *jenv, struct st_jystr *c)
+{
+	struct st_jystr_entry *e;
+
+	if (c == NULL)
+		return;
+
+	while ((e = c->head) != NULL) {
+		c->head = e->next_lru;
+		(*jenv)->DeleteGlobalRef(jenv, e->jstr);
+		free(e);
+	}
+
+	pthread_mutex_destroy(&c->lock);
+	free(c->table);
+	free(c);
+}
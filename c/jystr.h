@@ -0,0 +1,74 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_JYSTR_H_)
+#define _JYSTR_H_
+
+#include <jni.h>
+
+/**
+ * Cache of Java Strings by content, so converting the same C string again
+ * reuses one canonical String instead of creating a new one.
+ *
+ * It holds global references to up to a fixed number of Strings, evicting the
+ * least recently used one. Strings longer than JYSTR_MAX_LEN bytes are never
+ * cached. Caches are thread safe.
+ */
+struct st_jystr;
+
+/** Length of the longest string cached. */
+#define JYSTR_MAX_LEN 255
+
+/**
+ * Creates a cache.
+ *
+ * @param size The number of Strings it holds at most.
+ * @param sc Where the cache will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jystr_new(unsigned int size, struct st_jystr **sc);
+
+/**
+ * Gets the Java String of a C string from a cache, creating it if needed.
+ *
+ * @param str The string, in UTF-8 as taken by jyutf_new_string().
+ * @param jstr Where a new local reference to the String will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jystr_get(JNIEnv *jenv, struct st_jystr *sc, const char *str, jstring *jstr);
+
+/**
+ * Frees a cache, deleting the references to its Strings.
+ */
+void jystr_free(JNIEnv *jenv, struct st_jystr *sc);
+
+#endif /* !defined(_JYSTR_H_) */
@@ -0,0 +1,398 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <jni.h>
+
+#include "jnyikes.h"
+#include "jyutf.h"
+
+/** Strings up to this many code units are converted on the stack. */
+#define JYUTF_STACK_UNITS 512
+
+/** The replacement character of invalid sequences. */
+#define JYUTF_REPLACEMENT 0xfffd
+
+/** Number of bytes converted at a time by the ASCII fast paths. */
+#if defined(__AVX2__)
+#define JYUTF_VECTOR 32
+#elif defined(__SSE2__)
+#define JYUTF_VECTOR 16
+#else
+#define JYUTF_VECTOR 8
+#endif
+
+/**
+ * Widens the leading ASCII bytes of "s" into "d", a whole vector at a time.
+ *
+ * @return The number of bytes converted, which may stop short of the first
+ * non ASCII byte: the caller converts the rest.
+ */
+static size_t
+jyutf_widen_ascii(const unsigned char *s, size_t len, jchar *d)
+{
+	size_t i;
+
+	i = 0;
+#if defined(__AVX2__)
+	for (; i + 32 <= len; i += 32) {
+		__m256i v;
+
+		v = _mm256_loadu_si256((const __m256i *)(s + i));
+		if (_mm256_movemask_epi8(v) != 0)
+			break;
+		_mm256_storeu_si256((__m256i *)(d + i),
+		    _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+		_mm256_storeu_si256((__m256i *)(d + i + 16),
+		    _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+	}
+#elif defined(__SSE2__)
+	for (; i + 16 <= len; i += 16) {
+		__m128i v, zero;
+
+		v = _mm_loadu_si128((const __m128i *)(s + i));
+		if (_mm_movemask_epi8(v) != 0)
+			break;
+		zero = _mm_setzero_si128();
+		_mm_storeu_si128((__m128i *)(d + i), _mm_unpacklo_epi8(v, zero));
+		_mm_storeu_si128((__m128i *)(d + i + 8), _mm_unpackhi_epi8(v, zero));
+	}
+#else
+	for (; i + 8 <= len; i += 8) {
+		uint64_t w;
+		unsigned int k;
+
+		memcpy(&w, s + i, sizeof(w));
+		if ((w & UINT64_C(0x8080808080808080)) != 0)
+			break;
+		for (k = 0; k < 8; k++)
+			d[i + k] = s[i + k];
+	}
+#endif
+
+	return i;
+}
+
+/**
+ * Narrows the leading code units of "s" in U+0001..U+007F into "d", a whole
+ * vector at a time. "d" may be NULL to just count them.
+ *
+ * @return The number of code units converted, which may stop short of the
+ * first other one: the caller converts the rest.
+ */
+static size_t
+jyutf_narrow_ascii(const jchar *s, size_t len, char *d)
+{
+	size_t i;
+
+	i = 0;
+#if defined(__AVX2__)
+	for (; i + 32 <= len; i += 32) {
+		__m256i a, b, ok;
+
+		/* Units are compared as signed: those from U+8000 are below 1. */
+		a = _mm256_loadu_si256((const __m256i *)(s + i));
+		b = _mm256_loadu_si256((const __m256i *)(s + i + 16));
+		ok = _mm256_and_si256(
+		    _mm256_and_si256(_mm256_cmpgt_epi16(a, _mm256_setzero_si256()),
+		    _mm256_cmpgt_epi16(_mm256_set1_epi16(0x80), a)),
+		    _mm256_and_si256(_mm256_cmpgt_epi16(b, _mm256_setzero_si256()),
+		    _mm256_cmpgt_epi16(_mm256_set1_epi16(0x80), b)));
+		if (_mm256_movemask_epi8(ok) != -1)
+			break;
+		/* The packing works on each 128 bits lane: put them in order. */
+		if (d != NULL)
+			_mm256_storeu_si256((__m256i *)(d + i),
+			    _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8));
+	}
+#elif defined(__SSE2__)
+	for (; i + 16 <= len; i += 16) {
+		__m128i a, b, ok;
+
+		/* Units are compared as signed: those from U+8000 are below 1. */
+		a = _mm_loadu_si128((const __m128i *)(s + i));
+		b = _mm_loadu_si128((const __m128i *)(s + i + 8));
+		ok = _mm_and_si128(
+		    _mm_and_si128(_mm_cmpgt_epi16(a, _mm_setzero_si128()),
+		    _mm_cmplt_epi16(a, _mm_set1_epi16(0x80))),
+		    _mm_and_si128(_mm_cmpgt_epi16(b, _mm_setzero_si128()),
+		    _mm_cmplt_epi16(b, _mm_set1_epi16(0x80))));
+		if (_mm_movemask_epi8(ok) != 0xffff)
+			break;
+		if (d != NULL)
+			_mm_storeu_si128((__m128i *)(d + i), _mm_packus_epi16(a, b));
+	}
+#else
+	for (; i < len; i++) {
+		if ((s[i] == 0) || (s[i] >= 0x80))
+			break;
+		if (d != NULL)
+			d[i] = (char)s[i];
+	}
+#endif
+
+	return i;
+}
+
+/**
+ * Decodes the UTF-8 sequence at "s[*i]", which is not ASCII, and moves "*i"
+ * past it.
+ *
+ * @return The code point or JYUTF_REPLACEMENT for an invalid sequence, which
+ * only moves "*i" past its first byte.
+ */
+static unsigned int
+jyutf_decode(const unsigned char *s, size_t len, size_t *i)
+{
+	unsigned int c, min;
+	size_t n, k;
+
+	c = s[*i];
+	if ((c & 0xe0) == 0xc0) {
+		n = 1;
+		c &= 0x1f;
+		min = 0x80;
+	} else if ((c & 0xf0) == 0xe0) {
+		n = 2;
+		c &= 0x0f;
+		min = 0x800;
+	} else if ((c & 0xf8) == 0xf0) {
+		n = 3;
+		c &= 0x07;
+		min = 0x10000;
+	} else {
+		(*i)++;
+		return JYUTF_REPLACEMENT;
+	}
+
+	if (len - *i <= n) {
+		(*i)++;
+		return JYUTF_REPLACEMENT;
+	}
+	for (k = 1; k <= n; k++) {
+		if ((s[*i + k] & 0xc0) != 0x80) {
+			(*i)++;
+			return JYUTF_REPLACEMENT;
+		}
+		c = (c << 6) | (s[*i + k] & 0x3f);
+	}
+
+	/* "C0 80" is the U+0000 of modified UTF-8. */
+	if (((c < min) && !((n == 1) && (c == 0))) || (c > 0x10ffff)) {
+		(*i)++;
+		return JYUTF_REPLACEMENT;
+	}
+
+	*i += n + 1;
+
+	return c;
+}
+
+/**
+ * Converts the UTF-8 string "s" of "len" bytes to UTF-16.
+ *
+ * @param d Where the UTF-16 code units will be written. It must hold "len"
+ * units, the most a string of "len" bytes may need.
+ *
+ * @return The number of code units written.
+ */
+size_t
+jyutf_8to16(const char *str, size_t len, jchar *d)
+{
+	const unsigned char *s;
+	unsigned int c;
+	size_t i, j, n, end;
+
+	s = (const unsigned char *)str;
+	i = j = 0;
+	while (i < len) {
+		n = jyutf_widen_ascii(s + i, len - i, d + j);
+		i += n;
+		j += n;
+
+		/* A vector worth of bytes, with the first non ASCII one. */
+		end = len - i > JYUTF_VECTOR ? i + JYUTF_VECTOR : len;
+		while (i < end) {
+			if (s[i] < 0x80) {
+				d[j++] = s[i++];
+				continue;
+			}
+			c = jyutf_decode(s, len, &i);
+			if (c >= 0x10000) {
+				c -= 0x10000;
+				d[j++] = (jchar)(0xd800 | (c >> 10));
+				d[j++] = (jchar)(0xdc00 | (c & 0x3ff));
+			} else
+				d[j++] = (jchar)c;
+		}
+	}
+
+	return j;
+}
+
+/**
+ * Gets the size in bytes of the UTF-16 string "s" of "len" code units
+ * converted to UTF-8, not counting any terminating '\0'.
+ */
+size_t
+jyutf_16to8_len(const jchar *s, size_t len)
+{
+	size_t i, n, size;
+	jchar c;
+
+	size = 0;
+	for (i = 0; i < len; i++) {
+		/* Whole vectors of ASCII characters, then one without. */
+		if ((i & (JYUTF_VECTOR - 1)) == 0) {
+			n = jyutf_narrow_ascii(s + i, len - i, NULL);
+			size += n;
+			i += n;
+			if (i == len)
+				break;
+		}
+
+		c = s[i];
+		if ((c > 0) && (c < 0x80))
+			size++;
+		else if (c < 0x800)
+			size += 2;
+		else if ((c >= 0xd800) && (c < 0xdc00) && (i + 1 < len) &&
+		    (s[i + 1] >= 0xdc00) && (s[i + 1] < 0xe000)) {
+			size += 4;
+			i++;
+		} else
+			size += 3;
+	}
+
+	return size;
+}
+
+/**
+ * Converts the UTF-16 string "s" of "len" code units to UTF-8.
+ *
+ * @param d Where the UTF-8 string will be written, without a terminating
+ * '\0'. It must hold jyutf_16to8_len() bytes.
+ *
+ * @return The number of bytes written.
+ */
+size_t
+jyutf_16to8(const jchar *s, size_t len, char *str)
+{
+	unsigned char *d;
+	unsigned int c;
+	size_t i, j, n, end;
+
+	d = (unsigned char *)str;
+	i = j = 0;
+	while (i < len) {
+		n = jyutf_narrow_ascii(s + i, len - i, (char *)d + j);
+		i += n;
+		j += n;
+
+		/* A vector worth of code units, with the first other one. */
+		end = len - i > JYUTF_VECTOR ? i + JYUTF_VECTOR : len;
+		while (i < end) {
+			c = s[i++];
+			if ((c > 0) && (c < 0x80)) {
+				d[j++] = (unsigned char)c;
+			} else if (c < 0x800) {
+				d[j++] = (unsigned char)(0xc0 | (c >> 6));
+				d[j++] = (unsigned char)(0x80 | (c & 0x3f));
+			} else if ((c >= 0xd800) && (c < 0xdc00) && (i < len) &&
+			    (s[i] >= 0xdc00) && (s[i] < 0xe000)) {
+				c = 0x10000 + ((c - 0xd800) << 10) + (s[i++] - 0xdc00);
+				d[j++] = (unsigned char)(0xf0 | (c >> 18));
+				d[j++] = (unsigned char)(0x80 | ((c >> 12) & 0x3f));
+				d[j++] = (unsigned char)(0x80 | ((c >> 6) & 0x3f));
+				d[j++] = (unsigned char)(0x80 | (c & 0x3f));
+			} else {
+				d[j++] = (unsigned char)(0xe0 | (c >> 12));
+				d[j++] = (unsigned char)(0x80 | ((c >> 6) & 0x3f));
+				d[j++] = (unsigned char)(0x80 | (c & 0x3f));
+			}
+		}
+	}
+
+	return j;
+}
+
+/**
+ * Creates a Java String from the UTF-8 string "s" of "len" bytes.
+ *
+ * @param jstr Where the new local reference will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int
+jyutf_new_string(JNIEnv *jenv, const char *s, size_t len, jstring *jstr)
+{
+	jchar stack[JYUTF_STACK_UNITS], *d;
+	size_t n;
+
+	JY_ASSERT_RETURN(jenv != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(s != NULL, JY_EEINVAL);
+	JY_ASSERT_RETURN(jstr != NULL, JY_EEINVAL);
+
+	*jstr = NULL;
+
+	if (len > (size_t)INT32_MAX)
+		return JY_EEINVAL;
+
+	if (len <= JYUTF_STACK_UNITS)
+		d = stack;
+	else {
+		d = malloc(len * sizeof(jchar));
+		if (d == NULL)
+			return JY_EENOMEM;
+	}
+
+	n = jyutf_8to16(s, len, d);
+	*jstr = (*jenv)->NewString(jenv, d, (jsize)n);
+
+	if (d != stack)
+		free(d);
+
+	if (*jstr == NULL) {
+		(*jenv)->ExceptionClear(jenv);
+		return JY_EENOMEM;
+	}
+
+	return JY_ESUCCESS;
+}
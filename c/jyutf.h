@@ -0,0 +1,87 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(_JYUTF_H_)
+#define _JYUTF_H_
+
+#include <stddef.h>
+
+#include <jni.h>
+
+/*
+ * Transcoding between the UTF-8 strings of the C side and the UTF-16 strings
+ * of Java, without the modified UTF-8 of "NewStringUTF()" and
+ * "GetStringUTFChars()".
+ *
+ * Runs of ASCII characters are converted with SSE2 or AVX2 instructions when
+ * built for them and 8 bytes at a time otherwise.
+ *
+ * Invalid UTF-8 sequences become U+FFFD, one per byte. Surrogates encoded on
+ * their own, as in modified UTF-8, are accepted. Both directions keep the
+ * strings free of NUL bytes: U+0000 is encoded as "C0 80", as Java does, and
+ * unpaired surrogates are encoded on their own.
+ */
+
+/**
+ * Converts the UTF-8 string "s" of "len" bytes to UTF-16.
+ *
+ * @param d Where the UTF-16 code units will be written. It must hold "len"
+ * units, the most a string of "len" bytes may need.
+ *
+ * @return The number of code units written.
+ */
+size_t jyutf_8to16(const char *s, size_t len, jchar *d);
+
+/**
+ * Gets the size in bytes of the UTF-16 string "s" of "len" code units
+ * converted to UTF-8, not counting any terminating '\0'.
+ */
+size_t jyutf_16to8_len(const jchar *s, size_t len);
+
+/**
+ * Converts the UTF-16 string "s" of "len" code units to UTF-8.
+ *
+ * @param d Where the UTF-8 string will be written, without a terminating
+ * '\0'. It must hold jyutf_16to8_len() bytes.
+ *
+ * @return The number of bytes written.
+ */
+size_t jyutf_16to8(const jchar *s, size_t len, char *d);
+
+/**
+ * Creates a Java String from the UTF-8 string "s" of "len" bytes.
+ *
+ * @param jstr Where the new local reference will be returned.
+ *
+ * @return A "e_jy_err" error code.
+ */
+int jyutf_new_string(JNIEnv *jenv, const char *s, size_t len, jstring *jstr);
+
+#endif /* !defined(_JYUTF_H_) */
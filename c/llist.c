@@ -30,6 +30,7 @@
 
 #include <malloc.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "llist.h"
 
@@ -72,6 +73,7 @@ llprepend(void **base_v, void *item_v)
 		(*base)->prev = item;
 		item->next = *base;
 		item->prev = NULL;
+		*base = item;
 	}
 }
 
@@ -130,3 +132,253 @@ lldestroy(void **base_v)
 	while (*base)
 		lldel((void **)base, *base);
 }
+
+void
+llh_init(struct st_llhead *h)
+{
+	assert(h != NULL);
+
+	h->first = h->last = NULL;
+	h->len = 0;
+}
+
+void
+llh_append(struct st_llhead *h, void *item_v)
+{
+	struct st_llist *item = item_v;
+
+	assert(h != NULL);
+	assert(item != NULL);
+
+	item->next = NULL;
+	item->prev = h->last;
+	if (h->last)
+		h->last->next = item;
+	else
+		h->first = item;
+	h->last = item;
+	h->len++;
+}
+
+void
+llh_prepend(struct st_llhead *h, void *item_v)
+{
+	struct st_llist *item = item_v;
+
+	assert(h != NULL);
+	assert(item != NULL);
+
+	item->prev = NULL;
+	item->next = h->first;
+	if (h->first)
+		h->first->prev = item;
+	else
+		h->last = item;
+	h->first = item;
+	h->len++;
+}
+
+void
+llh_cut(struct st_llhead *h, void *item_v)
+{
+	struct st_llist *item = item_v;
+
+	assert(h != NULL);
+	assert(item != NULL);
+	assert(h->len > 0);
+
+	if (item->prev)
+		item->prev->next = item->next;
+	else
+		h->first = item->next;
+	if (item->next)
+		item->next->prev = item->prev;
+	else
+		h->last = item->prev;
+
+	item->prev = item->next = NULL;
+	h->len--;
+}
+
+void
+llh_splice(struct st_llhead *h, struct st_llhead *from)
+{
+	assert(h != NULL);
+	assert(from != NULL);
+
+	if (!from->first)
+		return;
+
+	if (h->last) {
+		h->last->next = from->first;
+		from->first->prev = h->last;
+	} else
+		h->first = from->first;
+	h->last = from->last;
+	h->len += from->len;
+
+	llh_init(from);
+}
+
+void
+llh_destroy(struct st_llhead *h, size_t size)
+{
+	struct st_llist *item;
+
+	assert(h != NULL);
+
+	while (h->first) {
+		item = h->first;
+		h->first = item->next;
+		llfree(item, size);
+	}
+	llh_init(h);
+}
+
+/*
+ * Node recycling.
+ *
+ * Each thread keeps its own free lists, one per size class, so recycling
+ * takes no lock. They are released when the thread exits.
+ */
+
+/** Granularity of the size classes. */
+#define LLCACHE_ALIGN 16
+/** Number of size classes: nodes larger than this are never recycled. */
+#define LLCACHE_CLASSES 16
+/** Default number of nodes kept per size class and thread. */
+#define LLCACHE_DEFAULT_LIMIT 256
+
+struct st_llcache {
+	struct st_llist *free[LLCACHE_CLASSES];
+	unsigned int count[LLCACHE_CLASSES];
+};
+
+static pthread_key_t g_llcache_key;
+static pthread_once_t g_llcache_once = PTHREAD_ONCE_INIT;
+static volatile unsigned int g_llcache_limit = LLCACHE_DEFAULT_LIMIT;
+
+static void
+llcache_destroy(void *cache_v)
+{
+	struct st_llcache *cache = cache_v;
+	struct st_llist *item;
+	int i;
+
+	for (i = 0; i < LLCACHE_CLASSES; i++) {
+		while (cache->free[i]) {
+			item = cache->free[i];
+			cache->free[i] = item->next;
+			free(item);
+		}
+	}
+	free(cache);
+}
+
+static void
+llcache_init(void)
+{
+	(void)pthread_key_create(&g_llcache_key, llcache_destroy);
+}
+
+static struct st_llcache *
+llcache_get(void)
+{
+	struct st_llcache *cache;
+
+	(void)pthread_once(&g_llcache_once, llcache_init);
+
+	cache = pthread_getspecific(g_llcache_key);
+	if (!cache) {
+		cache = calloc(1, sizeof(struct st_llcache));
+		if (!cache)
+			return NULL;
+		if (pthread_setspecific(g_llcache_key, cache) != 0) {
+			free(cache);
+			return NULL;
+		}
+	}
+
+	return cache;
+}
+
+void *
+llalloc(size_t size)
+{
+	struct st_llcache *cache;
+	struct st_llist *item;
+	size_t c;
+
+	assert(size >= sizeof(struct st_llist));
+
+	c = (size - 1) / LLCACHE_ALIGN;
+	if (c >= LLCACHE_CLASSES)
+		return malloc(size);
+
+	/* Nodes are always allocated with the size of their class, since the
+	 * limit may be raised before they are freed into the cache. */
+	if (g_llcache_limit == 0)
+		return malloc((c + 1) * LLCACHE_ALIGN);
+
+	cache = llcache_get();
+	if (!cache || !cache->free[c])
+		return malloc((c + 1) * LLCACHE_ALIGN);
+
+	item = cache->free[c];
+	cache->free[c] = item->next;
+	cache->count[c]--;
+
+	return item;
+}
+
+void
+llfree(void *item_v, size_t size)
+{
+	struct st_llcache *cache;
+	struct st_llist *item = item_v;
+	size_t c;
+
+	if (!item)
+		return;
+
+	c = (size - 1) / LLCACHE_ALIGN;
+	if ((c >= LLCACHE_CLASSES) || (g_llcache_limit == 0)) {
+		free(item);
+		return;
+	}
+
+	cache = llcache_get();
+	if (!cache || (cache->count[c] >= g_llcache_limit)) {
+		free(item);
+		return;
+	}
+
+	item->next = cache->free[c];
+	cache->free[c] = item;
+	cache->count[c]++;
+}
+
+void
+llcache_limit(unsigned int n)
+{
+	struct st_llcache *cache;
+	struct st_llist *item;
+	int i;
+
+	g_llcache_limit = n;
+
+	/* Only the cache of the calling thread can be trimmed here. */
+	(void)pthread_once(&g_llcache_once, llcache_init);
+	cache = pthread_getspecific(g_llcache_key);
+	if (!cache)
+		return;
+
+	for (i = 0; i < LLCACHE_CLASSES; i++) {
+		while (cache->count[i] > n) {
+			item = cache->free[i];
+			cache->free[i] = item->next;
+			cache->count[i]--;
+			free(item);
+		}
+	}
+}
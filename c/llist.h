@@ -31,6 +31,8 @@
 #if !defined(_LLIST_H_)
 #define _LLIST_H_
 
+#include <stddef.h>
+
 struct st_llist {
 	struct st_llist *next;
 	struct st_llist *prev;
@@ -42,4 +44,56 @@ void llcut(void **base_v, void *item_v);
 void lldel(void **base_v, void *item_v);
 void lldestroy(void **base_v);
 
+/**
+ * List head tracking the last node and the length of a list, so appending,
+ * prepending, cutting and splicing are O(1). The nodes are NULL terminated
+ * as in the lists handled by the functions above.
+ */
+struct st_llhead {
+	struct st_llist *first;
+	struct st_llist *last;
+	size_t len;
+};
+
+#define LLHEAD_INITIALIZER { NULL, NULL, 0 }
+
+void llh_init(struct st_llhead *h);
+void llh_append(struct st_llhead *h, void *item_v);
+void llh_prepend(struct st_llhead *h, void *item_v);
+void llh_cut(struct st_llhead *h, void *item_v);
+
+/**
+ * Moves every node of "from" to the end of "h", leaving "from" empty.
+ */
+void llh_splice(struct st_llhead *h, struct st_llhead *from);
+
+/**
+ * Frees every node of "h" with llfree(), leaving it empty.
+ *
+ * @param size The size of the nodes, as passed to llalloc().
+ */
+void llh_destroy(struct st_llhead *h, size_t size);
+
+/**
+ * Allocates a list node of "size" bytes, reusing one recycled by llfree() in
+ * the calling thread if there is any.
+ */
+void *llalloc(size_t size);
+
+/**
+ * Recycles a node allocated by llalloc() into the free list of the calling
+ * thread, or frees it if that list is full.
+ *
+ * @param size The size passed to llalloc().
+ */
+void llfree(void *item_v, size_t size);
+
+/**
+ * Sets how many nodes of each size each thread keeps for reuse. 0 disables
+ * recycling. The nodes the calling thread keeps beyond the new limit are
+ * freed. The other threads keep theirs until they exit, reusing them meanwhile
+ * unless recycling is disabled.
+ */
+void llcache_limit(unsigned int n);
+
 #endif /* !defined(_LLIST_H_) */
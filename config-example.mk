@@ -1,4 +1,4 @@
 # config.mk
 
-# JDK directory
-JAVADIR=	/usr/lib/jvm/java-6-sun
+# JDK directory (7 or later)
+JAVADIR=	/usr/lib/jvm/java-7-openjdk
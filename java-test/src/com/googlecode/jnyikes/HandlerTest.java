@@ -0,0 +1,85 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+package com.googlecode.jnyikes;
+
+import java.nio.ByteBuffer;
+
+import com.googlecode.jnyikes.test.BlobPojo;
+
+/**
+ * Sends POJOs holding a ByteBuffer through JNyIkes.j2n() and checks they
+ * reach the handler registered for their class, whichever separator its name
+ * was registered with. It lives in the package of JNyIkes to reach its
+ * test natives.
+ */
+public class HandlerTest {
+	private static int send(ByteBuffer data) {
+		BlobPojo o = new BlobPojo();
+
+		o.data(data);
+		return JNyIkes.j2n(o);
+	}
+
+	/**
+	 * Runs the sends. The library must be loaded.
+	 *
+	 * @return Zero, or the number of the send that failed.
+	 */
+	public static int run() {
+		String dotted = BlobPojo.class.getName();
+		String[] names = { dotted, dotted.replace('.', '/') };
+		int n = 0;
+
+		for (String name : names) {
+			if (JNyIkes.sizeHandler(name, "data") != 0)
+				return n + 1;
+
+			/* Copied by the native side. */
+			if (send(ByteBuffer.allocate(5)) != 5)
+				return n + 2;
+
+			/* Borrowed by the native side. */
+			if (send(ByteBuffer.allocateDirect(7)) != 7)
+				return n + 3;
+
+			if (JNyIkes.sizeHandler(name, null) != 0)
+				return n + 4;
+
+			/* No handler anymore. */
+			if (send(ByteBuffer.allocate(1)) >= 0)
+				return n + 5;
+
+			n += 5;
+		}
+
+		return 0;
+	}
+}
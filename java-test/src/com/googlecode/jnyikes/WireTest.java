@@ -0,0 +1,122 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+package com.googlecode.jnyikes;
+
+import java.nio.ByteBuffer;
+import java.util.Arrays;
+import java.util.Objects;
+
+import com.googlecode.jnyikes.test.WirePojo;
+
+/**
+ * Round trip of a POJO through both wire codecs: encoded by Wire, decoded and
+ * encoded again by the native side, and rebuilt by Wire. It lives in the
+ * package of Wire to reach its encoder.
+ */
+public class WireTest {
+	private static WirePojo sample(WirePojo child) {
+		WirePojo o = new WirePojo();
+
+		o.flag(true);
+		o.b((byte)-5);
+		/* The native side keeps chars in a C "char". */
+		o.c('z');
+		o.s((short)-300);
+		o.i(Integer.MIN_VALUE);
+		o.l(Long.MAX_VALUE);
+		o.f(1.25f);
+		o.d(-0.1);
+		o.str("h\u00e9llo \u2713");
+		o.bytes(new byte[] { 0, -1, 127 });
+		/* Empty arrays are not null. */
+		o.shorts(new short[0]);
+		o.ints(new int[] { 1, -2, Integer.MAX_VALUE });
+		o.longs(new long[] { Long.MIN_VALUE, 0 });
+		o.floats(new float[] { -1.5f, Float.MAX_VALUE });
+		o.doubles(new double[] { Double.MIN_VALUE, 3.0 });
+		o.child(child);
+		return o;
+	}
+
+	private static boolean same(WirePojo a, WirePojo b) {
+		if ((a == null) || (b == null))
+			return a == b;
+
+		return (a.flag() == b.flag()) && (a.b() == b.b()) &&
+		    (a.c() == b.c()) && (a.s() == b.s()) && (a.i() == b.i()) &&
+		    (a.l() == b.l()) &&
+		    (Float.compare(a.f(), b.f()) == 0) &&
+		    (Double.compare(a.d(), b.d()) == 0) &&
+		    Objects.equals(a.str(), b.str()) &&
+		    Arrays.equals(a.bytes(), b.bytes()) &&
+		    Arrays.equals(a.shorts(), b.shorts()) &&
+		    Arrays.equals(a.ints(), b.ints()) &&
+		    Arrays.equals(a.longs(), b.longs()) &&
+		    Arrays.equals(a.floats(), b.floats()) &&
+		    Arrays.equals(a.doubles(), b.doubles()) &&
+		    same(a.child(), b.child());
+	}
+
+	/**
+	 * Runs the round trips. The library must be loaded.
+	 *
+	 * @return Zero, or the number of the round trip that failed.
+	 */
+	public static int run() throws Throwable {
+		WirePojo[] pojos = {
+			/* Every property null or zero. */
+			new WirePojo(),
+			/* Nested objects, the innermost with null properties. */
+			sample(sample(new WirePojo())),
+		};
+		int n = 0;
+
+		for (WirePojo o : pojos) {
+			ByteBuffer b = Wire.encode(o);
+
+			n++;
+			if (b == null)
+				return n;
+
+			/* Java alone. */
+			ByteBuffer copy = b.duplicate();
+			copy.flip();
+			if (!same(o, (WirePojo)Wire.decode(copy)))
+				return n;
+
+			/* Through the native side. */
+			if (!same(o, (WirePojo)JNyIkes.wireEcho(b, b.position())))
+				return n;
+		}
+
+		return 0;
+	}
+}
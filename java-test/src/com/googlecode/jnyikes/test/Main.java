@@ -30,10 +30,12 @@
 
 package com.googlecode.jnyikes.test;
 
+import com.googlecode.jnyikes.HandlerTest;
 import com.googlecode.jnyikes.JNyIkes;
+import com.googlecode.jnyikes.WireTest;
 
 public class Main {
-	public static void main(String args[]) {
+	public static void main(String args[]) throws Throwable {
 		String func = "com.googlecode.jnyikes.test.Main";
 
 		int ret;
@@ -42,6 +44,18 @@ public class Main {
 		JNyIkes.load();
 		System.out.println(";");
 
+		System.out.print(func + ": WireTest.run()");
+		ret = WireTest.run();
+		System.out.println(" = " + ret + ";");
+		if (ret != 0)
+			System.exit(1);
+
+		System.out.print(func + ": HandlerTest.run()");
+		ret = HandlerTest.run();
+		System.out.println(" = " + ret + ";");
+		if (ret != 0)
+			System.exit(1);
+
 		/*
 		System.out.print(func + ": JNyIkes.sendString(\"test\")");
 		ret = JNyIkes.sendString("test");
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+package com.googlecode.jnyikes.test;
+
+/**
+ * POJO holding a property of every type the wire format carries from Java.
+ *
+ * Each getter has a setter of the same name, since the properties are named
+ * after their getters.
+ */
+public class WirePojo {
+	private boolean flag;
+	private byte b;
+	private char c;
+	private short s;
+	private int i;
+	private long l;
+	private float f;
+	private double d;
+	private String str;
+	private byte[] bytes;
+	private short[] shorts;
+	private int[] ints;
+	private long[] longs;
+	private float[] floats;
+	private double[] doubles;
+	private WirePojo child;
+
+	public WirePojo() {
+	}
+
+	public boolean flag() {
+		return flag;
+	}
+
+	public void flag(boolean v) {
+		flag = v;
+	}
+
+	public byte b() {
+		return b;
+	}
+
+	public void b(byte v) {
+		b = v;
+	}
+
+	public char c() {
+		return c;
+	}
+
+	public void c(char v) {
+		c = v;
+	}
+
+	public short s() {
+		return s;
+	}
+
+	public void s(short v) {
+		s = v;
+	}
+
+	public int i() {
+		return i;
+	}
+
+	public void i(int v) {
+		i = v;
+	}
+
+	public long l() {
+		return l;
+	}
+
+	public void l(long v) {
+		l = v;
+	}
+
+	public float f() {
+		return f;
+	}
+
+	public void f(float v) {
+		f = v;
+	}
+
+	public double d() {
+		return d;
+	}
+
+	public void d(double v) {
+		d = v;
+	}
+
+	public String str() {
+		return str;
+	}
+
+	public void str(String v) {
+		str = v;
+	}
+
+	public byte[] bytes() {
+		return bytes;
+	}
+
+	public void bytes(byte[] v) {
+		bytes = v;
+	}
+
+	public short[] shorts() {
+		return shorts;
+	}
+
+	public void shorts(short[] v) {
+		shorts = v;
+	}
+
+	public int[] ints() {
+		return ints;
+	}
+
+	public void ints(int[] v) {
+		ints = v;
+	}
+
+	public long[] longs() {
+		return longs;
+	}
+
+	public void longs(long[] v) {
+		longs = v;
+	}
+
+	public float[] floats() {
+		return floats;
+	}
+
+	public void floats(float[] v) {
+		floats = v;
+	}
+
+	public double[] doubles() {
+		return doubles;
+	}
+
+	public void doubles(double[] v) {
+		doubles = v;
+	}
+
+	public WirePojo child() {
+		return child;
+	}
+
+	public void child(WirePojo v) {
+		child = v;
+	}
+}
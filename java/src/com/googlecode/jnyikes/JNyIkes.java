@@ -30,13 +30,129 @@
 
 package com.googlecode.jnyikes;
 
+import java.nio.ByteBuffer;
+
 public class JNyIkes {
+	/* Error codes, from "enum e_jy_err". */
+	private static final int EEINVAL = -3;
+	private static final int EEXCEPTION = -8;
+	private static final int ESTALE = -9;
+
 	/**
-	 * Send a POJO to the native side.
+	 * Send a POJO to the native side. The POJO is encoded in Java into a
+	 * buffer of the calling thread, which crosses to the native side in a
+	 * single call, reading the getters the class options select. POJOs
+	 * holding a ByteBuffer are converted by the native side, one getter at
+	 * a time. The native side hands the POJO to the
+	 * handler registered for its class with jyh_register().
 	 *
 	 * @param o The POJO.
+	 *
+	 * @return What the handler returned, or a negative value if the POJO
+	 * could not be sent or no handler took it.
+	 */
+	public static int j2n(Object o) {
+		ByteBuffer b;
+		int generation, ret;
+
+		if (o == null)
+			return EEINVAL;
+
+		/* The class options changed while encoding: list the getters
+		 * again. */
+		do {
+			try {
+				b = Wire.encode(o);
+			} catch (Error e) {
+				throw e;
+			} catch (Throwable t) {
+				t.printStackTrace();
+				return EEXCEPTION;
+			}
+
+			if (b == null)
+				return j2nObject(o);
+			generation = Wire.generation();
+			ret = j2nWire(b, b.position(), generation);
+			if (ret == ESTALE)
+				Wire.refresh(generation);
+		} while (ret == ESTALE);
+
+		return ret;
+	}
+
+	/**
+	 * Send a POJO encoded by Wire to the native side.
+	 *
+	 * @param b The direct buffer holding the POJO.
+	 * @param size The size of the POJO.
+	 * @param generation The generation of the class options the getters
+	 * were listed for.
+	 *
+	 * @return ESTALE if the class options changed since.
+	 */
+	native private static int j2nWire(ByteBuffer b, int size, int generation);
+
+	/**
+	 * Send a POJO to the native side, which calls its getters.
+	 *
+	 * @param o The POJO.
+	 */
+	native private static int j2nObject(Object o);
+
+	/**
+	 * Lists the getters, or the public fields, the native side reads from
+	 * the objects of a class, as selected by its class options.
+	 *
+	 * @param c The class.
+	 * @param fields If the fields are wanted instead of the getters.
+	 *
+	 * @return The names, or null if the class can't be described.
+	 */
+	native static String[] getters(Class<?> c, boolean fields);
+
+	/**
+	 * Gets the generation of the class options, which changes whenever
+	 * getters() may list other getters.
+	 */
+	native static int generation();
+
+	/**
+	 * Decodes a POJO encoded by Wire on the native side, which encodes it
+	 * again for Wire to rebuild it. Used to check both sides agree on the
+	 * wire format.
+	 *
+	 * @param b The direct buffer holding the POJO.
+	 * @param size The size of the POJO.
+	 *
+	 * @return The rebuilt POJO, or null if the native side refused it.
+	 */
+	native static Object wireEcho(ByteBuffer b, int size);
+
+	/**
+	 * Registers on the native side a handler returning the size of a
+	 * ByteBuffer property of the POJOs of a class. Used to check POJOs
+	 * reach the handler of their class.
+	 *
+	 * @param clazz The class name.
+	 * @param getter The getter of the property, or null to unregister the
+	 * handler.
+	 *
+	 * @return Zero or a negative value if it could not be registered.
+	 */
+	native static int sizeHandler(String clazz, String getter);
+
+	/**
+	 * Give back a buffer of native memory received in a POJO. The memory
+	 * is released once the native side is done with it too, so the buffer
+	 * must not be used afterwards.
+	 *
+	 * @param b The buffer.
+	 *
+	 * @return Zero or a negative value if the buffer is not native memory
+	 * or was already given back.
 	 */
-	native public static int j2n(Object o);
+	native public static int release(ByteBuffer b);
 
 	public static void load() {
 		System.loadLibrary("jnyikes");
@@ -0,0 +1,785 @@
+/*
+ * Copyright 2005-2014 Fernando Silveira <fsilveira@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *      This product includes software developed by Fernando Silveira.
+ * 4. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+package com.googlecode.jnyikes;
+
+import java.lang.invoke.MethodHandle;
+import java.lang.invoke.MethodHandles;
+import java.lang.invoke.MethodType;
+import java.lang.reflect.Field;
+import java.lang.reflect.Method;
+import java.lang.reflect.Modifier;
+import java.nio.BufferOverflowException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.IdentityHashMap;
+import java.util.concurrent.ConcurrentHashMap;
+
+/**
+ * Encoder and decoder of the POJOs exchanged with the native side in the wire
+ * format of jyo_wire_encode(). A whole tree of objects crosses in one call,
+ * with method handles cached per class, instead of a JNI call per property.
+ *
+ * Decoded objects are made with their public no argument constructor and set
+ * with their public setters, or else their public fields. Encoded objects are
+ * read with the getters and fields jyo_j2p() would read, as selected by the
+ * class options of jyc_set_flags() and jyc_set_getters(), which the native
+ * side lists once per class.
+ */
+public final class Wire {
+	/* The types of the values, from "enum e_jyo_type". */
+	private static final int TSTRING = 1;
+	private static final int TINT = 2;
+	private static final int TDOUBLE = 4;
+	private static final int TFLOAT = 5;
+	private static final int TLONG = 6;
+	private static final int TBOOLEAN = 8;
+	private static final int TBYTE = 9;
+	private static final int TCHAR = 10;
+	private static final int TSHORT = 11;
+	private static final int TVOID = 12;
+	private static final int TJYO = 13;
+	private static final int TBYTEARRAY = 15;
+	private static final int TSHORTARRAY = 16;
+	private static final int TINTARRAY = 17;
+	private static final int TLONGARRAY = 18;
+	private static final int TFLOATARRAY = 19;
+	private static final int TDOUBLEARRAY = 20;
+	private static final int TBLOB = 21;
+	private static final int TMAX = TBLOB + 1;
+
+	/** Deepest nesting of objects the native side decodes. */
+	private static final int MAX_DEPTH = 256;
+
+	/** Initial size of the buffer of a thread. */
+	private static final int MIN_SIZE = 4096;
+
+	private static final MethodHandles.Lookup LOOKUP = MethodHandles.publicLookup();
+	private static final MethodType CONSTRUCTOR = MethodType.methodType(Object.class);
+	private static final MethodType SETTER = MethodType.methodType(void.class, Object.class, Object.class);
+	private static final MethodType VOID_SETTER = MethodType.methodType(void.class, Object.class);
+	private static final MethodType GETTER = MethodType.methodType(Object.class, Object.class);
+
+	/**
+	 * The constructor and the setters of a class, found on first use.
+	 */
+	private static final class Shape {
+		final Class<?> clazz;
+		final MethodHandle constructor;
+		/** The setters by name, then by type of value. */
+		final ConcurrentHashMap<String, MethodHandle[]> setters =
+		    new ConcurrentHashMap<String, MethodHandle[]>();
+		/** The setters of objects, by name and class of value. */
+		final ConcurrentHashMap<String, MethodHandle> objectSetters =
+		    new ConcurrentHashMap<String, MethodHandle>();
+
+		Shape(Class<?> clazz) throws ReflectiveOperationException {
+			this.clazz = clazz;
+			this.constructor = LOOKUP.findConstructor(clazz,
+			    MethodType.methodType(void.class)).asType(CONSTRUCTOR);
+		}
+
+		MethodHandle setter(String name, int type, Object value)
+		    throws ReflectiveOperationException {
+			MethodHandle[] byType;
+			MethodHandle h;
+			String key;
+
+			if (type == TJYO) {
+				key = value == null ? name :
+				    name + '\000' + value.getClass().getName();
+				h = objectSetters.get(key);
+				if (h == null) {
+					h = resolve(clazz, name, type,
+					    value == null ? null : value.getClass());
+					objectSetters.put(key, h);
+				}
+				return h;
+			}
+
+			byType = setters.get(name);
+			if (byType == null) {
+				byType = new MethodHandle[TMAX];
+				MethodHandle[] old = setters.putIfAbsent(name, byType);
+				if (old != null)
+					byType = old;
+			}
+			/* Racing threads resolve the same handle. */
+			h = byType[type];
+			if (h == null) {
+				h = resolve(clazz, name, type, null);
+				byType[type] = h;
+			}
+			return h;
+		}
+	}
+
+	/**
+	 * A getter of a class, typed to take an Object and return its
+	 * primitive type, or else an Object.
+	 */
+	private static final class Getter {
+		final String name;
+		final int type;
+		final MethodHandle handle;
+
+		Getter(String name, int type, MethodHandle handle) {
+			this.name = name;
+			this.type = type;
+			this.handle = handle;
+		}
+	}
+
+	/**
+	 * The getters of a class, found on first use.
+	 */
+	private static final class Accessors {
+		/** The class name, as the native side writes it. */
+		final String name;
+		final Getter[] getters;
+		/**
+		 * If the objects are sent by j2nObject instead: some getter
+		 * returns a ByteBuffer, or a type that is not encoded, or the
+		 * native side could not list the getters.
+		 */
+		final boolean direct;
+
+		Accessors(Class<?> c) throws ReflectiveOperationException {
+			ArrayList<Getter> list = new ArrayList<Getter>();
+			String[] methods = JNyIkes.getters(c, false);
+			String[] fields = JNyIkes.getters(c, true);
+			boolean unsupported = (methods == null) || (fields == null);
+
+			/* The getter methods go before the fields, as in jyo_j2p(). */
+			for (int i = 0; !unsupported && (i < methods.length); i++) {
+				Method m = c.getMethod(methods[i]);
+
+				/* Getters of classes that are not public. */
+				if (!m.isAccessible())
+					m.setAccessible(true);
+				unsupported = !add(list, methods[i], m.getReturnType(),
+				    LOOKUP.unreflect(m));
+			}
+			for (int i = 0; !unsupported && (i < fields.length); i++) {
+				Field f = c.getField(fields[i]);
+
+				if (!f.isAccessible())
+					f.setAccessible(true);
+				unsupported = !add(list, fields[i], f.getType(),
+				    LOOKUP.unreflectGetter(f));
+			}
+
+			this.name = c.getName().replace('.', '/').intern();
+			this.getters = list.toArray(new Getter[list.size()]);
+			this.direct = unsupported;
+		}
+
+		/**
+		 * Adds the getter "h" of values of class "ret", or returns
+		 * false if they are not encoded.
+		 */
+		private static boolean add(ArrayList<Getter> list, String name,
+		    Class<?> ret, MethodHandle h) {
+			int type = typeOf(ret);
+
+			if ((type <= 0) || (type == TBLOB))
+				return false;
+			list.add(new Getter(name.intern(), type,
+			    h.asType(ret.isPrimitive() ?
+			    MethodType.methodType(ret, Object.class) : GETTER)));
+			return true;
+		}
+	}
+
+	/**
+	 * The accessors of the classes, as selected by the class options of
+	 * a jyc_generation().
+	 */
+	private static final class Policy {
+		final int generation;
+		final ClassValue<Accessors> accessors = new ClassValue<Accessors>() {
+			@Override
+			protected Accessors computeValue(Class<?> c) {
+				try {
+					return new Accessors(c);
+				} catch (ReflectiveOperationException e) {
+					throw new IllegalArgumentException(e);
+				}
+			}
+		};
+
+		Policy(int generation) {
+			this.generation = generation;
+		}
+	}
+
+	/**
+	 * Gets the type of the values of class "c", or 0 if it is not a
+	 * property.
+	 */
+	private static int typeOf(Class<?> c) {
+		if (c == boolean.class)
+			return TBOOLEAN;
+		if (c == byte.class)
+			return TBYTE;
+		if (c == char.class)
+			return TCHAR;
+		if (c == short.class)
+			return TSHORT;
+		if (c == int.class)
+			return TINT;
+		if (c == long.class)
+			return TLONG;
+		if (c == float.class)
+			return TFLOAT;
+		if (c == double.class)
+			return TDOUBLE;
+		if (c == String.class)
+			return TSTRING;
+		if (c == byte[].class)
+			return TBYTEARRAY;
+		if (c == short[].class)
+			return TSHORTARRAY;
+		if (c == int[].class)
+			return TINTARRAY;
+		if (c == long[].class)
+			return TLONGARRAY;
+		if (c == float[].class)
+			return TFLOATARRAY;
+		if (c == double[].class)
+			return TDOUBLEARRAY;
+		if (c == ByteBuffer.class)
+			return TBLOB;
+		/* Arrays of other types are not properties. */
+		if (c.isArray() || c.isPrimitive())
+			return 0;
+		return TJYO;
+	}
+
+	/** The current policy, or null until the first encode(). */
+	private static volatile Policy policy;
+
+	/**
+	 * Gets the current policy. The generation is taken before any getter
+	 * is listed, so getters listed for newer options are just rebuilt.
+	 */
+	private static Policy policy() {
+		Policy p = policy;
+
+		if (p != null)
+			return p;
+		synchronized (Wire.class) {
+			if (policy == null)
+				policy = new Policy(JNyIkes.generation());
+			return policy;
+		}
+	}
+
+	/**
+	 * The buffer of a thread and the names of the message being encoded.
+	 */
+	private static final class Encoder {
+		ByteBuffer b = ByteBuffer.allocateDirect(MIN_SIZE).order(ByteOrder.LITTLE_ENDIAN);
+		/** The names defined so far, by identity: they are interned. */
+		final IdentityHashMap<String, Integer> names = new IdentityHashMap<String, Integer>();
+		int depth;
+		/** The policy of the message being encoded. */
+		Policy policy;
+
+		ByteBuffer encode(Object o) throws Throwable {
+			policy = policy();
+			for (;;) {
+				b.clear();
+				names.clear();
+				depth = 0;
+				try {
+					return writeObject(o) ? b : null;
+				} catch (BufferOverflowException e) {
+					b = ByteBuffer.allocateDirect(b.capacity() * 2).order(ByteOrder.LITTLE_ENDIAN);
+				}
+			}
+		}
+
+		private void writeVarint(long v) {
+			while ((v & ~0x7fL) != 0) {
+				b.put((byte)((v & 0x7f) | 0x80));
+				v >>>= 7;
+			}
+			b.put((byte)v);
+		}
+
+		private void writeZigzag(long v) {
+			writeVarint((v << 1) ^ (v >> 63));
+		}
+
+		private void writeName(String name) {
+			Integer i = names.get(name);
+
+			if (i != null) {
+				writeVarint(i + 1);
+				return;
+			}
+
+			names.put(name, names.size());
+			byte[] bytes = name.getBytes(StandardCharsets.UTF_8);
+			writeVarint(0);
+			writeVarint(bytes.length);
+			b.put(bytes);
+		}
+
+		/**
+		 * Writes the varint length plus 1 of an array, or 0 for null,
+		 * and returns if it is not null.
+		 */
+		private boolean writeLength(Object a, int len) {
+			writeVarint(a != null ? len + 1L : 0);
+			return a != null;
+		}
+
+		/**
+		 * Writes an object, or returns false if it must be sent by
+		 * j2nObject.
+		 */
+		private boolean writeObject(Object o) throws Throwable {
+			Accessors a = policy.accessors.get(o.getClass());
+
+			if (a.direct)
+				return false;
+			if (++depth > MAX_DEPTH)
+				throw new IllegalArgumentException("Objects nested too deep: " + a.name);
+
+			writeName(a.name);
+			writeVarint(a.getters.length);
+			for (Getter g : a.getters) {
+				writeName(g.name);
+				b.put((byte)g.type);
+				if (!writeValue(o, g))
+					return false;
+			}
+
+			depth--;
+			return true;
+		}
+
+		private boolean writeValue(Object o, Getter g) throws Throwable {
+			MethodHandle h = g.handle;
+			Object v;
+
+			switch (g.type) {
+			case TBOOLEAN:
+				b.put((byte)((boolean)h.invokeExact(o) ? 1 : 0));
+				return true;
+			case TBYTE:
+				b.put((byte)h.invokeExact(o));
+				return true;
+			case TCHAR:
+				writeVarint((char)h.invokeExact(o));
+				return true;
+			case TSHORT:
+				writeZigzag((short)h.invokeExact(o));
+				return true;
+			case TINT:
+				writeZigzag((int)h.invokeExact(o));
+				return true;
+			case TLONG:
+				writeZigzag((long)h.invokeExact(o));
+				return true;
+			case TFLOAT:
+				b.putFloat((float)h.invokeExact(o));
+				return true;
+			case TDOUBLE:
+				b.putDouble((double)h.invokeExact(o));
+				return true;
+			}
+
+			v = (Object)h.invokeExact(o);
+
+			/* The views take the byte order of the buffer. */
+			switch (g.type) {
+			case TJYO:
+				if (v == null) {
+					b.put((byte)0);
+					return true;
+				}
+				b.put((byte)1);
+				return writeObject(v);
+			case TSTRING: {
+				byte[] s = v != null ? ((String)v).getBytes(StandardCharsets.UTF_8) : null;
+				if (writeLength(s, s != null ? s.length : 0))
+					b.put(s);
+				return true;
+			}
+			case TBYTEARRAY: {
+				byte[] a = (byte[])v;
+				if (writeLength(a, a != null ? a.length : 0))
+					b.put(a);
+				return true;
+			}
+			case TSHORTARRAY: {
+				short[] a = (short[])v;
+				if (writeLength(a, a != null ? a.length : 0)) {
+					b.asShortBuffer().put(a);
+					b.position(b.position() + a.length * 2);
+				}
+				return true;
+			}
+			case TINTARRAY: {
+				int[] a = (int[])v;
+				if (writeLength(a, a != null ? a.length : 0)) {
+					b.asIntBuffer().put(a);
+					b.position(b.position() + a.length * 4);
+				}
+				return true;
+			}
+			case TLONGARRAY: {
+				long[] a = (long[])v;
+				if (writeLength(a, a != null ? a.length : 0)) {
+					b.asLongBuffer().put(a);
+					b.position(b.position() + a.length * 8);
+				}
+				return true;
+			}
+			case TFLOATARRAY: {
+				float[] a = (float[])v;
+				if (writeLength(a, a != null ? a.length : 0)) {
+					b.asFloatBuffer().put(a);
+					b.position(b.position() + a.length * 4);
+				}
+				return true;
+			}
+			case TDOUBLEARRAY: {
+				double[] a = (double[])v;
+				if (writeLength(a, a != null ? a.length : 0)) {
+					b.asDoubleBuffer().put(a);
+					b.position(b.position() + a.length * 8);
+				}
+				return true;
+			}
+			default:
+				throw new IllegalArgumentException("Unknown type " + g.type);
+			}
+		}
+	}
+
+	private static final ThreadLocal<Encoder> encoders = new ThreadLocal<Encoder>() {
+		@Override
+		protected Encoder initialValue() {
+			return new Encoder();
+		}
+	};
+
+	/** The shapes by class name, as written by the native side. */
+	private static final ConcurrentHashMap<String, Shape> shapes =
+	    new ConcurrentHashMap<String, Shape>();
+
+	private final ByteBuffer b;
+	/** The names defined so far in the message. */
+	private final ArrayList<String> names = new ArrayList<String>();
+	private byte[] scratch = new byte[64];
+
+	private Wire(ByteBuffer b) {
+		this.b = b;
+	}
+
+	/**
+	 * Rebuilds the POJO encoded in a buffer. The buffer belongs to the
+	 * native side and must not be kept.
+	 *
+	 * @param b The encoded POJO.
+	 *
+	 * @return The POJO.
+	 */
+	public static Object decode(ByteBuffer b) throws Throwable {
+		return new Wire(b.order(ByteOrder.LITTLE_ENDIAN)).readObject();
+	}
+
+	/**
+	 * Encodes a POJO for jyo_wire_decode() into the buffer of the calling
+	 * thread, which is reused by the next call.
+	 *
+	 * @param o The POJO.
+	 *
+	 * @return The buffer, the message ending at its position, or null if
+	 * the POJO must be sent by j2nObject, like the ones holding a
+	 * ByteBuffer.
+	 */
+	static ByteBuffer encode(Object o) throws Throwable {
+		return encoders.get().encode(o);
+	}
+
+	/**
+	 * Gets the jyc_generation() of the class options the last encode() of
+	 * the calling thread followed.
+	 */
+	static int generation() {
+		return encoders.get().policy.generation;
+	}
+
+	/**
+	 * Drops the getters listed for the class options of a generation, once
+	 * the native side told they are stale.
+	 *
+	 * @param generation The generation of the stale getters.
+	 */
+	static void refresh(int generation) {
+		synchronized (Wire.class) {
+			if ((policy != null) && (policy.generation == generation))
+				policy = null;
+		}
+	}
+
+	private static Shape shape(String name) throws ReflectiveOperationException {
+		Shape s;
+
+		s = shapes.get(name);
+		if (s == null) {
+			s = new Shape(Class.forName(name.replace('/', '.'), true,
+			    Wire.class.getClassLoader()));
+			shapes.putIfAbsent(name, s);
+		}
+		return s;
+	}
+
+	/**
+	 * Checks if a setter parameter or a field of class "p" accepts a value
+	 * of type "type", of class "vclass" for objects.
+	 */
+	private static boolean accepts(Class<?> p, int type, Class<?> vclass) {
+		switch (type) {
+		case TBOOLEAN:
+			return p == boolean.class;
+		case TBYTE:
+			return p == byte.class;
+		case TCHAR:
+			return p == char.class;
+		case TSHORT:
+			return p == short.class;
+		case TINT:
+			return p == int.class;
+		case TLONG:
+			return p == long.class;
+		case TFLOAT:
+			return p == float.class;
+		case TDOUBLE:
+			return p == double.class;
+		case TSTRING:
+			return p == String.class;
+		case TBYTEARRAY:
+			return p == byte[].class;
+		case TSHORTARRAY:
+			return p == short[].class;
+		case TINTARRAY:
+			return p == int[].class;
+		case TLONGARRAY:
+			return p == long[].class;
+		case TFLOATARRAY:
+			return p == float[].class;
+		case TDOUBLEARRAY:
+			return p == double[].class;
+		case TJYO:
+			return !p.isPrimitive() &&
+			    ((vclass == null) || p.isAssignableFrom(vclass));
+		default:
+			return false;
+		}
+	}
+
+	/**
+	 * Finds the setter "name" accepting "type" with a "void" return, or
+	 * else with a "boolean" return, or else the field "name".
+	 */
+	private static MethodHandle resolve(Class<?> c, String name, int type, Class<?> vclass)
+	    throws ReflectiveOperationException {
+		Method best = null;
+
+		for (Method m : c.getMethods()) {
+			Class<?>[] params = m.getParameterTypes();
+			Class<?> ret = m.getReturnType();
+
+			if (!m.getName().equals(name) ||
+			    Modifier.isStatic(m.getModifiers()) ||
+			    ((ret != void.class) && (ret != boolean.class)))
+				continue;
+			if (type == TVOID ? params.length != 0 :
+			    (params.length != 1) || !accepts(params[0], type, vclass))
+				continue;
+			if ((best == null) || (ret == void.class))
+				best = m;
+		}
+
+		if (best != null)
+			return LOOKUP.unreflect(best).asType(type == TVOID ? VOID_SETTER : SETTER);
+
+		Field f = c.getField(name);
+		if ((type == TVOID) || Modifier.isStatic(f.getModifiers()) ||
+		    !accepts(f.getType(), type, vclass))
+			throw new NoSuchFieldException(c.getName() + "." + name);
+		return LOOKUP.unreflectSetter(f).asType(SETTER);
+	}
+
+	private long readVarint() {
+		long v = 0;
+		int shift = 0;
+		byte x;
+
+		do {
+			x = b.get();
+			v |= (long)(x & 0x7f) << shift;
+			shift += 7;
+		} while (x < 0);
+		return v;
+	}
+
+	private long readZigzag() {
+		long v = readVarint();
+
+		return (v >>> 1) ^ -(v & 1);
+	}
+
+	/**
+	 * Reads the varint length plus 1 of a string or an array, or 0 for
+	 * null, and returns the length or -1.
+	 */
+	private int readLength() {
+		return (int)readVarint() - 1;
+	}
+
+	private String readString(int len) {
+		if (len > scratch.length)
+			scratch = new byte[Math.max(len, scratch.length * 2)];
+		b.get(scratch, 0, len);
+		return new String(scratch, 0, len, StandardCharsets.UTF_8);
+	}
+
+	private String readName() {
+		int i = (int)readVarint();
+
+		if (i > 0)
+			return names.get(i - 1);
+
+		String name = readString((int)readVarint());
+		names.add(name);
+		return name;
+	}
+
+	private Object readValue(int type) throws Throwable {
+		int len;
+
+		switch (type) {
+		case TBOOLEAN:
+			return b.get() != 0;
+		case TBYTE:
+			return b.get();
+		case TCHAR:
+			return (char)readVarint();
+		case TSHORT:
+			return (short)readZigzag();
+		case TINT:
+			return (int)readZigzag();
+		case TLONG:
+			return readZigzag();
+		case TFLOAT:
+			return b.getFloat();
+		case TDOUBLE:
+			return b.getDouble();
+		case TJYO:
+			return b.get() != 0 ? readObject() : null;
+		}
+
+		len = readLength();
+		if (len < 0)
+			return null;
+
+		/* The views take the byte order of the buffer. */
+		switch (type) {
+		case TSTRING:
+			return readString(len);
+		case TBYTEARRAY: {
+			byte[] a = new byte[len];
+			b.get(a);
+			return a;
+		}
+		case TSHORTARRAY: {
+			short[] a = new short[len];
+			b.asShortBuffer().get(a);
+			b.position(b.position() + len * 2);
+			return a;
+		}
+		case TINTARRAY: {
+			int[] a = new int[len];
+			b.asIntBuffer().get(a);
+			b.position(b.position() + len * 4);
+			return a;
+		}
+		case TLONGARRAY: {
+			long[] a = new long[len];
+			b.asLongBuffer().get(a);
+			b.position(b.position() + len * 8);
+			return a;
+		}
+		case TFLOATARRAY: {
+			float[] a = new float[len];
+			b.asFloatBuffer().get(a);
+			b.position(b.position() + len * 4);
+			return a;
+		}
+		case TDOUBLEARRAY: {
+			double[] a = new double[len];
+			b.asDoubleBuffer().get(a);
+			b.position(b.position() + len * 8);
+			return a;
+		}
+		default:
+			throw new IllegalArgumentException("Unknown type " + type);
+		}
+	}
+
+	private Object readObject() throws Throwable {
+		Shape s = shape(readName());
+		Object o = (Object)s.constructor.invokeExact();
+		int n = (int)readVarint();
+
+		for (int i = 0; i < n; i++) {
+			String name = readName();
+			int type = b.get() & 0xff;
+
+			if (type == TVOID) {
+				s.setter(name, type, null).invokeExact(o);
+				continue;
+			}
+
+			Object value = readValue(type);
+			s.setter(name, type, value).invokeExact(o, value);
+		}
+		return o;
+	}
+}